@@ -3,8 +3,8 @@
 #include "../sequencer/Sequencer.h"
 #include "../sequencer/Transport.h"
 #include "../sequencer/Pattern.h"
+#include "../core/Logger.h"
 #include <RtAudio.h>
-#include <iostream>
 #include <cstring>
 #include <vector>
 #include <algorithm>
@@ -21,11 +21,14 @@ public:
 };
 
 AudioEngine::AudioEngine(uint32_t sampleRate)
-    : sampleRate_(sampleRate), isRunning_(false), sequencer_(nullptr), 
-      totalFramesProcessed_(0), lastStep_(0xFFFFFFFF)
+    : sampleRate_(sampleRate), isRunning_(false), outputLatencyFrames_(0), sequencer_(nullptr), 
+      totalFramesProcessed_(0)
 {
+    // Stereo-sized so multi-channel samples cannot overrun the scratch buffer
+    mixBuffer_.resize(MAX_BLOCK_FRAMES * 2);
     // Initialize all sample player pointers to nullptr
     samplePlayers_.fill(nullptr);
+    voices_.fill({1.0f, 1.0f, 1.0f, 1.0f, 0.0f});
     rtAudio_ = std::make_unique<RtAudioWrapper>();
 }
 
@@ -37,27 +40,27 @@ AudioEngine::~AudioEngine()
 bool AudioEngine::initialize()
 {
     if (isRunning_) {
-        std::cerr << "Audio engine already running" << std::endl;
+        LOG_ERROR("Audio engine already running");
         return false;
     }
 
     // Get available devices
     std::vector<unsigned int> devices = rtAudio_->rtAudio.getDeviceIds();
     if (devices.empty()) {
-        std::cerr << "No audio devices found" << std::endl;
+        LOG_ERROR("No audio devices found");
         return false;
     }
 
     // List all available output devices
-    std::cout << "\n=== Available Audio Output Devices ===" << std::endl;
+    LOG_INFO("=== Available Audio Output Devices ===");
     for (const auto& id : devices) {
         RtAudio::DeviceInfo info = rtAudio_->rtAudio.getDeviceInfo(id);
         if (info.outputChannels > 0) {
-            std::string isDefault = (id == rtAudio_->rtAudio.getDefaultOutputDevice()) ? " [DEFAULT]" : "";
-            std::cout << "  Device " << id << ": " << info.name << " (" << info.outputChannels << " channels)" << isDefault << std::endl;
+            const char* isDefault = (id == rtAudio_->rtAudio.getDefaultOutputDevice()) ? " [DEFAULT]" : "";
+            LOG_INFO("  Device %u: %s (%u channels)%s", id, info.name.c_str(), info.outputChannels, isDefault);
         }
     }
-    std::cout << "====================================\n" << std::endl;
+    LOG_INFO("====================================");
 
     // Try to use Speakers instead of USB device if available
     unsigned int deviceId = rtAudio_->rtAudio.getDefaultOutputDevice();
@@ -73,15 +76,15 @@ bool AudioEngine::initialize()
                 && name.find("USB") == std::string::npos) {
                 deviceId = id;
                 deviceInfo = info;
-                std::cout << "[AUDIO] Selected Speaker device instead of USB: " << deviceInfo.name << std::endl;
+                LOG_INFO("[AUDIO] Selected Speaker device instead of USB: %s", deviceInfo.name.c_str());
                 break;
             }
         }
     }
 
-    std::cout << "Using audio device: " << deviceInfo.name << std::endl;
-    std::cout << "Channels: " << deviceInfo.outputChannels << std::endl;
-    std::cout << "Sample rate: " << sampleRate_ << " Hz" << std::endl;
+    LOG_INFO("Using audio device: %s", deviceInfo.name.c_str());
+    LOG_INFO("Channels: %u", deviceInfo.outputChannels);
+    LOG_INFO("Sample rate: %u Hz", sampleRate_);
 
     // Setup audio parameters
     rt::audio::RtAudio::StreamParameters parameters;
@@ -107,9 +110,10 @@ bool AudioEngine::initialize()
 
     // Start stream
     rtAudio_->rtAudio.startStream();
+    outputLatencyFrames_ = bufferFrames + static_cast<uint32_t>(rtAudio_->rtAudio.getStreamLatency());
 
     isRunning_ = true;
-    std::cout << "Audio engine initialized successfully" << std::endl;
+    LOG_INFO("Audio engine initialized successfully");
     return true;
 }
 
@@ -124,7 +128,7 @@ void AudioEngine::shutdown()
         rtAudio_->rtAudio.closeStream();
     }
     isRunning_ = false;
-    std::cout << "Audio engine shutdown" << std::endl;
+    LOG_INFO("Audio engine shutdown");
 }
 
 bool AudioEngine::isRunning() const
@@ -157,68 +161,141 @@ SamplePlayer* AudioEngine::getSamplePlayer(int trackIndex) const
     return nullptr;
 }
 
+void AudioEngine::renderOffline(float* outputBuffer, uint32_t nFrames)
+{
+    // Same path as the device callback, so a bounce sounds identical
+    processAudio(outputBuffer, nFrames);
+}
+
 int AudioEngine::processAudio(void* outputBuffer, unsigned int nFrames)
 {
     float* buffer = static_cast<float*>(outputBuffer);
-    
+
+    // Split oversized callbacks so scratch buffers never need to grow
+    uint32_t done = 0;
+    while (done < nFrames) {
+        uint32_t chunk = std::min<uint32_t>(nFrames - done, MAX_BLOCK_FRAMES);
+        renderBlock(buffer + done * 2, chunk);
+        done += chunk;
+    }
+
+    // Update frame counter (atomic, lock-free)
+    totalFramesProcessed_.fetch_add(nFrames, std::memory_order_release);
+
+    return 0; // Success
+}
+
+void AudioEngine::renderBlock(float* buffer, uint32_t nFrames)
+{
     // Zero out buffer first (stereo: 2 channels per frame)
     std::memset(buffer, 0, nFrames * 2 * sizeof(float));
 
-    // Advance sequencer and check for step triggers
+    // Collect sample-accurate triggers (including swing) for this block
     if (sequencer_) {
-        sequencer_->advanceFrame(nFrames);
-        
-        // Check if transport is playing
-        bool isTransportPlaying = (sequencer_->getTransport().getPlayState() == Transport::PlayState::Playing);
-        
-        if (isTransportPlaying) {
-            // Get current step position from transport
-            uint32_t currentStep = sequencer_->getTransport().getCurrentStep();
-            
-            // Only trigger when step changes (not every buffer)
-            if (currentStep != lastStep_) {
-                lastStep_ = currentStep;
-                
-                // For each track, check if the current step is active and trigger if needed
-                Pattern& pattern = sequencer_->getPattern();
-                for (int track = 0; track < NUM_TRACKS; ++track) {
-                    if (samplePlayers_[track] && pattern.isStepActive(track, currentStep)) {
-                        samplePlayers_[track]->trigger();
-                    }
-                }
-            }
-        }
+        sequencer_->process(nFrames, triggers_);
+    } else {
+        triggers_.clear();
     }
 
     // Mix audio from all 8 sample players
     // Each track is mixed into the stereo output with equal gain
     // Increased gain: 3.0 / 8 = 0.375 per track (gives ~1.5 overall with 4 tracks)
     const float trackGain = 3.0f / NUM_TRACKS;
-    std::vector<float> monoBuffer(nFrames);
 
     for (int track = 0; track < NUM_TRACKS; ++track) {
-        if (samplePlayers_[track] && samplePlayers_[track]->isPlaying()) {
-            // Clear mono buffer before reading (important for proper mixing)
-            std::memset(monoBuffer.data(), 0, nFrames * sizeof(float));
-            
-            // Read mono samples from this track (no looping - samples play once and stop)
-            uint32_t framesRead = samplePlayers_[track]->readFrames(monoBuffer.data(), nFrames, false);
-            
-            if (framesRead > 0) {
-                // Mix into stereo output (both channels get the same mono signal)
-                for (uint32_t i = 0; i < nFrames; ++i) {
-                    float sample = monoBuffer[i] * trackGain;
-                    buffer[i * 2] += sample;      // Left channel
-                    buffer[i * 2 + 1] += sample;  // Right channel
-                }
+        SamplePlayer* player = samplePlayers_[track];
+        if (!player) {
+            continue;
+        }
+
+        // Render up to each trigger, restart the sample there, and carry on.
+        // Triggers are sorted by frame offset.
+        uint32_t cursor = 0;
+        for (uint32_t i = 0; i < triggers_.size(); ++i) {
+            const TriggerEvent& trigger = triggers_[i];
+            if (trigger.trackIndex != static_cast<uint32_t>(track)) {
+                continue;
             }
+            mixTrack(player, buffer, cursor, trigger.frameOffset - cursor, trackGain, voices_[track]);
+            startVoice(player, trigger, voices_[track], track);
+            cursor = trigger.frameOffset;
         }
+        mixTrack(player, buffer, cursor, nFrames - cursor, trackGain, voices_[track]);
     }
+}
 
-    // Update frame counter (atomic, lock-free)
-    totalFramesProcessed_.fetch_add(nFrames, std::memory_order_release);
+void AudioEngine::startVoice(SamplePlayer* player, const TriggerEvent& trigger, Voice& voice, uint32_t track)
+{
+    voice = {kitMap_.gainFor(track, trigger.velocity), 1.0f, 1.0f, 1.0f, 0.0f};
+    const StepLocks& locks = trigger.locks;
+    if (!locks.any()) {
+        player->trigger();
+        return;
+    }
 
-    return 0; // Success
+    // Resolve the locks once, into the voice's start state
+    if (locks.has(StepLocks::VOLUME)) {
+        voice.gain *= locks.volume / 127.0f;
+    }
+    if (locks.has(StepLocks::PAN) && locks.pan != 0) {
+        // Constant power, scaled so the centre matches an unpanned voice. Each
+        // side is normalised on its own, so -64 and 63 reach the hard edges
+        // while a centred lock keeps unity gains and the plain mix path.
+        constexpr float QUARTER_TURN = 1.5707963f;
+        constexpr float SQRT_2 = 1.4142136f;
+        const float position = locks.pan < 0 ? locks.pan / 64.0f : locks.pan / 63.0f;
+        const float angle = (position + 1.0f) * 0.5f * QUARTER_TURN;
+        voice.left = std::cos(angle) * SQRT_2;
+        voice.right = std::sin(angle) * SQRT_2;
+    }
+    const double rate = locks.has(StepLocks::PITCH) ? std::exp2(locks.pitch / 12.0) : 1.0;
+    uint32_t startFrame = 0;
+    if (locks.has(StepLocks::SAMPLE_START)) {
+        startFrame = static_cast<uint32_t>(uint64_t(player->getFrameCount()) * locks.sampleStart / 128);
+    }
+    if (locks.has(StepLocks::DECAY) && locks.decay < 127) {
+        // Fade out over the lock's share of what is left to play
+        const double remaining = (player->getFrameCount() - startFrame) / rate;
+        const double fadeFrames = std::max(1.0, remaining * locks.decay / 127.0);
+        voice.envelopeStep = static_cast<float>(1.0 / fadeFrames);
+    }
+    player->trigger(startFrame, rate);
+}
+
+void AudioEngine::mixTrack(SamplePlayer* player, float* buffer, uint32_t startFrame,
+                           uint32_t numFrames, float gain, Voice& voice)
+{
+    if (numFrames == 0 || !player->isPlaying()) {
+        return;
+    }
+
+    // Read mono samples from this track (no looping - samples play once and stop)
+    uint32_t framesRead = player->readFrames(mixBuffer_.data(), numFrames, false);
+    float* out = buffer + startFrame * 2;
+    gain *= voice.gain;
+
+    // Mix into stereo output (both channels get the same mono signal)
+    if (voice.envelopeStep == 0.0f && voice.left == 1.0f && voice.right == 1.0f) {
+        for (uint32_t i = 0; i < framesRead; ++i) {
+            float sample = mixBuffer_[i] * gain;
+            out[i * 2] += sample;      // Left channel
+            out[i * 2 + 1] += sample;  // Right channel
+        }
+        return;
+    }
+
+    // Locked voice: panned, and faded by its decay envelope
+    float envelope = voice.envelope;
+    for (uint32_t i = 0; i < framesRead; ++i) {
+        float sample = mixBuffer_[i] * gain * envelope;
+        out[i * 2] += sample * voice.left;
+        out[i * 2 + 1] += sample * voice.right;
+        envelope = std::max(0.0f, envelope - voice.envelopeStep);
+    }
+    voice.envelope = envelope;
+    if (envelope == 0.0f) {
+        player->stop();
+    }
 }
 
 } // namespace DrumMachine
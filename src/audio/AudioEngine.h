@@ -6,6 +6,8 @@
 #include <vector>
 #include <atomic>
 #include <array>
+#include "../sequencer/TriggerQueue.h"
+#include "../sequencer/KitMap.h"
 
 namespace DrumMachine {
 
@@ -24,6 +26,7 @@ class SamplePlayer; // Forward declaration
 class AudioEngine {
 public:
     static constexpr int NUM_TRACKS = 8;
+    static constexpr uint32_t MAX_BLOCK_FRAMES = 4096; // Larger callbacks are split
 
     AudioEngine(uint32_t sampleRate = 44100);
     ~AudioEngine();
@@ -40,6 +43,10 @@ public:
     // Get sample rate
     uint32_t getSampleRate() const { return sampleRate_; }
 
+    // Frames between rendering a block and hearing it (callback buffer
+    // plus the device's reported latency)
+    uint32_t getOutputLatencyFrames() const { return outputLatencyFrames_; }
+
     // Get total frames processed (for timing verification)
     uint64_t getTotalFramesProcessed() const { return totalFramesProcessed_.load(); }
 
@@ -55,13 +62,34 @@ public:
     // Legacy: Set single sample player (for backwards compatibility)
     void setSamplePlayer(SamplePlayer* samplePlayer);
 
+    // Velocity curves of the kit (copied). Call before initialize().
+    void setKitMap(const KitMap& kitMap) { kitMap_ = kitMap; }
+
+    // Render interleaved stereo without an audio device (offline bounce).
+    // Must not be called while the device callback is running.
+    void renderOffline(float* outputBuffer, uint32_t nFrames);
+
 private:
     uint32_t sampleRate_;
     bool isRunning_;
+    uint32_t outputLatencyFrames_;
     Sequencer* sequencer_;
     std::array<SamplePlayer*, NUM_TRACKS> samplePlayers_;
     std::atomic<uint64_t> totalFramesProcessed_;
-    uint32_t lastStep_;  // Track last step to detect step changes
+    TriggerBuffer triggers_;         // Sample-accurate triggers for the current block
+    std::vector<float> mixBuffer_;   // Per-track scratch buffer (preallocated)
+    KitMap kitMap_;                  // Velocity -> gain per track
+
+    // Playback parameters of each track's voice, fixed when it starts
+    // from the trigger's velocity and parameter locks
+    struct Voice {
+        float gain;          // Velocity and volume lock
+        float left;          // Pan lock (1, 1 = centre, as without one)
+        float right;
+        float envelope;      // Decay lock fade (1 = full level)
+        float envelopeStep;  // Fade per frame, 0 without a decay lock
+    };
+    std::array<Voice, NUM_TRACKS> voices_;
     
     // RtAudio instance (forward declared, defined in .cpp)
     class RtAudioWrapper;
@@ -69,6 +97,16 @@ private:
 
     // Internal callback implementation
     int processAudio(void* outputBuffer, unsigned int nFrames);
+
+    // Render one block of at most MAX_BLOCK_FRAMES into interleaved stereo
+    void renderBlock(float* buffer, uint32_t nFrames);
+
+    // Restart a track's sample for a trigger, resolving its locks
+    void startVoice(SamplePlayer* player, const TriggerEvent& trigger, Voice& voice, uint32_t track);
+
+    // Mix a span of one track's sample player into the stereo buffer
+    void mixTrack(SamplePlayer* player, float* buffer, uint32_t startFrame, uint32_t numFrames,
+                  float gain, Voice& voice);
 };
 
 } // namespace DrumMachine
@@ -1,8 +1,11 @@
 #include "MidiManager.h"
 #include "../core/ParameterBus.h"
+#include "../core/HostClock.h"
+#include "../core/Logger.h"
 #include <RtMidi.h>
-#include <iostream>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
 namespace DrumMachine {
 
@@ -20,9 +23,12 @@ public:
 };
 
 MidiManager::MidiManager()
-    : isActive_(false), rtMidiIn_(std::make_unique<RtMidiWrapper>())
+    : isActive_(false), rtMidiIn_(std::make_unique<RtMidiWrapper>()), received_(0), midiClockSeconds_(0.0),
+      hostOffsetMicros_(0), lastOffsetUpdate_(0), hasHostOffset_(false)
 {
-    std::memset(controlValues_, 0, sizeof(controlValues_));
+    for (auto& value : controlValues_) {
+        value.store(0, std::memory_order_relaxed);
+    }
 }
 
 MidiManager::~MidiManager()
@@ -34,11 +40,12 @@ bool MidiManager::initialize()
 {
     try {
         rtMidiIn_->midiIn = new RtMidiIn();
-        std::cout << "MIDI Manager initialized. Found " 
-                  << rtMidiIn_->midiIn->getPortCount() << " input ports." << std::endl;
+        rtMidiIn_->midiIn->ignoreTypes(true, false, true);  // Keep timing messages for clock sync
+        rtMidiIn_->midiIn->setCallback(&MidiManager::onMidiInput, this);
+        LOG_INFO("MIDI Manager initialized. Found %u input ports.", rtMidiIn_->midiIn->getPortCount());
         return true;
     } catch (const RtMidiError& e) {
-        std::cerr << "MIDI Error: " << e.what() << std::endl;
+        LOG_ERROR("MIDI Error: %s", e.what());
         return false;
     }
 }
@@ -46,6 +53,7 @@ bool MidiManager::initialize()
 void MidiManager::shutdown()
 {
     if (rtMidiIn_ && rtMidiIn_->midiIn) {
+        rtMidiIn_->midiIn->cancelCallback();
         rtMidiIn_->midiIn->closePort();
         isActive_ = false;
     }
@@ -69,7 +77,7 @@ std::vector<std::string> MidiManager::getInputPorts() const
         try {
             ports.push_back(rtMidiIn_->midiIn->getPortName(i));
         } catch (const RtMidiError& e) {
-            std::cerr << "Error getting port name: " << e.what() << std::endl;
+            LOG_ERROR("Error getting port name: %s", e.what());
         }
     }
 
@@ -84,16 +92,16 @@ bool MidiManager::openPort(uint32_t portIndex)
         }
 
         if (portIndex >= rtMidiIn_->midiIn->getPortCount()) {
-            std::cerr << "Invalid MIDI port index: " << portIndex << std::endl;
+            LOG_ERROR("Invalid MIDI port index: %u", portIndex);
             return false;
         }
 
         rtMidiIn_->midiIn->openPort(portIndex);
         isActive_ = true;
-        std::cout << "Opened MIDI port: " << rtMidiIn_->midiIn->getPortName(portIndex) << std::endl;
+        LOG_INFO("Opened MIDI port: %s", rtMidiIn_->midiIn->getPortName(portIndex).c_str());
         return true;
     } catch (const RtMidiError& e) {
-        std::cerr << "MIDI Error: " << e.what() << std::endl;
+        LOG_ERROR("MIDI Error: %s", e.what());
         return false;
     }
 }
@@ -107,78 +115,97 @@ bool MidiManager::openVirtualPort(const std::string& portName)
 
         rtMidiIn_->midiIn->openVirtualPort(portName);
         isActive_ = true;
-        std::cout << "Opened virtual MIDI port: " << portName << std::endl;
+        LOG_INFO("Opened virtual MIDI port: %s", portName.c_str());
         return true;
     } catch (const RtMidiError& e) {
         // Virtual ports may not be supported on all platforms
-        std::cerr << "Virtual MIDI port not supported: " << e.what() << std::endl;
+        LOG_ERROR("Virtual MIDI port not supported: %s", e.what());
         return false;
     }
 }
 
-uint32_t MidiManager::processMessages()
+uint32_t MidiManager::takeReceivedCount()
 {
-    if (!isActive()) {
-        return 0;
-    }
-
-    uint32_t messagesProcessed = 0;
-
-    try {
-        std::vector<uint8_t> message;
-        double stamp = 0.0;
+    return received_.exchange(0, std::memory_order_relaxed);
+}
 
-        while (true) {
-            stamp = rtMidiIn_->midiIn->getMessage(&message);
-            if (message.empty()) {
-                break;
-            }
+void MidiManager::onMidiInput(double stamp, std::vector<unsigned char>* message, void* userData)
+{
+    if (message && !message->empty()) {
+        static_cast<MidiManager*>(userData)->handleMessage(stamp, *message);
+    }
+}
 
-            if (message.size() < 1) {
-                continue;
-            }
+void MidiManager::handleMessage(double stamp, const std::vector<unsigned char>& message)
+{
+    uint8_t status = message[0];
+    uint8_t type = status & 0xF0;
+    uint8_t channel = status & 0x0F;
+
+    midiClockSeconds_ += stamp;
+
+    MidiMessage midiMsg;
+    midiMsg.channel = channel;
+    midiMsg.timestamp = toHostMicros(std::llround(midiClockSeconds_ * 1000000.0), hostTimeMicros());
+
+    // Parse MIDI message
+    if (type == 0x90 && message.size() >= 3) {  // NOTE_ON
+        midiMsg.type = MidiMessage::Type::NOTE_ON;
+        midiMsg.note = message[1];
+        midiMsg.velocity = message[2];
+    } else if (type == 0x80 && message.size() >= 3) {  // NOTE_OFF
+        midiMsg.type = MidiMessage::Type::NOTE_OFF;
+        midiMsg.note = message[1];
+        midiMsg.velocity = message[2];
+    } else if (type == 0xB0 && message.size() >= 3) {  // CONTROL_CHANGE
+        midiMsg.type = MidiMessage::Type::CONTROL_CHANGE;
+        midiMsg.controller = message[1];
+        midiMsg.value = message[2];
+        if (midiMsg.controller < controlValues_.size()) {
+            controlValues_[midiMsg.controller].store(midiMsg.value, std::memory_order_relaxed);
+        }
+    } else if (type == 0xC0 && message.size() >= 2) {  // PROGRAM_CHANGE
+        midiMsg.type = MidiMessage::Type::PROGRAM_CHANGE;
+        midiMsg.value = message[1];
+    } else if (type == 0xE0 && message.size() >= 3) {  // PITCH_BEND
+        midiMsg.type = MidiMessage::Type::PITCH_BEND;
+        midiMsg.value = ((message[2] << 7) | message[1]) & 0x3FFF;
+    } else if (status == 0xF8) {
+        midiMsg.type = MidiMessage::Type::CLOCK;
+    } else if (status == 0xFA) {
+        midiMsg.type = MidiMessage::Type::START;
+    } else if (status == 0xFB) {
+        midiMsg.type = MidiMessage::Type::CONTINUE;
+    } else if (status == 0xFC) {
+        midiMsg.type = MidiMessage::Type::STOP;
+    } else if (status == 0xF2 && message.size() >= 3) {
+        midiMsg.type = MidiMessage::Type::SONG_POSITION;
+        midiMsg.position = static_cast<uint16_t>(((message[2] & 0x7F) << 7) | (message[1] & 0x7F));
+    } else {
+        midiMsg.type = MidiMessage::Type::UNKNOWN;
+    }
 
-            uint8_t status = message[0];
-            uint8_t type = status & 0xF0;
-            uint8_t channel = status & 0x0F;
-
-            MidiMessage midiMsg;
-            midiMsg.channel = channel;
-            midiMsg.timestamp = static_cast<uint64_t>(stamp * 1000000);  // Convert to microseconds
-
-            // Parse MIDI message
-            if (type == 0x90 && message.size() >= 3) {  // NOTE_ON
-                midiMsg.type = MidiMessage::Type::NOTE_ON;
-                midiMsg.note = message[1];
-                midiMsg.velocity = message[2];
-            } else if (type == 0x80 && message.size() >= 3) {  // NOTE_OFF
-                midiMsg.type = MidiMessage::Type::NOTE_OFF;
-                midiMsg.note = message[1];
-                midiMsg.velocity = message[2];
-            } else if (type == 0xB0 && message.size() >= 3) {  // CONTROL_CHANGE
-                midiMsg.type = MidiMessage::Type::CONTROL_CHANGE;
-                midiMsg.controller = message[1];
-                midiMsg.value = message[2];
-                controlValues_[midiMsg.controller] = midiMsg.value;
-            } else if (type == 0xC0 && message.size() >= 2) {  // PROGRAM_CHANGE
-                midiMsg.type = MidiMessage::Type::PROGRAM_CHANGE;
-                midiMsg.value = message[1];
-            } else if (type == 0xE0 && message.size() >= 3) {  // PITCH_BEND
-                midiMsg.type = MidiMessage::Type::PITCH_BEND;
-                midiMsg.value = ((message[2] << 7) | message[1]) & 0x3FFF;
-            } else {
-                midiMsg.type = MidiMessage::Type::UNKNOWN;
-            }
+    processMidiMessage(midiMsg);
+    received_.fetch_add(1, std::memory_order_relaxed);
+}
 
-            processMidiMessage(midiMsg);
-            messagesProcessed++;
-            message.clear();
-        }
-    } catch (const RtMidiError& e) {
-        std::cerr << "MIDI Error during message processing: " << e.what() << std::endl;
+uint64_t MidiManager::toHostMicros(int64_t midiMicros, uint64_t nowMicros)
+{
+    // A message can't arrive after we read it, so now - midiTime is an
+    // upper bound on the offset between the clocks. Follow the lowest
+    // bound seen, letting it rise by 100 ppm so drift between the clocks
+    // is absorbed instead of accumulating over a long session.
+    const int64_t bound = static_cast<int64_t>(nowMicros) - midiMicros;
+    if (!hasHostOffset_) {
+        hostOffsetMicros_ = bound;
+        hasHostOffset_ = true;
+    } else {
+        const int64_t relax = static_cast<int64_t>(nowMicros - lastOffsetUpdate_) / 10000;
+        hostOffsetMicros_ = std::min(hostOffsetMicros_ + relax, bound);
     }
+    lastOffsetUpdate_ = nowMicros;
 
-    return messagesProcessed;
+    return static_cast<uint64_t>(midiMicros + hostOffsetMicros_);
 }
 
 void MidiManager::setMidiCallback(MidiCallback callback)
@@ -188,8 +215,8 @@ void MidiManager::setMidiCallback(MidiCallback callback)
 
 uint8_t MidiManager::getControlValue(uint8_t controller) const
 {
-    if (controller < 120) {
-        return controlValues_[controller];
+    if (controller < controlValues_.size()) {
+        return controlValues_[controller].load(std::memory_order_relaxed);
     }
     return 0;
 }
@@ -202,8 +229,9 @@ void MidiManager::processMidiMessage(const MidiMessage& msg)
     }
 
     // Publish to ParameterBus
+    static const Symbol moduleId = Symbol::intern("midi_manager");
     ParameterChange change;
-    change.moduleId = "midi_manager";
+    change.moduleId = moduleId;
 
     switch (msg.type) {
         case MidiMessage::Type::NOTE_ON:
@@ -211,9 +239,7 @@ void MidiManager::processMidiMessage(const MidiMessage& msg)
             change.value = static_cast<uint32_t>(msg.note);
             change.trackIndex = msg.channel;
             ParameterBus::getInstance().publish(change);
-            std::cout << "MIDI NOTE_ON: Ch=" << static_cast<int>(msg.channel)
-                      << " Note=" << static_cast<int>(msg.note)
-                      << " Vel=" << static_cast<int>(msg.velocity) << std::endl;
+            LOG_DEBUG("MIDI NOTE_ON: Ch=%d Note=%d Vel=%d", msg.channel, msg.note, msg.velocity);
             break;
 
         case MidiMessage::Type::NOTE_OFF:
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <array>
+#include <atomic>
 
 namespace DrumMachine {
 
@@ -15,7 +17,10 @@ class ParameterBus;
  * MidiManager
  * 
  * Handles MIDI input from external controllers.
- * Runs on separate thread to avoid blocking audio.
+ * Uses RtMidi's callback mode: messages are parsed, timestamped and
+ * handed to the MIDI callback on RtMidi's input thread as they arrive,
+ * so pad latency never depends on how often the UI runs. The callback
+ * must only do lock-free work (e.g. queue the note for the audio thread).
  * Publishes MIDI events via ParameterBus for other modules.
  * 
  * Milestone 5: MIDI Foundation
@@ -28,6 +33,11 @@ struct MidiMessage {
         CONTROL_CHANGE,
         PROGRAM_CHANGE,
         PITCH_BEND,
+        CLOCK,          // 0xF8 timing clock, 24 per quarter note
+        START,
+        CONTINUE,
+        STOP,
+        SONG_POSITION,  // Position in `position`
         UNKNOWN
     };
 
@@ -37,7 +47,8 @@ struct MidiMessage {
     uint8_t velocity;     // 0-127 (for NOTE_ON/OFF)
     uint8_t controller;   // 0-119 (for CC)
     uint8_t value;        // 0-127 (for CC or pitch bend)
-    uint64_t timestamp;   // When message was received
+    uint16_t position;    // 16th notes from the song start (for SONG_POSITION)
+    uint64_t timestamp;   // Host time in microseconds (hostTimeMicros())
 };
 
 class MidiManager {
@@ -63,11 +74,11 @@ public:
     // Open virtual MIDI input (for software controllers)
     bool openVirtualPort(const std::string& portName = "Drum Machine Input");
 
-    // Process incoming MIDI messages
-    // Returns number of messages processed
-    uint32_t processMessages();
+    // Messages received since the last call (UI activity display)
+    uint32_t takeReceivedCount();
 
-    // Callback for MIDI note on
+    // Called on the MIDI input thread for every message. Set it before
+    // opening a port.
     using MidiCallback = std::function<void(const MidiMessage&)>;
     void setMidiCallback(MidiCallback callback);
 
@@ -80,7 +91,25 @@ private:
 
     bool isActive_;
     MidiCallback midiCallback_;
-    uint8_t controlValues_[120];  // CC value cache
+    std::array<std::atomic<uint8_t>, 120> controlValues_;  // CC value cache
+    std::atomic<uint32_t> received_;
+
+    // MIDI thread: RtMidi stamps are deltas on its own clock; they are
+    // summed into a timeline and mapped onto the host clock
+    double midiClockSeconds_;
+    int64_t hostOffsetMicros_;
+    uint64_t lastOffsetUpdate_;
+    bool hasHostOffset_;
+
+    // Host time of a message at `midiMicros` on the RtMidi timeline,
+    // received no later than `nowMicros`
+    uint64_t toHostMicros(int64_t midiMicros, uint64_t nowMicros);
+
+    // RtMidi input callback (MIDI thread)
+    static void onMidiInput(double stamp, std::vector<unsigned char>* message, void* userData);
+
+    // MIDI thread: parse one raw message
+    void handleMessage(double stamp, const std::vector<unsigned char>& message);
 
     // Process a single MIDI message
     void processMidiMessage(const MidiMessage& msg);
@@ -0,0 +1,263 @@
+#include "MidiOutput.h"
+#include "../sequencer/Sequencer.h"
+#include "../core/HostClock.h"
+#include "../core/Logger.h"
+#include <RtMidi.h>
+#include <chrono>
+#include <algorithm>
+#include <array>
+
+namespace DrumMachine {
+
+namespace {
+
+constexpr uint64_t SPIN_MICROS = 200;       // Busy-wait the last stretch for accuracy
+constexpr uint64_t MAX_SLEEP_MICROS = 1000;  // Poll interval while idle
+constexpr uint64_t MAX_LATE_MICROS = 20000;  // Later than this is dropped
+
+} // namespace
+
+// RtMidi wrapper to avoid exposing RtMidi.h in header
+class MidiOutput::RtMidiWrapper {
+public:
+    RtMidiWrapper() : midiOut(nullptr) {}
+    ~RtMidiWrapper() {
+        if (midiOut) {
+            delete midiOut;
+        }
+    }
+
+    RtMidiOut* midiOut;
+};
+
+MidiOutput::MidiOutput()
+    : rtMidiOut_(std::make_unique<RtMidiWrapper>()), sequencer_(nullptr), openPort_(-1), running_(false)
+{
+}
+
+MidiOutput::~MidiOutput()
+{
+    shutdown();
+}
+
+bool MidiOutput::initialize()
+{
+    try {
+        rtMidiOut_->midiOut = new RtMidiOut();
+        LOG_INFO("MIDI Output initialized. Found %u output ports.", rtMidiOut_->midiOut->getPortCount());
+        return true;
+    } catch (const RtMidiError& e) {
+        LOG_ERROR("MIDI Error: %s", e.what());
+        return false;
+    }
+}
+
+void MidiOutput::shutdown()
+{
+    stopSender();
+    if (rtMidiOut_ && rtMidiOut_->midiOut) {
+        rtMidiOut_->midiOut->closePort();
+    }
+    openPort_ = -1;
+    openPortName_.clear();
+}
+
+bool MidiOutput::isActive() const
+{
+    return running_.load(std::memory_order_relaxed);
+}
+
+std::vector<std::string> MidiOutput::getOutputPorts() const
+{
+    std::vector<std::string> ports;
+
+    if (!rtMidiOut_ || !rtMidiOut_->midiOut) {
+        return ports;
+    }
+
+    uint32_t portCount = rtMidiOut_->midiOut->getPortCount();
+    for (uint32_t i = 0; i < portCount; ++i) {
+        try {
+            ports.push_back(rtMidiOut_->midiOut->getPortName(i));
+        } catch (const RtMidiError& e) {
+            LOG_ERROR("Error getting port name: %s", e.what());
+        }
+    }
+
+    return ports;
+}
+
+bool MidiOutput::openPort(uint32_t portIndex)
+{
+    if (!rtMidiOut_ || !rtMidiOut_->midiOut) {
+        return false;
+    }
+
+    shutdown();
+    try {
+        if (portIndex >= rtMidiOut_->midiOut->getPortCount()) {
+            LOG_ERROR("Invalid MIDI output port index: %u", portIndex);
+            return false;
+        }
+
+        rtMidiOut_->midiOut->openPort(portIndex);
+        openPort_ = static_cast<int>(portIndex);
+        openPortName_ = rtMidiOut_->midiOut->getPortName(portIndex);
+        LOG_INFO("Opened MIDI output port: %s", openPortName_.c_str());
+    } catch (const RtMidiError& e) {
+        LOG_ERROR("MIDI Error: %s", e.what());
+        return false;
+    }
+
+    startSender();
+    return true;
+}
+
+bool MidiOutput::openVirtualPort(const std::string& portName)
+{
+    if (!rtMidiOut_ || !rtMidiOut_->midiOut) {
+        return false;
+    }
+
+    shutdown();
+    try {
+        rtMidiOut_->midiOut->openVirtualPort(portName);
+        openPortName_ = portName;
+        LOG_INFO("Opened virtual MIDI output port: %s", portName.c_str());
+    } catch (const RtMidiError& e) {
+        // Virtual ports may not be supported on all platforms
+        LOG_ERROR("Virtual MIDI port not supported: %s", e.what());
+        return false;
+    }
+
+    startSender();
+    return true;
+}
+
+void MidiOutput::startSender()
+{
+    if (!sequencer_ || running_.load()) {
+        return;
+    }
+    running_.store(true);
+    sender_ = std::thread(&MidiOutput::run, this);
+}
+
+void MidiOutput::stopSender()
+{
+    running_.store(false);
+    if (sender_.joinable()) {
+        sender_.join();
+    }
+}
+
+void MidiOutput::run()
+{
+    std::vector<unsigned char> bytes;
+    bytes.reserve(3);
+
+    // Messages waiting for their time, earliest first; the sequence number
+    // keeps messages stamped alike (e.g. Start and the first pulse) in
+    // the order they were queued
+    struct Waiting {
+        OutgoingMidi message;
+        uint64_t sequence;
+    };
+    auto later = [](const Waiting& a, const Waiting& b) {
+        return a.message.hostMicros != b.message.hostMicros ? a.message.hostMicros > b.message.hostMicros
+                                                            : a.sequence > b.sequence;
+    };
+    std::vector<Waiting> waiting;
+    waiting.reserve(1024);
+    uint64_t sequence = 0;
+
+    // Per channel and note: sounding, and note-offs to skip because the
+    // note was already released for a retrigger
+    std::array<uint8_t, 16 * 128> sounding{};
+    std::array<uint16_t, 16 * 128> staleOffs{};
+
+    OutgoingMidi message;
+    while (running_.load(std::memory_order_relaxed)) {
+        while (sequencer_->takeOutgoingMidi(message)) {
+            waiting.push_back({message, sequence++});
+            std::push_heap(waiting.begin(), waiting.end(), later);
+        }
+        if (waiting.empty()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(MAX_SLEEP_MICROS));
+            continue;
+        }
+
+        // Wait for the earliest message's moment, still taking new ones
+        const uint64_t now = hostTimeMicros();
+        const OutgoingMidi& next = waiting.front().message;
+        if (next.hostMicros > now) {
+            const uint64_t wait = next.hostMicros - now;
+            if (wait > SPIN_MICROS) {
+                std::this_thread::sleep_for(std::chrono::microseconds(
+                    std::min(wait - SPIN_MICROS, MAX_SLEEP_MICROS)));
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+
+        std::pop_heap(waiting.begin(), waiting.end(), later);
+        message = waiting.back().message;
+        waiting.pop_back();
+
+        const uint8_t type = message.data[0] & 0xF0;
+        const bool noteOn = type == 0x90 && message.size == 3;
+        const bool noteOff = type == 0x80 && message.size == 3;
+        if (!noteOff && now - message.hostMicros > MAX_LATE_MICROS) {
+            continue;
+        }
+
+        if (noteOn || noteOff) {
+            const size_t key = (message.data[0] & 0x0F) * 128u + (message.data[1] & 0x7F);
+            if (noteOff) {
+                if (staleOffs[key] > 0) {
+                    staleOffs[key]--;
+                    continue;
+                }
+                sounding[key] = 0;
+            } else if (sounding[key]) {
+                OutgoingMidi release = message;
+                release.data[0] = 0x80 | (message.data[0] & 0x0F);
+                release.data[2] = 0;
+                send(release, bytes);
+                staleOffs[key]++;
+            } else {
+                sounding[key] = 1;
+            }
+        }
+        send(message, bytes);
+    }
+
+    // Stopping (port switch or exit): queued note-ons are dropped, and
+    // every key still sounding - which covers every queued note-off
+    // whose note-on went out - is released now, so no note hangs
+    while (sequencer_->takeOutgoingMidi(message)) {
+    }
+    OutgoingMidi release{};
+    release.size = 3;
+    for (size_t key = 0; key < sounding.size(); ++key) {
+        if (sounding[key]) {
+            release.data[0] = static_cast<uint8_t>(0x80 | (key / 128));
+            release.data[1] = static_cast<uint8_t>(key % 128);
+            release.data[2] = 0;
+            send(release, bytes);
+        }
+    }
+}
+
+void MidiOutput::send(const OutgoingMidi& message, std::vector<unsigned char>& bytes)
+{
+    bytes.assign(message.data, message.data + message.size);
+    try {
+        rtMidiOut_->midiOut->sendMessage(&bytes);
+    } catch (const RtMidiError& e) {
+        LOG_ERROR("MIDI Error during send: %s", e.what());
+    }
+}
+
+} // namespace DrumMachine
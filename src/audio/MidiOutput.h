@@ -0,0 +1,84 @@
+#ifndef MIDI_OUTPUT_H
+#define MIDI_OUTPUT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+namespace DrumMachine {
+
+class Sequencer;
+struct OutgoingMidi;
+
+/**
+ * MidiOutput
+ *
+ * Sends the sequencer's outgoing MIDI (clock, transport messages and
+ * notes) to an output port. The audio thread only queues timestamped
+ * messages; a dedicated sender thread orders them by host time, waits for
+ * each one's moment and writes it to RtMidi, so the callback never
+ * touches the MIDI driver. Messages that fall too far behind (e.g. queued
+ * while no port was open) are dropped rather than sent late, except
+ * note-offs, which are always sent so no note hangs. A note retriggered
+ * before its note-off is released first, and the stale note-off skipped.
+ * Closing or switching the port releases every note still sounding
+ * before the port closes.
+ */
+class MidiOutput {
+public:
+    MidiOutput();
+    ~MidiOutput();
+
+    // Initialize MIDI output
+    bool initialize();
+
+    // Stop sending and close the port
+    void shutdown();
+
+    // Is a port open and the sender running?
+    bool isActive() const;
+
+    // Source of outgoing messages; set before opening a port
+    void setSequencer(Sequencer* sequencer) { sequencer_ = sequencer; }
+
+    // Get list of available MIDI output ports
+    std::vector<std::string> getOutputPorts() const;
+
+    // Open a specific MIDI output port (closing any open one)
+    bool openPort(uint32_t portIndex);
+
+    // Open virtual MIDI output (for software instruments)
+    bool openVirtualPort(const std::string& portName = "Drum Machine Output");
+
+    // Index of the open port, -1 if none (virtual ports report -1)
+    int getOpenPort() const { return openPort_; }
+
+    // Name of the open port, empty if none
+    const std::string& getOpenPortName() const { return openPortName_; }
+
+private:
+    class RtMidiWrapper;
+    std::unique_ptr<RtMidiWrapper> rtMidiOut_;
+
+    Sequencer* sequencer_;
+    int openPort_;
+    std::string openPortName_;
+    std::thread sender_;
+    std::atomic<bool> running_;
+
+    void startSender();
+    void stopSender();
+
+    // Sender thread body
+    void run();
+
+    // Sender thread: write one message to the port
+    void send(const OutgoingMidi& message, std::vector<unsigned char>& bytes);
+};
+
+} // namespace DrumMachine
+
+#endif // MIDI_OUTPUT_H
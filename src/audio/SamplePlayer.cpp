@@ -1,5 +1,5 @@
 #include "SamplePlayer.h"
-#include <iostream>
+#include "../core/Logger.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
@@ -12,8 +12,8 @@ namespace DrumMachine {
 
 SamplePlayer::SamplePlayer(uint32_t engineSampleRate)
     : engineSampleRate_(engineSampleRate), playbackPosition_(0), 
-      isPlaying_(false), pendingTrigger_(false), originalSampleRate_(44100), 
-      channelCount_(1), totalFrames_(0)
+      isPlaying_(false), pendingTrigger_(false), pendingStart_(0), pendingRate_(1.0),
+      rate_(1.0), fraction_(0.0), originalSampleRate_(44100), channelCount_(1), totalFrames_(0)
 {
 }
 
@@ -33,14 +33,13 @@ bool SamplePlayer::loadSample(const std::string& filePath)
         filePath.c_str(), &channels, &sampleRate, &frameCount, nullptr);
 
     if (!pSampleData) {
-        std::cerr << "Failed to load WAV file: " << filePath << std::endl;
+        LOG_ERROR("Failed to load WAV file: %s", filePath.c_str());
         return false;
     }
 
-    std::cout << "Loaded sample: " << filePath << std::endl;
-    std::cout << "  Channels: " << channels << std::endl;
-    std::cout << "  Sample Rate: " << sampleRate << " Hz" << std::endl;
-    std::cout << "  Frames: " << frameCount << " (" << (frameCount / static_cast<float>(sampleRate)) << " seconds)" << std::endl;
+    LOG_INFO("Loaded sample: %s", filePath.c_str());
+    LOG_DEBUG("  Channels: %u, sample rate: %u Hz, frames: %llu (%.3f seconds)", channels, sampleRate,
+              static_cast<unsigned long long>(frameCount), frameCount / static_cast<double>(sampleRate));
 
     originalSampleRate_ = sampleRate;
     channelCount_ = channels;
@@ -48,28 +47,29 @@ bool SamplePlayer::loadSample(const std::string& filePath)
 
     // Copy to vector (interleaved format)
     std::vector<float> rawData(pSampleData, pSampleData + frameCount * channels);
-    std::cout << "  [DEBUG] rawData.size() = " << rawData.size() << " samples" << std::endl;
+    LOG_DEBUG("  rawData.size() = %zu samples", rawData.size());
     
     // Free dr_wav allocation
     drwav_free(pSampleData, nullptr);
 
     // Resample if needed
     if (sampleRate != engineSampleRate_) {
-        std::cout << "Resampling from " << sampleRate << " Hz to " << engineSampleRate_ << " Hz" << std::endl;
+        LOG_DEBUG("Resampling from %u Hz to %u Hz", sampleRate, engineSampleRate_);
         resample(rawData, channels, sampleRate);
     } else {
         sampleData_ = rawData;
     }
 
+#if DRUM_MACHINE_LOG_LEVEL <= 0
     // CHECK: Print first few sample values to verify audio data is real
     if (!sampleData_.empty()) {
         float maxVal = 0.0f;
         for (size_t i = 0; i < std::min(sampleData_.size(), size_t(100)); i++) {
             maxVal = std::max(maxVal, std::abs(sampleData_[i]));
         }
-        std::cout << "  [SAMPLE_CHECK] First 100 samples max value: " << maxVal 
-                  << " (should be > 0.0)" << std::endl;
+        LOG_DEBUG("  [SAMPLE_CHECK] First 100 samples max value: %f (should be > 0.0)", maxVal);
     }
+#endif
     
     reset();
     return true;
@@ -107,7 +107,7 @@ void SamplePlayer::resample(const std::vector<float>& input, uint32_t inputChann
     }
 
     totalFrames_ = outputFrames;
-    std::cout << "Resampled to " << outputFrames << " frames" << std::endl;
+    LOG_DEBUG("Resampled to %u frames", outputFrames);
 }
 
 float SamplePlayer::getDurationSeconds() const
@@ -131,15 +131,27 @@ void SamplePlayer::stop()
 
 void SamplePlayer::reset()
 {
+    pendingStart_.store(0, std::memory_order_relaxed);
+    pendingRate_.store(1.0, std::memory_order_relaxed);
     pendingTrigger_.store(true, std::memory_order_release);
 }
 
+void SamplePlayer::trigger(uint32_t startFrame, double rate)
+{
+    pendingStart_.store(startFrame, std::memory_order_relaxed);
+    pendingRate_.store(rate, std::memory_order_relaxed);
+    pendingTrigger_.store(true, std::memory_order_release);
+    isPlaying_.store(true, std::memory_order_release);
+}
+
 uint32_t SamplePlayer::readFrames(float* outputBuffer, uint32_t numFrames, bool loop)
 {
     // Check for pending trigger first (set by UI thread via start()/reset())
     // Use exchange to atomically read and clear the flag
     if (pendingTrigger_.exchange(false, std::memory_order_acq_rel)) {
-        playbackPosition_.store(0, std::memory_order_release);
+        playbackPosition_.store(pendingStart_.load(std::memory_order_relaxed), std::memory_order_release);
+        rate_ = pendingRate_.load(std::memory_order_relaxed);
+        fraction_ = 0.0;
     }
     
     // Atomic load for thread-safe check (UI thread may call start() concurrently)
@@ -148,6 +160,11 @@ uint32_t SamplePlayer::readFrames(float* outputBuffer, uint32_t numFrames, bool
         return 0;
     }
 
+    // Pitched playback interpolates between frames
+    if (rate_ != 1.0) {
+        return readFramesAtRate(outputBuffer, numFrames, loop);
+    }
+
     // Load position atomically
     uint32_t currentPos = playbackPosition_.load(std::memory_order_acquire);
     uint32_t framesRead = 0;
@@ -189,4 +206,39 @@ uint32_t SamplePlayer::readFrames(float* outputBuffer, uint32_t numFrames, bool
     return framesRead;
 }
 
+uint32_t SamplePlayer::readFramesAtRate(float* outputBuffer, uint32_t numFrames, bool loop)
+{
+    const uint32_t frames = static_cast<uint32_t>(sampleData_.size() / channelCount_);
+    double position = playbackPosition_.load(std::memory_order_acquire) + fraction_;
+    uint32_t framesRead = 0;
+
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        uint32_t frame = static_cast<uint32_t>(position);
+        if (frame + 1 >= frames) {
+            if (loop && frames > 1) {
+                position -= frame;
+                frame = 0;
+            } else {
+                // End of sample reached
+                isPlaying_.store(false, std::memory_order_release);
+                break;
+            }
+        }
+
+        const float weight = static_cast<float>(position - frame);
+        const float* low = &sampleData_[frame * channelCount_];
+        const float* high = low + channelCount_;
+        for (uint32_t ch = 0; ch < channelCount_; ++ch) {
+            outputBuffer[i * channelCount_ + ch] = low[ch] + (high[ch] - low[ch]) * weight;
+        }
+        framesRead++;
+        position += rate_;
+    }
+
+    const uint32_t whole = static_cast<uint32_t>(position);
+    fraction_ = position - whole;
+    playbackPosition_.store(whole, std::memory_order_release);
+    return framesRead;
+}
+
 } // namespace DrumMachine
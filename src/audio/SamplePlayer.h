@@ -49,6 +49,13 @@ public:
     // Trigger sample (reset and start)
     void trigger() { reset(); start(); }
 
+    // Trigger from `startFrame` at `rate` times the original speed
+    // (pitch). Like trigger(), applied at the audio thread's next read.
+    void trigger(uint32_t startFrame, double rate);
+
+    // Length in frames at the engine sample rate
+    uint32_t getFrameCount() const { return totalFrames_; }
+
     // Get next audio frames
     // Reads interleaved stereo samples (L/R/L/R...)
     // Returns number of frames actually read
@@ -66,6 +73,10 @@ private:
     std::atomic<uint32_t> playbackPosition_;  // Current position in sample (atomic for thread safety)
     std::atomic<bool> isPlaying_;             // Playing state (atomic for thread safety)
     std::atomic<bool> pendingTrigger_;        // Flag set by UI thread, consumed by audio thread
+    std::atomic<uint32_t> pendingStart_;      // Start frame of the pending trigger
+    std::atomic<double> pendingRate_;         // Playback rate of the pending trigger
+    double rate_;                             // Audio thread: current playback rate
+    double fraction_;                         // Audio thread: position between frames at rate_ != 1
     uint32_t originalSampleRate_;
     uint32_t channelCount_;               // 1 = mono, 2 = stereo
     uint32_t totalFrames_;                // Total frames in sample
@@ -73,6 +84,9 @@ private:
     // Helper: Resample sample data to engine sample rate using linear interpolation
     void resample(const std::vector<float>& input, uint32_t inputChannels,
                   uint32_t inputSampleRate);
+
+    // readFrames() at a rate other than 1 (linear interpolation)
+    uint32_t readFramesAtRate(float* outputBuffer, uint32_t numFrames, bool loop);
 };
 
 } // namespace DrumMachine
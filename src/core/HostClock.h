@@ -0,0 +1,19 @@
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace DrumMachine {
+
+// Monotonic host time in microseconds. The common timebase for MIDI
+// timestamps and audio block times.
+inline uint64_t hostTimeMicros()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace DrumMachine
+
+#endif // HOST_CLOCK_H
@@ -0,0 +1,160 @@
+#include "Logger.h"
+#include "HostClock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+
+namespace DrumMachine {
+
+namespace {
+
+constexpr uint32_t FLUSH_INTERVAL_MICROS = 5000;
+
+const char* levelName(LogLevel level)
+{
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warning: return "WARNING";
+        default: return "ERROR";
+    }
+}
+
+} // namespace
+
+Logger& Logger::getInstance()
+{
+    static Logger instance;
+    return instance;
+}
+
+Logger::Logger()
+    : claimed_(0), sequence_(0), dropped_(0), running_(false)
+{
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+bool Logger::start(const std::string& filePath)
+{
+    if (running_.load()) {
+        return true;
+    }
+
+    if (!filePath.empty()) {
+        file_.open(filePath, std::ios::app);
+        if (!file_) {
+            std::cerr << "Failed to open log file: " << filePath << std::endl;
+        }
+    }
+
+    running_.store(true);
+    flusher_ = std::thread(&Logger::run, this);
+    return true;
+}
+
+void Logger::stop()
+{
+    if (!running_.load()) {
+        return;
+    }
+    running_.store(false);
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    if (dropped_.load() > 0) {
+        std::cerr << "Logger dropped " << dropped_.load() << " lines" << std::endl;
+    }
+    file_.close();
+}
+
+Logger::Ring* Logger::threadRing()
+{
+    // Plain pointers: no thread_local destructor to register, which
+    // could allocate on the thread's first log
+    thread_local Ring* ring = nullptr;
+    thread_local bool claimed = false;
+    if (!claimed) {
+        claimed = true;
+        const size_t index = claimed_.fetch_add(1, std::memory_order_relaxed);
+        ring = index < MAX_THREADS ? &rings_[index] : nullptr;
+    }
+    return ring;
+}
+
+void Logger::write(LogLevel level, const char* format, ...)
+{
+    Ring* ring = threadRing();
+    if (!ring) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    LogRecord record;
+    record.hostMicros = hostTimeMicros();
+    record.sequence = sequence_.fetch_add(1, std::memory_order_relaxed);
+    record.level = level;
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(record.text, sizeof(record.text), format, args);
+    va_end(args);
+
+    if (!ring->push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::run()
+{
+    for (;;) {
+        // Checked before draining, so nothing logged before stop() is lost
+        const bool running = running_.load();
+        flush();
+        if (!running) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(FLUSH_INTERVAL_MICROS));
+    }
+}
+
+bool Logger::flush()
+{
+    std::vector<LogRecord>& batch = batch_;
+    batch.clear();
+
+    const size_t rings = std::min(claimed_.load(std::memory_order_relaxed), MAX_THREADS);
+    LogRecord record;
+    for (size_t i = 0; i < rings; ++i) {
+        while (rings_[i].pop(record)) {
+            batch.push_back(record);
+        }
+    }
+    if (batch.empty()) {
+        return false;
+    }
+
+    std::sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) {
+        return a.hostMicros != b.hostMicros ? a.hostMicros < b.hostMicros : a.sequence < b.sequence;
+    });
+
+    for (const LogRecord& line : batch) {
+        std::ostream& console = line.level >= LogLevel::Warning ? std::cerr : std::cout;
+        console << line.text << '\n';
+        if (file_.is_open()) {
+            file_ << line.hostMicros << ' ' << levelName(line.level) << ' ' << line.text << '\n';
+        }
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    if (file_.is_open()) {
+        file_.flush();
+    }
+    return true;
+}
+
+} // namespace DrumMachine
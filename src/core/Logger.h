@@ -0,0 +1,136 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "SpscQueue.h"
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+// Lowest level compiled in: 0 debug, 1 info, 2 warning, 3 error.
+// Set by CMake (DRUM_MACHINE_LOG_LEVEL); calls below it compile to nothing
+// (their arguments are still type-checked but never evaluated).
+#ifndef DRUM_MACHINE_LOG_LEVEL
+#define DRUM_MACHINE_LOG_LEVEL 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DRUM_MACHINE_PRINTF_FORMAT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define DRUM_MACHINE_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
+
+namespace DrumMachine {
+
+enum class LogLevel : uint8_t { Debug, Info, Warning, Error };
+
+/**
+ * LogRecord
+ *
+ * One formatted log line, copied whole through a thread's ring.
+ */
+struct LogRecord {
+    static constexpr size_t MAX_TEXT = 239;  // Longer lines are truncated
+
+    uint64_t hostMicros;
+    uint64_t sequence;  // Orders records stamped alike
+    LogLevel level;
+    char text[MAX_TEXT + 1];
+};
+static_assert(std::is_trivially_copyable<LogRecord>::value, "Records are copied between threads");
+
+/**
+ * Logger
+ *
+ * Asynchronous logging that never blocks the caller. Each thread formats
+ * its line into a fixed-size record and pushes it into a lock-free ring
+ * of its own, claimed from a preallocated pool with one atomic increment
+ * the first time the thread logs; nothing locks or allocates, so the
+ * audio and MIDI threads may log. A thread keeps its ring for the life
+ * of the process (MAX_THREADS covers the app's threads with room for
+ * restarted ones). A flusher thread drains every ring in time
+ * order to the console (warnings and errors to stderr) and to the log
+ * file. Lines that find their ring full, or a thread that finds the
+ * pool exhausted, are dropped and counted.
+ *
+ * Records logged before start() wait in their rings (up to RING_CAPACITY
+ * per thread) and are written once it runs.
+ *
+ * Use the LOG_* macros; levels below DRUM_MACHINE_LOG_LEVEL are compiled
+ * out.
+ */
+class Logger {
+public:
+    static constexpr size_t RING_CAPACITY = 256;
+    static constexpr size_t MAX_THREADS = 32;
+
+    // Process-wide logger. Call first from main(), before other threads.
+    static Logger& getInstance();
+
+    // Start the flusher; with a path, lines are also appended to that file
+    bool start(const std::string& filePath = "");
+
+    // Write what is queued and stop the flusher
+    void stop();
+
+    // Any thread: format and queue one line (printf-style)
+    void write(LogLevel level, const char* format, ...) DRUM_MACHINE_PRINTF_FORMAT(3, 4);
+
+    // Lines lost to full rings or an exhausted pool
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    Logger();
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    using Ring = SpscQueue<LogRecord, RING_CAPACITY>;
+
+    std::array<Ring, MAX_THREADS> rings_;
+    std::atomic<size_t> claimed_;  // Rings handed out so far
+    std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> running_;
+    std::thread flusher_;
+    std::ofstream file_;
+    std::vector<LogRecord> batch_;  // Flusher thread: lines being written
+
+    // Calling thread's ring, claimed on first use; nullptr if none left
+    Ring* threadRing();
+
+    // Flusher thread body
+    void run();
+
+    // Flusher thread: drain every ring and write the lines in time order
+    bool flush();
+};
+
+} // namespace DrumMachine
+
+#if DRUM_MACHINE_LOG_LEVEL <= 0
+#define LOG_DEBUG(...) ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { if (false) { ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Debug, __VA_ARGS__); } } while (0)
+#endif
+
+#if DRUM_MACHINE_LOG_LEVEL <= 1
+#define LOG_INFO(...) ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { if (false) { ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Info, __VA_ARGS__); } } while (0)
+#endif
+
+#if DRUM_MACHINE_LOG_LEVEL <= 2
+#define LOG_WARNING(...) ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) do { if (false) { ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Warning, __VA_ARGS__); } } while (0)
+#endif
+
+#define LOG_ERROR(...) ::DrumMachine::Logger::getInstance().write(::DrumMachine::LogLevel::Error, __VA_ARGS__)
+
+#endif // LOGGER_H
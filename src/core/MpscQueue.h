@@ -0,0 +1,93 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * MpscQueue
+ *
+ * Fixed-capacity lock-free ring buffer for handing POD items from any
+ * number of producer threads to one consumer thread. Each cell carries a
+ * sequence number, so producers claim cells with a single CAS and never
+ * wait on each other or on the consumer; push() fails when the ring is
+ * full. Never allocates, so the audio thread may push.
+ *
+ * A producer that has claimed a cell but not yet filled it hides the
+ * items behind it from pop() until it finishes.
+ *
+ * Threading: any producers (push), one consumer (pop).
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Items are copied between threads");
+
+public:
+    MpscQueue() : tail_(0), head_(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Producer (any thread): append an item; false if the ring is full
+    bool push(const T& item)
+    {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &cells_[position & (Capacity - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Cell still holds an item from one lap ago
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->item = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: take the oldest item; false if none is ready
+    bool pop(T& item)
+    {
+        Cell& cell = cells_[head_ & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        item = cell.item;
+        cell.sequence.store(head_ + Capacity, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;  // == position: free, == position + 1: filled
+        T item;
+    };
+
+    std::array<Cell, Capacity> cells_;
+    alignas(64) std::atomic<size_t> tail_;  // Next position producers claim
+    alignas(64) size_t head_;               // Consumer position
+};
+
+} // namespace DrumMachine
+
+#endif // MPSC_QUEUE_H
@@ -1,60 +1,311 @@
 #include "ParameterBus.h"
-#include <sstream>
-#include <iostream>
+#include "HostClock.h"
+#include <algorithm>
 
 namespace DrumMachine {
 
+namespace {
+
+enum class Scope : uint8_t { Global, Track, Step };
+
+constexpr uint32_t NUM_TYPES = ParameterBus::NUM_TYPES;
+
+constexpr Scope scopeOf(ParameterType type)
+{
+    switch (type) {
+        case ParameterType::TRACK_MUTED:
+        case ParameterType::TRACK_VOLUME:
+        case ParameterType::TRACK_PAN:
+        case ParameterType::TRACK_SAMPLE:
+        case ParameterType::BUTTON_PRESSED:
+        case ParameterType::KNOB_TURNED:
+        case ParameterType::FADER_MOVED:
+        case ParameterType::TRACK_LENGTH:
+        case ParameterType::TRACK_STEP_TICKS:
+        case ParameterType::LIVE_NOTE:
+            return Scope::Track;
+        case ParameterType::STEP_ACTIVE:
+        case ParameterType::LED_COLOR_CHANGED:
+        case ParameterType::STEP_DATA:
+        case ParameterType::STEP_LOCKS:
+            return Scope::Step;
+        default:
+            return Scope::Global;
+    }
+}
+
+constexpr uint32_t slotCount(Scope scope)
+{
+    return scope == Scope::Global ? 1
+         : scope == Scope::Track ? ParameterBus::MAX_TRACKS
+         : ParameterBus::MAX_TRACKS * ParameterBus::MAX_STEPS;
+}
+
+struct CacheLayout {
+    std::array<uint32_t, NUM_TYPES> offsets;
+    std::array<Scope, NUM_TYPES> scopes;
+    uint32_t size;
+};
+
+constexpr CacheLayout makeLayout()
+{
+    CacheLayout layout{};
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < NUM_TYPES; ++i) {
+        layout.scopes[i] = scopeOf(static_cast<ParameterType>(i));
+        layout.offsets[i] = offset;
+        offset += slotCount(layout.scopes[i]);
+    }
+    layout.size = offset;
+    return layout;
+}
+
+constexpr CacheLayout LAYOUT = makeLayout();
+
+} // namespace
+
+ParameterBus::ParameterBus()
+    : nextSubscriberId_(1), stateCache_(LAYOUT.size, ParameterValue(0u)), dropped_(0), dispatched_(0), delivered_(0), coalescing_(false),
+      pendingIndex_(LAYOUT.size, NOT_PENDING), delivering_(false)
+{
+    window_.reserve(QUEUE_CAPACITY);
+}
+
 ParameterBus& ParameterBus::getInstance()
 {
     static ParameterBus instance;
     return instance;
 }
 
-void ParameterBus::publish(const ParameterChange& change)
+bool ParameterBus::publish(const ParameterChange& change)
+{
+    ParameterChange stamped = change;
+    stamped.hostMicros = hostTimeMicros();
+    if (!queue_.push(stamped)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+uint32_t ParameterBus::dispatch()
+{
+    // Called from a callback: the outer dispatch() picks the records up
+    if (delivering_) {
+        return 0;
+    }
+    const bool coalescing = coalescing_.load(std::memory_order_relaxed);
+
+    // Without batch subscribers an uncoalesced window isn't needed
+    const SubscriberList* batchSubscribers = subscribers_[BATCH_SUBSCRIBERS].acquire();
+    const bool batching = batchSubscribers && !batchSubscribers->empty();
+    const SubscriberList* rawSubscribers = subscribers_[RAW_SUBSCRIBERS].acquire();
+    const bool recording = rawSubscribers && !rawSubscribers->empty();
+
+    std::array<ParameterChange, DISPATCH_BATCH> batch;
+    uint32_t total = 0;
+    for (;;) {
+        uint32_t count = 0;
+        while (count < DISPATCH_BATCH && queue_.pop(batch[count])) {
+            count++;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const ParameterChange& change = batch[i];
+            if (recording) {
+                delivering_ = true;
+                notify(RAW_SUBSCRIBERS, change);
+                delivering_ = false;
+            }
+            if (!coalescing) {
+                if (batching) {
+                    window_.push_back(change);
+                }
+                deliver(change);
+                continue;
+            }
+
+            // Later changes to a pending key overwrite it in place
+            const uint32_t slot = getSlot(change.type, change.trackIndex, change.stepIndex);
+            if (slot != NO_SLOT && pendingIndex_[slot] != NOT_PENDING) {
+                window_[pendingIndex_[slot]] = change;
+                continue;
+            }
+            if (slot != NO_SLOT) {
+                pendingIndex_[slot] = static_cast<uint32_t>(window_.size());
+            }
+            window_.push_back(change);
+        }
+        total += count;
+    }
+
+    if (coalescing) {
+        for (const ParameterChange& change : window_) {
+            deliver(change);
+        }
+    }
+
+    if (!window_.empty()) {
+        notifyBatch(ParameterBatch{window_.data(), window_.size()});
+        delivered_.fetch_add(window_.size(), std::memory_order_relaxed);
+        for (const ParameterChange& change : window_) {
+            const uint32_t slot = getSlot(change.type, change.trackIndex, change.stepIndex);
+            if (slot != NO_SLOT) {
+                pendingIndex_[slot] = NOT_PENDING;
+            }
+        }
+        window_.clear();
+    }
+
+    dispatched_.fetch_add(total, std::memory_order_relaxed);
+    return total;
+}
+
+void ParameterBus::deliver(const ParameterChange& change)
 {
     // Update state cache
-    std::string cacheKey = getCacheKey(change.type, change.trackIndex, change.stepIndex);
-    stateCache_[cacheKey] = change.value;
-
-    // Notify specific subscribers
-    auto it = subscribers_.find(change.type);
-    if (it != subscribers_.end()) {
-        for (auto& callback : it->second) {
-            callback(change);
+    const uint32_t slot = getSlot(change.type, change.trackIndex, change.stepIndex);
+    if (slot != NO_SLOT) {
+        stateCache_[slot] = change.value;
+    }
+
+    // Notify type subscribers, then all-subscribers
+    delivering_ = true;
+    const uint32_t type = static_cast<uint32_t>(change.type);
+    if (type < NUM_TYPES) {
+        notify(type, change);
+    }
+    notify(ALL_SUBSCRIBERS, change);
+    delivering_ = false;
+}
+
+void ParameterBus::notify(uint32_t list, const ParameterChange& change)
+{
+    const SubscriberList* subscribers = subscribers_[list].acquire();
+    if (!subscribers) {
+        return;
+    }
+    for (const auto& subscriber : *subscribers) {
+        if (subscriber->active.load(std::memory_order_acquire)) {
+            subscriber->callback(change);
+        }
+    }
+}
+
+void ParameterBus::notifyBatch(const ParameterBatch& batch)
+{
+    const SubscriberList* subscribers = subscribers_[BATCH_SUBSCRIBERS].acquire();
+    if (!subscribers) {
+        return;
+    }
+    delivering_ = true;
+    for (const auto& subscriber : *subscribers) {
+        if (subscriber->active.load(std::memory_order_acquire)) {
+            subscriber->batchCallback(batch);
         }
     }
+    delivering_ = false;
+}
+
+ParameterSubscription ParameterBus::subscribe(ParameterType type, ParameterCallback callback)
+{
+    const uint32_t list = static_cast<uint32_t>(type);
+    if (list >= NUM_TYPES) {
+        return ParameterSubscription();
+    }
+    return addSubscriber(list, std::move(callback), nullptr);
+}
+
+ParameterSubscription ParameterBus::subscribeToAll(ParameterCallback callback)
+{
+    return addSubscriber(ALL_SUBSCRIBERS, std::move(callback), nullptr);
+}
+
+ParameterSubscription ParameterBus::subscribeBatch(ParameterBatchCallback callback)
+{
+    return addSubscriber(BATCH_SUBSCRIBERS, nullptr, std::move(callback));
+}
+
+ParameterSubscription ParameterBus::subscribeRaw(ParameterCallback callback)
+{
+    return addSubscriber(RAW_SUBSCRIBERS, std::move(callback), nullptr);
+}
+
+ParameterSubscription ParameterBus::addSubscriber(uint32_t list, ParameterCallback callback,
+                                                  ParameterBatchCallback batchCallback)
+{
+    std::lock_guard<std::mutex> lock(subscribeMutex_);
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->id = nextSubscriberId_++;
+    subscriber->callback = std::move(callback);
+    subscriber->batchCallback = std::move(batchCallback);
+    subscriber->active.store(true, std::memory_order_relaxed);
+
+    // Copy-on-write: dispatch() keeps iterating the list it pinned
+    const SubscriberList* current = subscribers_[list].peek();
+    auto next = current ? std::make_unique<SubscriberList>(*current) : std::make_unique<SubscriberList>();
+    next->push_back(subscriber);
+    subscribers_[list].publish(std::move(next));
+
+    return ParameterSubscription(this, list, subscriber->id);
+}
+
+void ParameterBus::removeSubscriber(uint32_t list, uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(subscribeMutex_);
+
+    const SubscriberList* current = subscribers_[list].peek();
+    if (!current) {
+        return;
+    }
 
-    // Notify all-subscribers
-    for (auto& callback : allSubscribers_) {
-        callback(change);
+    auto next = std::make_unique<SubscriberList>();
+    next->reserve(current->size());
+    for (const auto& subscriber : *current) {
+        if (subscriber->id == id) {
+            subscriber->active.store(false, std::memory_order_release);
+        } else {
+            next->push_back(subscriber);
+        }
     }
+    subscribers_[list].publish(std::move(next));
 }
 
-void ParameterBus::subscribe(ParameterType type, ParameterCallback callback)
+ParameterSubscription::ParameterSubscription(ParameterSubscription&& other) noexcept
+    : bus_(other.bus_), list_(other.list_), id_(other.id_)
 {
-    subscribers_[type].push_back(callback);
+    other.bus_ = nullptr;
 }
 
-void ParameterBus::subscribeToAll(ParameterCallback callback)
+ParameterSubscription& ParameterSubscription::operator=(ParameterSubscription&& other) noexcept
 {
-    allSubscribers_.push_back(callback);
+    if (this != &other) {
+        reset();
+        bus_ = other.bus_;
+        list_ = other.list_;
+        id_ = other.id_;
+        other.bus_ = nullptr;
+    }
+    return *this;
 }
 
-void ParameterBus::unsubscribe(ParameterType type, ParameterCallback* callback)
+void ParameterSubscription::reset()
 {
-    auto it = subscribers_.find(type);
-    if (it != subscribers_.end()) {
-        // Note: This is a simplified approach; in production, use std::erase_if or a different mechanism
-        // for removing callbacks by pointer
+    if (bus_) {
+        bus_->removeSubscriber(list_, id_);
+        bus_ = nullptr;
     }
 }
 
 ParameterValue ParameterBus::getParameterValue(ParameterType type, uint32_t trackIndex, uint32_t stepIndex) const
 {
-    std::string cacheKey = getCacheKey(type, trackIndex, stepIndex);
-    auto it = stateCache_.find(cacheKey);
-    if (it != stateCache_.end()) {
-        return it->second;
+    const uint32_t slot = getSlot(type, trackIndex, stepIndex);
+    if (slot != NO_SLOT) {
+        return stateCache_[slot];
     }
     // Return default empty variant
     return ParameterValue(0u);
@@ -62,22 +313,55 @@ ParameterValue ParameterBus::getParameterValue(ParameterType type, uint32_t trac
 
 void ParameterBus::setParameterValue(ParameterType type, const ParameterValue& value, uint32_t trackIndex, uint32_t stepIndex)
 {
-    std::string cacheKey = getCacheKey(type, trackIndex, stepIndex);
-    stateCache_[cacheKey] = value;
+    const uint32_t slot = getSlot(type, trackIndex, stepIndex);
+    if (slot != NO_SLOT) {
+        stateCache_[slot] = value;
+    }
 }
 
 void ParameterBus::reset()
 {
-    subscribers_.clear();
-    allSubscribers_.clear();
-    stateCache_.clear();
+    ParameterChange discarded;
+    while (queue_.pop(discarded)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(subscribeMutex_);
+        for (auto& list : subscribers_) {
+            if (const SubscriberList* current = list.peek()) {
+                for (const auto& subscriber : *current) {
+                    subscriber->active.store(false, std::memory_order_release);
+                }
+                list.publish(std::make_unique<SubscriberList>());
+            }
+        }
+    }
+    stateCache_.assign(LAYOUT.size, ParameterValue(0u));
+    pendingIndex_.assign(LAYOUT.size, NOT_PENDING);
+    window_.clear();
 }
 
-std::string ParameterBus::getCacheKey(ParameterType type, uint32_t trackIndex, uint32_t stepIndex) const
+uint32_t ParameterBus::getSlot(ParameterType type, uint32_t trackIndex, uint32_t stepIndex)
 {
-    std::ostringstream oss;
-    oss << static_cast<int>(type) << "_" << trackIndex << "_" << stepIndex;
-    return oss.str();
+    const uint32_t index = static_cast<uint32_t>(type);
+    if (index >= NUM_TYPES) {
+        return NO_SLOT;
+    }
+
+    switch (LAYOUT.scopes[index]) {
+        case Scope::Global:
+            return LAYOUT.offsets[index];
+        case Scope::Track:
+            if (trackIndex >= MAX_TRACKS) {
+                return NO_SLOT;
+            }
+            return LAYOUT.offsets[index] + trackIndex;
+        case Scope::Step:
+            if (trackIndex >= MAX_TRACKS || stepIndex >= MAX_STEPS) {
+                return NO_SLOT;
+            }
+            return LAYOUT.offsets[index] + trackIndex * MAX_STEPS + stepIndex;
+    }
+    return NO_SLOT;
 }
 
 } // namespace DrumMachine
@@ -2,12 +2,17 @@
 #define PARAMETER_BUS_H
 
 #include <functional>
-#include <map>
 #include <vector>
-#include <string>
 #include <variant>
 #include <memory>
 #include <cstdint>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include "MpscQueue.h"
+#include "RtSnapshot.h"
+#include "Symbol.h"
 
 namespace DrumMachine {
 
@@ -18,6 +23,29 @@ namespace DrumMachine {
  * Decouples UI, sequencer state, and 3D rendering.
  * Allows modules to publish/subscribe to parameter changes.
  * Foundation for modular DAW architecture.
+ *
+ * The state cache is a flat array indexed by (type, track, step): each
+ * type has a fixed scope (global, per track or per step) and a
+ * precomputed offset, so reads and writes are O(1) and never allocate.
+ *
+ * Changes are trivially copyable: strings (module ids, file paths) are
+ * interned Symbols. Any thread, including the audio callback, can
+ * publish: changes are copied into a lock-free MPSC ring. The consumer
+ * thread (the UI loop) drains the ring with dispatch(), updating the
+ * cache and notifying subscribers in batches. The cache and dispatch()
+ * belong to the consumer thread.
+ *
+ * Subscribing returns a ParameterSubscription token that unsubscribes
+ * when destroyed. Subscriber lists are copy-on-write snapshots, one per
+ * ParameterType in a flat array: subscribing from any thread publishes
+ * a new list, while dispatch() iterates a pinned snapshot without locks.
+ *
+ * Batch subscribers get everything one dispatch() delivered as a single
+ * contiguous ParameterBatch (one per UI frame). In coalescing mode the
+ * changes to one (type, track, step) inside a dispatch() collapse to the
+ * last value, so a fast knob sweep costs subscribers O(distinct keys).
+ * Raw subscribers (recorders) see every record before it is collapsed,
+ * in publish order.
  * 
  * Milestone 4: Parameter Bus infrastructure
  */
@@ -26,9 +54,12 @@ namespace DrumMachine {
 using ParameterValue = std::variant<
     bool,           // Toggle/mute flags
     float,          // Continuous values (tempo, swing, volume)
-    uint32_t,       // Indices, counts
-    std::string     // File paths, names
+    uint32_t,       // Indices, counts, packed step data
+    uint64_t,       // Packed parameter locks
+    Symbol          // File paths, names
 >;
+static_assert(std::is_trivially_copyable<ParameterValue>::value && sizeof(ParameterValue) <= 16,
+              "Parameter values must stay small POD");
 
 // Parameter types that can be published
 enum class ParameterType {
@@ -54,56 +85,202 @@ enum class ParameterType {
     BUTTON_PRESSED,
     KNOB_TURNED,
     FADER_MOVED,
-    LED_COLOR_CHANGED
+    LED_COLOR_CHANGED,
+
+    // Pattern and session edits (appended: journals store type ids)
+    STEP_DATA,          // Packed StepData of an active step
+    STEP_LOCKS,         // Packed StepLocks of an active step
+    TRACK_LENGTH,       // Track cycle in steps (0 = pattern length)
+    TRACK_STEP_TICKS,   // Track rate in clock ticks per step
+    BAR_COUNT,
+    TEMPO_MAP_ENABLED,
+    PATTERN_SLOT,       // Bank slot selected for editing
+    LIVE_NOTE,          // Velocity of a pad hit on a track (kit-mapped)
+    OPAQUE_EDIT,        // Name of an edit whose content the bus doesn't carry (undo, song chain)
+
+    COUNT  // Number of types (not a parameter)
 };
 
 struct ParameterChange {
     ParameterType type;
     ParameterValue value;
-    uint32_t trackIndex;  // For track-specific parameters
-    uint32_t stepIndex;   // For step-specific parameters
-    std::string moduleId; // Which module published this (e.g., "drum_machine", "ui", "3d_renderer")
+    uint32_t trackIndex = 0;  // For track-specific parameters
+    uint32_t stepIndex = 0;   // For step-specific parameters
+    Symbol moduleId;          // Which module published this (e.g., "drum_machine", "ui", "3d_renderer")
+    uint64_t hostMicros = 0;  // Host time of publish() (stamped by the bus)
+};
+static_assert(std::is_trivially_copyable<ParameterChange>::value, "Changes must stay POD");
+
+/**
+ * ParameterBatch
+ *
+ * Contiguous view of the changes one dispatch() delivered, in publish
+ * order. Valid only for the duration of the callback.
+ */
+struct ParameterBatch {
+    const ParameterChange* data;
+    size_t size;
+
+    const ParameterChange* begin() const { return data; }
+    const ParameterChange* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+class ParameterBus;
+
+/**
+ * ParameterSubscription
+ *
+ * Move-only handle to one subscriber. Destroying or reset()ting it
+ * removes the callback; once that returns on the consumer thread the
+ * callback is never called again.
+ */
+class ParameterSubscription {
+public:
+    ParameterSubscription() : bus_(nullptr), list_(0), id_(0) {}
+    ~ParameterSubscription() { reset(); }
+
+    ParameterSubscription(ParameterSubscription&& other) noexcept;
+    ParameterSubscription& operator=(ParameterSubscription&& other) noexcept;
+    ParameterSubscription(const ParameterSubscription&) = delete;
+    ParameterSubscription& operator=(const ParameterSubscription&) = delete;
+
+    // Unsubscribe now
+    void reset();
+
+    bool isActive() const { return bus_ != nullptr; }
+
+private:
+    friend class ParameterBus;
+    ParameterSubscription(ParameterBus* bus, uint32_t list, uint64_t id) : bus_(bus), list_(list), id_(id) {}
+
+    ParameterBus* bus_;
+    uint32_t list_;
+    uint64_t id_;
 };
 
 class ParameterBus {
 public:
+    // Cache dimensions: tracks cover MIDI channels, steps the longest pattern
+    static constexpr uint32_t MAX_TRACKS = 16;
+    static constexpr uint32_t MAX_STEPS = 256;
+    static constexpr size_t QUEUE_CAPACITY = 1024;  // Records waiting for dispatch()
+    static constexpr uint32_t DISPATCH_BATCH = 64;
+    static constexpr uint32_t NUM_TYPES = static_cast<uint32_t>(ParameterType::COUNT);
+
     static ParameterBus& getInstance();
 
-    // Publish a parameter change to all subscribers
-    void publish(const ParameterChange& change);
+    // Publish a parameter change to all subscribers (any thread, never
+    // allocates or blocks). The change is stamped with the host time and
+    // queued for dispatch().
+    // Returns false if the queue was full and the change was dropped.
+    bool publish(const ParameterChange& change);
+
+    // Consumer thread: apply queued changes to the cache and notify
+    // subscribers, DISPATCH_BATCH records at a time, then hand batch
+    // subscribers the whole window. The calling thread becomes the
+    // consumer thread. Returns the number of records dispatched.
+    uint32_t dispatch();
+
+    // Collapse changes to the same (type, track, step) within one
+    // dispatch() to the last value (any thread; off by default). A
+    // collapsed change keeps the position of the key's first change.
+    // Changes outside the cache are never collapsed.
+    void setCoalescing(bool enabled) { coalescing_.store(enabled, std::memory_order_relaxed); }
+    bool isCoalescing() const { return coalescing_.load(std::memory_order_relaxed); }
 
-    // Subscribe to parameter changes
+    // Records lost because the queue was full
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Records dispatched since startup
+    uint64_t getDispatchedCount() const { return dispatched_.load(std::memory_order_relaxed); }
+
+    // Changes delivered to subscribers since startup (fewer than
+    // dispatched records when coalescing)
+    uint64_t getDeliveredCount() const { return delivered_.load(std::memory_order_relaxed); }
+
+    // Subscribe to parameter changes (any thread). Callbacks run on the
+    // consumer thread until the returned token is destroyed.
     using ParameterCallback = std::function<void(const ParameterChange&)>;
-    void subscribe(ParameterType type, ParameterCallback callback);
-    void subscribeToAll(ParameterCallback callback);
+    [[nodiscard]] ParameterSubscription subscribe(ParameterType type, ParameterCallback callback);
+    [[nodiscard]] ParameterSubscription subscribeToAll(ParameterCallback callback);
+
+    // Subscribe to one batch per dispatch() (any thread)
+    using ParameterBatchCallback = std::function<void(const ParameterBatch&)>;
+    [[nodiscard]] ParameterSubscription subscribeBatch(ParameterBatchCallback callback);
 
-    // Unsubscribe (typically called by destructors)
-    void unsubscribe(ParameterType type, ParameterCallback* callback);
+    // Subscribe to every published change in publish order, ahead of
+    // coalescing and the state cache (any thread)
+    [[nodiscard]] ParameterSubscription subscribeRaw(ParameterCallback callback);
 
-    // Query current parameter value (state cache)
+    // Query current parameter value (state cache). Indices a type does not
+    // use are ignored; values outside the cache read as 0u and are not
+    // stored.
     ParameterValue getParameterValue(ParameterType type, uint32_t trackIndex = 0, uint32_t stepIndex = 0) const;
     void setParameterValue(ParameterType type, const ParameterValue& value, uint32_t trackIndex = 0, uint32_t stepIndex = 0);
 
-    // Clear all subscribers and state (for testing)
+    // Clear all subscribers, queued changes and state (for testing)
     void reset();
 
 private:
-    ParameterBus() = default;
+    ParameterBus();
     ~ParameterBus() = default;
 
     // Prevent copying
     ParameterBus(const ParameterBus&) = delete;
     ParameterBus& operator=(const ParameterBus&) = delete;
 
-    // Subscribers map: ParameterType -> list of callbacks
-    std::map<ParameterType, std::vector<ParameterCallback>> subscribers_;
-    std::vector<ParameterCallback> allSubscribers_;
+    friend class ParameterSubscription;
+
+    struct Subscriber {
+        uint64_t id;
+        ParameterCallback callback;
+        ParameterBatchCallback batchCallback;  // Batch list only
+        std::atomic<bool> active;  // Cleared before the subscriber leaves its list
+    };
+    using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+    // Subscriber lists indexed by ParameterType, plus one each for
+    // subscribeToAll, subscribeBatch and subscribeRaw
+    static constexpr uint32_t ALL_SUBSCRIBERS = NUM_TYPES;
+    static constexpr uint32_t BATCH_SUBSCRIBERS = NUM_TYPES + 1;
+    static constexpr uint32_t RAW_SUBSCRIBERS = NUM_TYPES + 2;
+    std::array<RtSnapshot<SubscriberList>, NUM_TYPES + 3> subscribers_;
+    std::mutex subscribeMutex_;  // Serializes list writers (never taken by dispatch)
+    uint64_t nextSubscriberId_;
+
+    ParameterSubscription addSubscriber(uint32_t list, ParameterCallback callback,
+                                        ParameterBatchCallback batchCallback);
+    void removeSubscriber(uint32_t list, uint64_t id);
+
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    // State cache: current parameter values, one slot per (type, track, step)
+    std::vector<ParameterValue> stateCache_;
+
+    // Cache slot of a parameter, NO_SLOT if out of range
+    static uint32_t getSlot(ParameterType type, uint32_t trackIndex, uint32_t stepIndex);
+
+    // Publish queue and its counters
+    MpscQueue<ParameterChange, QUEUE_CAPACITY> queue_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> dispatched_;
+    std::atomic<uint64_t> delivered_;
+    std::atomic<bool> coalescing_;
+
+    // Consumer thread: the current dispatch() window, and the index in it
+    // of each cache slot's pending change (NOT_PENDING if none)
+    static constexpr uint32_t NOT_PENDING = UINT32_MAX;
+    std::vector<ParameterChange> window_;
+    std::vector<uint32_t> pendingIndex_;
 
-    // State cache: Store current parameter values
-    std::map<std::string, ParameterValue> stateCache_;
+    // Consumer thread: a callback is running
+    bool delivering_;
 
-    // Helper to create cache key
-    std::string getCacheKey(ParameterType type, uint32_t trackIndex, uint32_t stepIndex) const;
+    // Consumer thread: update the cache and notify subscribers
+    void deliver(const ParameterChange& change);
+    void notify(uint32_t list, const ParameterChange& change);
+    void notifyBatch(const ParameterBatch& batch);
 };
 
 } // namespace DrumMachine
@@ -0,0 +1,276 @@
+#include "ParameterJournal.h"
+#include "Logger.h"
+#include <cstring>
+#include <chrono>
+
+namespace DrumMachine {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'M', 'J', '1'};
+constexpr uint32_t VERSION = 2;  // Version 1 files (no 64-bit values) still load
+constexpr uint32_t IDLE_SLEEP_MICROS = 2000;
+constexpr uint32_t MAX_SYMBOLS = 1u << 20;         // Larger ids mark a corrupt file
+constexpr uint32_t MAX_SYMBOL_LENGTH = 1u << 16;  // Longer strings too
+
+enum class EntryKind : uint8_t { Bool, Float, UInt, Symbol, SymbolDefinition, UInt64 };
+
+// On-disk entry. A SymbolDefinition carries the id in `value` and is
+// followed by `length` bytes of its string; a UInt64 keeps its high word
+// in `length`.
+struct DiskEntry {
+    uint64_t hostMicros;
+    uint64_t transportTick;
+    uint32_t trackIndex;
+    uint32_t stepIndex;
+    uint32_t value;     // Raw bits: bool, float, uint32 (low word) or symbol id
+    uint32_t moduleId;  // Symbol id
+    uint32_t length;
+    uint8_t type;
+    uint8_t kind;
+    uint16_t reserved;
+};
+static_assert(sizeof(DiskEntry) == 40, "Journal entries are 40 bytes");
+
+DiskEntry encode(const JournalRecord& record)
+{
+    DiskEntry entry{};
+    entry.hostMicros = record.hostMicros;
+    entry.transportTick = record.transportTick;
+    entry.trackIndex = record.change.trackIndex;
+    entry.stepIndex = record.change.stepIndex;
+    entry.moduleId = record.change.moduleId.getId();
+    entry.type = static_cast<uint8_t>(record.change.type);
+
+    const ParameterValue& value = record.change.value;
+    if (const bool* flag = std::get_if<bool>(&value)) {
+        entry.kind = static_cast<uint8_t>(EntryKind::Bool);
+        entry.value = *flag ? 1u : 0u;
+    } else if (const float* number = std::get_if<float>(&value)) {
+        entry.kind = static_cast<uint8_t>(EntryKind::Float);
+        std::memcpy(&entry.value, number, sizeof(float));
+    } else if (const uint32_t* index = std::get_if<uint32_t>(&value)) {
+        entry.kind = static_cast<uint8_t>(EntryKind::UInt);
+        entry.value = *index;
+    } else if (const uint64_t* packed = std::get_if<uint64_t>(&value)) {
+        entry.kind = static_cast<uint8_t>(EntryKind::UInt64);
+        entry.value = static_cast<uint32_t>(*packed);
+        entry.length = static_cast<uint32_t>(*packed >> 32);
+    } else {
+        entry.kind = static_cast<uint8_t>(EntryKind::Symbol);
+        entry.value = std::get<Symbol>(value).getId();
+    }
+    return entry;
+}
+
+} // namespace
+
+ParameterJournal::ParameterJournal()
+    : running_(false), recorded_(0), dropped_(0)
+{
+}
+
+ParameterJournal::~ParameterJournal()
+{
+    stop();
+}
+
+bool ParameterJournal::start(const std::string& path, PositionSource position)
+{
+    if (running_.load()) {
+        LOG_ERROR("Parameter journal already recording");
+        return false;
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        LOG_ERROR("Failed to create parameter journal: %s", path.c_str());
+        return false;
+    }
+    file_.write(MAGIC, sizeof(MAGIC));
+    file_.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+
+    position_ = std::move(position);
+    writtenSymbols_.assign(1, true);  // The empty symbol needs no definition
+    recorded_.store(0);
+    dropped_.store(0);
+    running_.store(true);
+    writer_ = std::thread(&ParameterJournal::run, this);
+
+    // Runs inside dispatch(), ahead of coalescing: record the change at
+    // the time it was published (not dispatched) and hand it to the writer
+    subscription_ = ParameterBus::getInstance().subscribeRaw([this](const ParameterChange& change) {
+        JournalRecord record;
+        record.hostMicros = change.hostMicros;
+        record.transportTick = position_ ? position_(record.hostMicros) : 0;
+        record.change = change;
+        if (!ring_.push(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    LOG_INFO("Recording parameter journal: %s", path.c_str());
+    return true;
+}
+
+void ParameterJournal::stop()
+{
+    if (!running_.load()) {
+        return;
+    }
+    subscription_.reset();
+    running_.store(false);
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    file_.close();
+
+    LOG_INFO("Parameter journal closed: %llu changes (%llu dropped)",
+             static_cast<unsigned long long>(recorded_.load()),
+             static_cast<unsigned long long>(dropped_.load()));
+}
+
+void ParameterJournal::run()
+{
+    JournalRecord record;
+    for (;;) {
+        // Checked before draining, so nothing pushed before stop() is lost
+        const bool running = running_.load();
+        bool wrote = false;
+        while (ring_.pop(record)) {
+            write(record);
+            wrote = true;
+        }
+        if (!running) {
+            break;
+        }
+        if (!wrote) {
+            file_.flush();
+            std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_MICROS));
+        }
+    }
+    file_.flush();
+}
+
+void ParameterJournal::write(const JournalRecord& record)
+{
+    writeSymbol(record.change.moduleId);
+    if (const Symbol* symbol = std::get_if<Symbol>(&record.change.value)) {
+        writeSymbol(*symbol);
+    }
+
+    const DiskEntry entry = encode(record);
+    file_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ParameterJournal::writeSymbol(Symbol symbol)
+{
+    const uint32_t id = symbol.getId();
+    if (id < writtenSymbols_.size() && writtenSymbols_[id]) {
+        return;
+    }
+    if (id >= writtenSymbols_.size()) {
+        writtenSymbols_.resize(id + 1, false);
+    }
+    writtenSymbols_[id] = true;
+
+    const std::string& text = symbol.str();
+    DiskEntry entry{};
+    entry.kind = static_cast<uint8_t>(EntryKind::SymbolDefinition);
+    entry.value = id;
+    entry.length = static_cast<uint32_t>(text.size());
+    file_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    file_.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+bool ParameterJournal::load(const std::string& path, std::vector<JournalRecord>& records)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Failed to open parameter journal: %s", path.c_str());
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version == 0 || version > VERSION) {
+        LOG_ERROR("Not a parameter journal: %s", path.c_str());
+        return false;
+    }
+
+    // File symbol ids -> symbols interned in this process
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(sizeof(MAGIC) + sizeof(VERSION), std::ios::beg);
+
+    std::vector<Symbol> symbols(1);
+    auto lookup = [&symbols](uint32_t id) {
+        return id < symbols.size() ? symbols[id] : Symbol();
+    };
+
+    records.clear();
+    DiskEntry entry;
+    std::string text;
+    while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+        const EntryKind kind = static_cast<EntryKind>(entry.kind);
+        if (kind == EntryKind::SymbolDefinition) {
+            // Sizes come from the file: check them before allocating
+            if (entry.value == 0 || entry.value >= MAX_SYMBOLS || entry.length > MAX_SYMBOL_LENGTH) {
+                LOG_ERROR("Corrupt parameter journal entry %zu: %s", records.size(), path.c_str());
+                return false;
+            }
+            const uint64_t remaining = fileSize - static_cast<uint64_t>(file.tellg());
+            if (entry.length > remaining) {
+                break;  // Truncated final definition
+            }
+            text.resize(entry.length);
+            if (!file.read(&text[0], entry.length)) {
+                break;
+            }
+            if (entry.value >= symbols.size()) {
+                symbols.resize(entry.value + 1);
+            }
+            symbols[entry.value] = Symbol::intern(text);
+            continue;
+        }
+        if (entry.type >= ParameterBus::NUM_TYPES || kind > EntryKind::UInt64) {
+            LOG_ERROR("Corrupt parameter journal entry %zu: %s", records.size(), path.c_str());
+            return false;
+        }
+
+        JournalRecord record;
+        record.hostMicros = entry.hostMicros;
+        record.transportTick = entry.transportTick;
+        record.change.type = static_cast<ParameterType>(entry.type);
+        record.change.trackIndex = entry.trackIndex;
+        record.change.stepIndex = entry.stepIndex;
+        record.change.moduleId = lookup(entry.moduleId);
+        switch (kind) {
+            case EntryKind::Bool:
+                record.change.value = entry.value != 0;
+                break;
+            case EntryKind::Float: {
+                float number;
+                std::memcpy(&number, &entry.value, sizeof(float));
+                record.change.value = number;
+                break;
+            }
+            case EntryKind::UInt:
+                record.change.value = entry.value;
+                break;
+            case EntryKind::UInt64:
+                record.change.value = (static_cast<uint64_t>(entry.length) << 32) | entry.value;
+                break;
+            default:
+                record.change.value = lookup(entry.value);
+                break;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
+
+} // namespace DrumMachine
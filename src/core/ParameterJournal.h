@@ -0,0 +1,100 @@
+#ifndef PARAMETER_JOURNAL_H
+#define PARAMETER_JOURNAL_H
+
+#include "ParameterBus.h"
+#include "SpscQueue.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+namespace DrumMachine {
+
+/**
+ * JournalRecord
+ *
+ * One journaled bus change: the host time it was published, where the
+ * transport was at that moment, and the change itself.
+ */
+struct JournalRecord {
+    uint64_t hostMicros;
+    uint64_t transportTick;
+    ParameterChange change;
+};
+static_assert(std::is_trivially_copyable<JournalRecord>::value, "Records must stay POD");
+
+/**
+ * ParameterJournal
+ *
+ * Records every change published on ParameterBus into a compact binary
+ * file for replaying a session later. Changes are taken in publish order,
+ * before the bus coalesces them, so a knob sweep or a quick on/off inside
+ * one UI frame is kept whole. Each change keeps the host time it was
+ * published at (so changes from the MIDI thread are not shifted to the
+ * next UI frame); stamps from different threads may be a little out of
+ * order. The bus callback adds the transport tick and pushes it
+ * into a lock-free ring, and a background writer thread encodes and
+ * writes it, so recording costs dispatch() one ring push. Changes that
+ * find the ring full are dropped and counted. Edits that never reach the
+ * bus are not recorded.
+ *
+ * File format (little-endian): an 8-byte header ("DMJ" + version), then
+ * 40-byte entries. Symbols are process-local ids, so the first use of a
+ * symbol is preceded by an entry defining its string, which load()
+ * interns again in the reading process.
+ */
+class ParameterJournal {
+public:
+    static constexpr size_t RING_CAPACITY = 4096;
+
+    // Transport tick at a host time (consumer thread)
+    using PositionSource = std::function<uint64_t(uint64_t hostMicros)>;
+
+    ParameterJournal();
+    ~ParameterJournal();
+
+    ParameterJournal(const ParameterJournal&) = delete;
+    ParameterJournal& operator=(const ParameterJournal&) = delete;
+
+    // Create `path` and record every change published until stop().
+    // Without a position source the transport tick is journaled as 0.
+    bool start(const std::string& path, PositionSource position = nullptr);
+
+    // Write the remaining records and close the file
+    void stop();
+
+    bool isRecording() const { return running_.load(std::memory_order_relaxed); }
+
+    // Changes written, and changes lost because the ring was full
+    uint64_t getRecordedCount() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Read a journal written by any process. A truncated final entry
+    // (e.g. after a crash) is ignored.
+    static bool load(const std::string& path, std::vector<JournalRecord>& records);
+
+private:
+    SpscQueue<JournalRecord, RING_CAPACITY> ring_;
+    ParameterSubscription subscription_;
+    PositionSource position_;
+    std::ofstream file_;
+    std::thread writer_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> recorded_;
+    std::atomic<uint64_t> dropped_;
+    std::vector<bool> writtenSymbols_;  // Writer thread: symbols already defined in the file
+
+    // Writer thread body
+    void run();
+
+    // Writer thread: encode one record (and any symbols it introduces)
+    void write(const JournalRecord& record);
+    void writeSymbol(Symbol symbol);
+};
+
+} // namespace DrumMachine
+
+#endif // PARAMETER_JOURNAL_H
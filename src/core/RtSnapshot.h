@@ -0,0 +1,93 @@
+#ifndef RT_SNAPSHOT_H
+#define RT_SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+namespace DrumMachine {
+
+/**
+ * RtSnapshot
+ *
+ * Publishes immutable versions of T from one editor thread to the audio
+ * thread with an atomic pointer swap.
+ *
+ * The audio thread calls acquire() once per block; the returned pointer
+ * stays valid until its next acquire(). A single hazard slot records the
+ * version it is using, so the editor thread can free retired versions
+ * itself (in publish()/reclaim()) and the audio thread never deletes.
+ *
+ * Threading: one writer thread (publish/reclaim/peek), one reader thread
+ * (acquire).
+ */
+template <typename T>
+class RtSnapshot {
+public:
+    RtSnapshot() : current_(nullptr), inUse_(nullptr) {}
+
+    ~RtSnapshot()
+    {
+        delete current_.load();
+        for (T* retired : retired_) {
+            delete retired;
+        }
+    }
+
+    RtSnapshot(const RtSnapshot&) = delete;
+    RtSnapshot& operator=(const RtSnapshot&) = delete;
+
+    // Writer: make `snapshot` the current version
+    void publish(std::unique_ptr<T> snapshot)
+    {
+        T* previous = current_.exchange(snapshot.release());
+        if (previous) {
+            retired_.push_back(previous);
+        }
+        reclaim();
+    }
+
+    // Writer: latest published version (owned by the writer side)
+    const T* peek() const { return current_.load(std::memory_order_acquire); }
+
+    // Reader (audio thread): pin and return the latest version
+    const T* acquire()
+    {
+        T* snapshot = current_.load();
+        for (;;) {
+            inUse_.store(snapshot);
+            T* latest = current_.load();
+            if (latest == snapshot) {
+                return snapshot;
+            }
+            snapshot = latest;
+        }
+    }
+
+    // Writer: free retired versions the reader can no longer be using
+    void reclaim()
+    {
+        T* pinned = inUse_.load();
+        auto keep = std::remove_if(retired_.begin(), retired_.end(), [pinned](T* retired) {
+            if (retired == pinned) {
+                return false;
+            }
+            delete retired;
+            return true;
+        });
+        retired_.erase(keep, retired_.end());
+    }
+
+    // Writer: versions waiting to be reclaimed
+    size_t getRetiredCount() const { return retired_.size(); }
+
+private:
+    std::atomic<T*> current_;
+    std::atomic<T*> inUse_;     // Hazard slot written by the reader
+    std::vector<T*> retired_;   // Writer-side only
+};
+
+} // namespace DrumMachine
+
+#endif // RT_SNAPSHOT_H
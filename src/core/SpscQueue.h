@@ -0,0 +1,68 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * SpscQueue
+ *
+ * Fixed-capacity lock-free ring buffer for handing POD items from one
+ * producer thread to one consumer thread. Never allocates; push() fails
+ * when the ring is full and pop() when it is empty.
+ *
+ * Threading: one producer (push), one consumer (pop).
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Items are copied between threads");
+
+public:
+    SpscQueue() : head_(0), tail_(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer: append an item; false if the ring is full
+    bool push(const T& item)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: take the oldest item; false if the ring is empty
+    bool pop(T& item)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> items_;
+    alignas(64) std::atomic<size_t> head_;  // Consumer position
+    alignas(64) std::atomic<size_t> tail_;  // Producer position
+};
+
+} // namespace DrumMachine
+
+#endif // SPSC_QUEUE_H
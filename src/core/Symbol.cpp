@@ -0,0 +1,50 @@
+#include "Symbol.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace DrumMachine {
+
+namespace {
+
+struct SymbolTable {
+    std::mutex mutex;
+    std::deque<std::string> names{std::string()};  // Indexed by id; never moves an element
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+SymbolTable& getTable()
+{
+    static SymbolTable table;
+    return table;
+}
+
+} // namespace
+
+Symbol Symbol::intern(const std::string& text)
+{
+    if (text.empty()) {
+        return Symbol();
+    }
+
+    SymbolTable& table = getTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(text);
+    if (it != table.ids.end()) {
+        return Symbol(it->second);
+    }
+
+    const uint32_t id = static_cast<uint32_t>(table.names.size());
+    table.names.push_back(text);
+    table.ids.emplace(text, id);
+    return Symbol(id);
+}
+
+const std::string& Symbol::str() const
+{
+    SymbolTable& table = getTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return id_ < table.names.size() ? table.names[id_] : table.names[0];
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,44 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * Symbol
+ *
+ * An interned string: a 4-byte id into a process-wide table, so module
+ * names and file paths can travel in trivially copyable records.
+ * Interning takes a lock and may allocate, so intern once up front (or
+ * on the UI thread), never on the audio thread. Interned strings live
+ * until exit. Id 0 is the empty string.
+ */
+class Symbol {
+public:
+    Symbol() : id_(0) {}
+
+    // Id of `text`, adding it to the table on first use
+    static Symbol intern(const std::string& text);
+
+    // The interned string (locks; the reference stays valid)
+    const std::string& str() const;
+
+    uint32_t getId() const { return id_; }
+    bool empty() const { return id_ == 0; }
+
+    bool operator==(Symbol other) const { return id_ == other.id_; }
+    bool operator!=(Symbol other) const { return id_ != other.id_; }
+
+private:
+    explicit Symbol(uint32_t id) : id_(id) {}
+
+    uint32_t id_;
+};
+static_assert(std::is_trivially_copyable<Symbol>::value, "Symbols must stay POD");
+
+} // namespace DrumMachine
+
+#endif // SYMBOL_H
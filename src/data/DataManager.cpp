@@ -2,6 +2,7 @@
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <iostream>
+#include <type_traits>
 
 using json = nlohmann::json;
 
@@ -56,6 +57,7 @@ bool DataManager::loadPattern(const std::string& filePath, Pattern& pattern)
 std::string DataManager::patternToJson(const Pattern& pattern) const
 {
     json j;
+    j["length"] = pattern.getLength();
     
     // Serialize all tracks
     for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
@@ -66,10 +68,65 @@ std::string DataManager::patternToJson(const Pattern& pattern) const
         trackJson["samplePath"] = trackObj.samplePath;
         trackJson["volume"] = trackObj.volume;
         trackJson["muted"] = trackObj.muted;
+        trackJson["length"] = trackObj.length;        // 0 = pattern length
+        trackJson["stepTicks"] = trackObj.stepTicks;
         
-        // Serialize steps
-        std::vector<uint8_t> steps(trackObj.steps.begin(), trackObj.steps.end());
+        // Serialize steps (one 0/1 entry per step of the pattern length)
+        std::vector<uint8_t> steps(pattern.getLength());
+        for (uint32_t step = 0; step < pattern.getLength(); ++step) {
+            steps[step] = trackObj.steps.test(step) ? 1 : 0;
+        }
         trackJson["steps"] = steps;
+
+        // Per-step parameters, only for active steps that differ from the defaults
+        const StepData defaults;
+        json stepDataJson = json::array();
+        for (uint32_t step = 0; step < pattern.getLength(); ++step) {
+            if (!trackObj.steps.test(step)) {
+                continue;
+            }
+            StepData data = pattern.getStepData(track, step);
+            if (data.velocity == defaults.velocity && data.probability == defaults.probability &&
+                data.microtiming == defaults.microtiming && data.ratchetCount == defaults.ratchetCount) {
+                continue;
+            }
+            stepDataJson.push_back({
+                {"step", step},
+                {"velocity", data.velocity},
+                {"probability", data.probability},
+                {"microtiming", data.microtiming},
+                {"ratchets", static_cast<uint32_t>(data.ratchetCount)},
+                {"ratchetRate", static_cast<uint32_t>(data.ratchetRate)}
+            });
+        }
+        trackJson["stepData"] = stepDataJson;
+
+        // Parameter locks, listing only the locked parameters of each step
+        json locksJson = json::array();
+        for (uint32_t step = 0; step < pattern.getLength(); ++step) {
+            if (!pattern.hasStepLocks(track, step)) {
+                continue;
+            }
+            StepLocks locks = pattern.getStepLocks(track, step);
+            json lockJson = {{"step", step}};
+            if (locks.has(StepLocks::VOLUME)) {
+                lockJson["volume"] = locks.volume;
+            }
+            if (locks.has(StepLocks::PAN)) {
+                lockJson["pan"] = locks.pan;
+            }
+            if (locks.has(StepLocks::PITCH)) {
+                lockJson["pitch"] = locks.pitch;
+            }
+            if (locks.has(StepLocks::DECAY)) {
+                lockJson["decay"] = locks.decay;
+            }
+            if (locks.has(StepLocks::SAMPLE_START)) {
+                lockJson["sampleStart"] = locks.sampleStart;
+            }
+            locksJson.push_back(lockJson);
+        }
+        trackJson["locks"] = locksJson;
         
         j["tracks"][track] = trackJson;
     }
@@ -81,6 +138,13 @@ bool DataManager::patternFromJson(const std::string& jsonString, Pattern& patter
 {
     try {
         json j = json::parse(jsonString);
+
+        // Pattern length (older files have a single 16-step bar)
+        if (j.contains("length")) {
+            pattern.setLength(j["length"].get<uint32_t>());
+        } else {
+            pattern.setLength(Pattern::STEPS_PER_BAR);
+        }
         
         // Deserialize tracks
         if (j.contains("tracks")) {
@@ -91,12 +155,49 @@ bool DataManager::patternFromJson(const std::string& jsonString, Pattern& patter
                 // Load step data
                 if (trackJson.contains("steps")) {
                     auto stepsArray = trackJson["steps"].get<std::vector<uint8_t>>();
-                    for (uint32_t step = 0; step < stepsArray.size() && step < Pattern::STEPS_PER_BAR; ++step) {
+                    pattern.clearTrackSteps(track);
+                    for (uint32_t step = 0; step < stepsArray.size() && step < Pattern::MAX_STEPS; ++step) {
                         pattern.setStepActive(track, step, stepsArray[step] != 0);
                     }
                 }
+
+                // Per-step parameters (absent in older files)
+                if (trackJson.contains("stepData")) {
+                    for (auto& stepJson : trackJson["stepData"]) {
+                        uint32_t step = stepJson.value("step", 0u);
+                        StepData data;
+                        data.velocity = stepJson.value("velocity", data.velocity);
+                        data.probability = stepJson.value("probability", data.probability);
+                        data.microtiming = stepJson.value("microtiming", data.microtiming);
+                        data.ratchetCount = stepJson.value("ratchets", 1u);
+                        data.ratchetRate = stepJson.value("ratchetRate", 2u);
+                        pattern.setStepData(track, step, data);
+                    }
+                }
+
+                // Parameter locks (absent in older files)
+                if (trackJson.contains("locks")) {
+                    for (auto& lockJson : trackJson["locks"]) {
+                        uint32_t step = lockJson.value("step", 0u);
+                        StepLocks locks;
+                        auto load = [&](const char* key, uint8_t bit, auto& field) {
+                            if (lockJson.contains(key)) {
+                                field = lockJson[key].get<std::decay_t<decltype(field)>>();
+                                locks.mask |= bit;
+                            }
+                        };
+                        load("volume", StepLocks::VOLUME, locks.volume);
+                        load("pan", StepLocks::PAN, locks.pan);
+                        load("pitch", StepLocks::PITCH, locks.pitch);
+                        load("decay", StepLocks::DECAY, locks.decay);
+                        load("sampleStart", StepLocks::SAMPLE_START, locks.sampleStart);
+                        pattern.setStepLocks(track, step, locks);
+                    }
+                }
                 
-                // Load track properties
+                // Load track properties (polymeter fields absent in older files)
+                pattern.setTrackLength(track, trackJson.value("length", 0u));
+                pattern.setTrackStepTicks(track, trackJson.value("stepTicks", Pattern::DEFAULT_STEP_TICKS));
                 if (trackJson.contains("muted")) {
                     pattern.setTrackMuted(track, trackJson["muted"].get<bool>());
                 }
@@ -116,4 +217,81 @@ bool DataManager::patternFromJson(const std::string& jsonString, Pattern& patter
     }
 }
 
+bool DataManager::loadKitMap(const std::string& filePath, KitMap& kitMap)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open kit file: " << filePath << std::endl;
+        return false;
+    }
+    std::string jsonStr((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+
+    bool result = kitMapFromJson(jsonStr, kitMap);
+    if (result) {
+        std::cout << "Kit map loaded from: " << filePath << std::endl;
+    }
+    return result;
+}
+
+bool DataManager::kitMapFromJson(const std::string& jsonString, KitMap& kitMap)
+{
+    // { "notes": [ { "note": 38, "track": 1 }, ... ],
+    //   "tracks": [ { "note": 38, "channel": 10, "velocityCurve": 1.0 }, ... ] }
+    // Channels are 1-16 as printed on gear. Any value out of range rejects
+    // the file; it is parsed into a copy, so a failure leaves `kitMap` as
+    // it was.
+    try {
+        json j = json::parse(jsonString);
+        KitMap parsed = kitMap;
+
+        // A note list replaces the whole map; unlisted notes are ignored
+        if (j.contains("notes")) {
+            parsed.clearNotes();
+            for (auto& noteJson : j["notes"]) {
+                uint32_t note = noteJson.at("note").get<uint32_t>();
+                uint32_t track = noteJson.at("track").get<uint32_t>();
+                if (note >= KitMap::NUM_NOTES || track >= KitMap::NUM_TRACKS) {
+                    std::cerr << "Kit map entry out of range: note " << note << ", track " << track << std::endl;
+                    return false;
+                }
+                parsed.setNote(static_cast<uint8_t>(note), track);
+            }
+        }
+
+        // Per-track output note, channel and velocity curve, in track order
+        if (j.contains("tracks")) {
+            auto& tracksJson = j["tracks"];
+            for (uint32_t track = 0; track < KitMap::NUM_TRACKS && track < tracksJson.size(); ++track) {
+                auto& trackJson = tracksJson[track];
+                if (trackJson.contains("note")) {
+                    uint32_t note = trackJson["note"].get<uint32_t>();
+                    if (note >= KitMap::NUM_NOTES) {
+                        std::cerr << "Kit track " << track << " note out of range: " << note << std::endl;
+                        return false;
+                    }
+                    parsed.setTrackNote(track, static_cast<uint8_t>(note));
+                }
+                if (trackJson.contains("channel")) {
+                    uint32_t channel = trackJson["channel"].get<uint32_t>();
+                    if (channel < 1 || channel > 16) {
+                        std::cerr << "Kit track " << track << " channel out of range: " << channel << std::endl;
+                        return false;
+                    }
+                    parsed.setTrackChannel(track, static_cast<uint8_t>(channel - 1));
+                }
+                if (trackJson.contains("velocityCurve")) {
+                    parsed.setVelocityCurve(track, trackJson["velocityCurve"].get<float>());
+                }
+            }
+        }
+
+        kitMap = parsed;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing kit JSON: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 } // namespace DrumMachine
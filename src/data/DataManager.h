@@ -2,6 +2,7 @@
 #define DATA_MANAGER_H
 
 #include "../sequencer/Pattern.h"
+#include "../sequencer/KitMap.h"
 #include <string>
 
 namespace DrumMachine {
@@ -29,9 +30,14 @@ public:
     // Import pattern from JSON string
     bool patternFromJson(const std::string& jsonString, Pattern& pattern);
 
-private:
-    // Helper: Convert time signature string to active steps count
-    uint32_t getActiveStepsForTimeSignature(const std::string& timeSig) const;
+    // Load a kit file's note map and velocity curves. Parts the file
+    // leaves out keep their current (General MIDI) settings; on failure
+    // (bad JSON, a note, track or channel out of range) the map is left
+    // untouched.
+    bool loadKitMap(const std::string& filePath, KitMap& kitMap);
+
+    // Import a kit map from JSON string
+    bool kitMapFromJson(const std::string& jsonString, KitMap& kitMap);
 };
 
 } // namespace DrumMachine
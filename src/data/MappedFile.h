@@ -0,0 +1,44 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace DrumMachine {
+
+/**
+ * MappedFile
+ *
+ * A whole file mapped read-only into memory, so parsers can work on its
+ * bytes in place instead of copying them into a buffer first. The
+ * mapping lives until close() or destruction.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map `path`; fails for missing or empty files
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* file_;     // HANDLE
+    void* mapping_;  // HANDLE
+#endif
+};
+
+} // namespace DrumMachine
+
+#endif // MAPPED_FILE_H
@@ -1,28 +1,21 @@
 #include "MidiFileManager.h"
+#include "SmfReader.h"
 #include "../sequencer/Pattern.h"
+#include "../sequencer/PatternSchedule.h"
+#include "../sequencer/MusicalClock.h"
+#include "../sequencer/TempoMap.h"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
 #include <iostream>
+#include <memory>
+#include <cmath>
 
 namespace DrumMachine {
 
 MidiFileManager::MidiFileManager() {
 }
 
-uint32_t MidiFileManager::readVariableLength(const uint8_t* data, size_t& offset) {
-    uint32_t value = 0;
-    uint8_t byte;
-    
-    do {
-        if (offset >= 0xFFFFFFFF) return 0; // Safety check
-        byte = data[offset++];
-        value = (value << 7) | (byte & 0x7F);
-    } while (byte & 0x80);
-    
-    return value;
-}
-
 void MidiFileManager::writeVariableLength(uint32_t value, std::vector<uint8_t>& data) {
     std::vector<uint8_t> bytes;
     bytes.push_back(value & 0x7F);
@@ -36,17 +29,6 @@ void MidiFileManager::writeVariableLength(uint32_t value, std::vector<uint8_t>&
     }
 }
 
-uint16_t MidiFileManager::bytesToUint16(const uint8_t* data) {
-    return (static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]);
-}
-
-uint32_t MidiFileManager::bytesToUint32(const uint8_t* data) {
-    return (static_cast<uint32_t>(data[0]) << 24) |
-           (static_cast<uint32_t>(data[1]) << 16) |
-           (static_cast<uint32_t>(data[2]) << 8) |
-           static_cast<uint32_t>(data[3]);
-}
-
 void MidiFileManager::writeUint16(uint16_t value, std::vector<uint8_t>& data) {
     data.push_back((value >> 8) & 0xFF);
     data.push_back(value & 0xFF);
@@ -59,23 +41,9 @@ void MidiFileManager::writeUint32(uint32_t value, std::vector<uint8_t>& data) {
     data.push_back(value & 0xFF);
 }
 
-uint32_t MidiFileManager::midiNoteToTrackIndex(uint8_t midiNote) {
-    // Map MIDI notes to drum tracks
-    // Drum Kit: C1=36 (kick), D1=38 (snare), E1=40 (hihat), etc.
-    // Map to drum tracks 0-7
-    if (midiNote >= 36 && midiNote <= 43) {
-        return midiNote - 36; // 36-43 → 0-7
-    }
-    return 0; // Default to track 0
-}
-
-uint8_t MidiFileManager::trackIndexToMidiNote(uint32_t trackIndex) {
-    // Reverse mapping: track 0-7 → MIDI note 36-43
-    return 36 + (trackIndex % 8);
-}
-
 bool MidiFileManager::exportToMidi(const std::string& filePath, const Pattern& pattern,
-                                   float tempo, uint32_t timeDivision) {
+                                   float tempo, uint32_t timeDivision,
+                                   const TempoMap* tempoMap) {
     try {
         std::ofstream file(filePath, std::ios::binary);
         if (!file) return false;
@@ -93,16 +61,38 @@ bool MidiFileManager::exportToMidi(const std::string& filePath, const Pattern& p
         // MIDI Track
         std::vector<uint8_t> trackData;
 
-        // Set Tempo event (microseconds per beat)
-        // 60,000,000 / tempo = microseconds per beat
-        uint32_t microsecondsPerBeat = static_cast<uint32_t>(60000000.0f / tempo);
-        trackData.push_back(0x00); // Delta time = 0
-        trackData.push_back(0xFF); // Meta event
-        trackData.push_back(0x51); // Set Tempo
-        trackData.push_back(0x03); // Length = 3 bytes
-        trackData.push_back(static_cast<uint8_t>((microsecondsPerBeat >> 16) & 0xFF));
-        trackData.push_back(static_cast<uint8_t>((microsecondsPerBeat >> 8) & 0xFF));
-        trackData.push_back(static_cast<uint8_t>(microsecondsPerBeat & 0xFF));
+        // Tempo changes (microseconds per beat) at MIDI ticks
+        uint32_t ticksPerStep = timeDivision / 4;
+        std::vector<std::pair<uint32_t, uint32_t>> tempoChanges;
+        if (tempoMap && !tempoMap->isEmpty()) {
+            // One tempo per step, chosen so each step ends exactly where the
+            // map says (rounding error is carried into the next step)
+            double writtenMicros = 0.0;
+            for (uint32_t step = 0; step < pattern.getLength(); ++step) {
+                double stepEnd = tempoMap->secondsAtTick(static_cast<double>(step + 1) * MusicalClock::TICKS_PER_STEP)
+                    - tempoMap->secondsAtTick(0.0);
+                uint32_t microsPerBeat = static_cast<uint32_t>(std::llround((stepEnd * 1e6 - writtenMicros) * 4.0));
+                writtenMicros += microsPerBeat / 4.0;
+                if (tempoChanges.empty() || tempoChanges.back().second != microsPerBeat) {
+                    tempoChanges.push_back({step * ticksPerStep, microsPerBeat});
+                }
+            }
+        } else {
+            // 60,000,000 / tempo = microseconds per beat
+            tempoChanges.push_back({0, static_cast<uint32_t>(60000000.0f / tempo)});
+        }
+
+        auto writeTempo = [&trackData, this](uint32_t deltaTime, uint32_t microsecondsPerBeat) {
+            writeVariableLength(deltaTime, trackData);
+            trackData.push_back(0xFF); // Meta event
+            trackData.push_back(0x51); // Set Tempo
+            trackData.push_back(0x03); // Length = 3 bytes
+            trackData.push_back(static_cast<uint8_t>((microsecondsPerBeat >> 16) & 0xFF));
+            trackData.push_back(static_cast<uint8_t>((microsecondsPerBeat >> 8) & 0xFF));
+            trackData.push_back(static_cast<uint8_t>(microsecondsPerBeat & 0xFF));
+        };
+        writeTempo(0, tempoChanges[0].second);
+        size_t nextTempo = 1;
 
         // Track Name event
         trackData.push_back(0x00); // Delta time
@@ -112,37 +102,53 @@ bool MidiFileManager::exportToMidi(const std::string& filePath, const Pattern& p
         trackData.push_back(static_cast<uint8_t>(trackName.size()));
         trackData.insert(trackData.end(), trackName.begin(), trackName.end());
 
-        // Convert pattern to MIDI events
-        uint32_t samplesPerStep = timeDivision; // Each step = 1 beat (480 ticks at 480 ticks/beat)
+        // Convert pattern to MIDI events from its compiled schedule, so
+        // velocity, microtiming, ratchets and polymetric tracks come out
+        // as they play (clock ticks are rescaled to the file's time division)
         uint32_t currentTick = 0;
 
-        for (uint32_t step = 0; step < 16; ++step) {
-            for (uint32_t track = 0; track < 8; ++track) {
-                if (pattern.isStepActive(track, step)) {
-                    uint32_t stepTick = step * samplesPerStep;
-                    uint32_t deltaTime = stepTick - currentTick;
+        std::unique_ptr<PatternSchedule> schedule = PatternSchedule::compile(pattern);
+        for (const ScheduledEvent& event : schedule->expand(schedule->getLengthTicks())) {
+            uint32_t eventTick = static_cast<uint32_t>(
+                static_cast<uint64_t>(event.tick) * timeDivision / MusicalClock::PPQN);
+
+            // Tempo changes up to this note
+            while (nextTempo < tempoChanges.size() && tempoChanges[nextTempo].first <= eventTick) {
+                uint32_t tempoTick = std::max(tempoChanges[nextTempo].first, currentTick);
+                writeTempo(tempoTick - currentTick, tempoChanges[nextTempo].second);
+                currentTick = tempoTick;
+                nextTempo++;
+            }
+            // Several notes on one tick: later notes follow the previous note-off
+            uint32_t deltaTime = eventTick > currentTick ? eventTick - currentTick : 0;
 
-                    // Note On
-                    writeVariableLength(deltaTime, trackData);
-                    trackData.push_back(0x90); // Note On, channel 0
-                    trackData.push_back(trackIndexToMidiNote(track)); // Note number
-                    trackData.push_back(100); // Velocity
+            // Note On
+            writeVariableLength(deltaTime, trackData);
+            trackData.push_back(0x90); // Note On, channel 0
+            trackData.push_back(kitMap_.noteForTrack(event.track)); // Note number
+            trackData.push_back(event.velocity); // Velocity
 
-                    currentTick = stepTick;
+            currentTick += deltaTime;
 
-                    // Note Off (very short duration)
-                    writeVariableLength(1, trackData); // Delta time = 1 tick
-                    trackData.push_back(0x80); // Note Off, channel 0
-                    trackData.push_back(trackIndexToMidiNote(track));
-                    trackData.push_back(0); // Release velocity
+            // Note Off (very short duration)
+            writeVariableLength(1, trackData); // Delta time = 1 tick
+            trackData.push_back(0x80); // Note Off, channel 0
+            trackData.push_back(kitMap_.noteForTrack(event.track));
+            trackData.push_back(0); // Release velocity
 
-                    currentTick += 1;
-                }
-            }
+            currentTick += 1;
         }
 
         // End of Track meta event
-        uint32_t finalDeltaTime = (16 * samplesPerStep) - currentTick;
+        // Remaining tempo changes after the last note
+        for (; nextTempo < tempoChanges.size(); ++nextTempo) {
+            uint32_t tempoTick = std::max(tempoChanges[nextTempo].first, currentTick);
+            writeTempo(tempoTick - currentTick, tempoChanges[nextTempo].second);
+            currentTick = tempoTick;
+        }
+
+        uint32_t patternTicks = pattern.getLength() * ticksPerStep;
+        uint32_t finalDeltaTime = patternTicks > currentTick ? patternTicks - currentTick : 0;
         writeVariableLength(finalDeltaTime, trackData);
         trackData.push_back(0xFF); // Meta event
         trackData.push_back(0x2F); // End of Track
@@ -165,190 +171,68 @@ bool MidiFileManager::exportToMidi(const std::string& filePath, const Pattern& p
 
 bool MidiFileManager::importFromMidi(const std::string& filePath, Pattern& pattern,
                                      uint32_t /* targetTrack */) {
-    try {
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file) return false;
-
-        // Read entire file
-        std::vector<uint8_t> fileData((std::istreambuf_iterator<char>(file)),
-                                       std::istreambuf_iterator<char>());
-        file.close();
-
-        size_t offset = 0;
-
-        // Check MIDI header
-        if (fileData.size() < 14 || 
-            fileData[0] != 'M' || fileData[1] != 'T' || 
-            fileData[2] != 'h' || fileData[3] != 'd') {
-            return false;
+    SmfReader reader;
+    if (!reader.open(filePath)) return false;
+
+    // 16th-note steps; SMPTE-timed files have no quarter note to divide
+    const uint32_t ticksPerStep = reader.getTicksPerQuarter() / 4u;
+    if (ticksPerStep == 0) return false;
+
+    // Notes from every track, mapped to tracks by the kit
+    const uint32_t length = pattern.getLength();
+    return reader.forEachEvent([&](const SmfEvent& event) {
+        if (!event.isNoteOn()) {
+            return;
         }
-
-        offset += 4; // Skip "MThd"
-        offset += 4; // Skip header length
-        uint16_t format = bytesToUint16(fileData.data() + offset);
-        offset += 2;
-        uint16_t numTracks = bytesToUint16(fileData.data() + offset);
-        offset += 2;
-        uint16_t timeDivision = bytesToUint16(fileData.data() + offset);
-        offset += 2;
-
-        (void)format; // Unused but parsed for completeness
-        if (numTracks == 0) return false;
-
-        // Parse first track
-        if (offset + 4 > fileData.size() ||
-            fileData[offset] != 'M' || fileData[offset + 1] != 'T' ||
-            fileData[offset + 2] != 'r' || fileData[offset + 3] != 'k') {
-            return false;
+        uint32_t track = kitMap_.trackForNote(event.data1);
+        if (track == KitMap::NO_TRACK) {
+            return;
         }
 
-        offset += 4; // Skip "MTrk"
-        uint32_t trackLength = bytesToUint32(fileData.data() + offset);
-        offset += 4;
-
-        size_t trackEnd = offset + trackLength;
-        uint32_t currentTick = 0;
-
-        // Parse MIDI events
-        while (offset < trackEnd && offset < fileData.size()) {
-            uint32_t deltaTime = readVariableLength(fileData.data(), offset);
-            currentTick += deltaTime;
-
-            if (offset >= fileData.size()) break;
-
-            uint8_t status = fileData[offset++];
-
-            // Handle meta events
-            if (status == 0xFF) {
-                if (offset >= fileData.size()) break;
-                offset++; // Skip meta type
-                uint32_t length = readVariableLength(fileData.data(), offset);
-                offset += length;
-                continue;
-            }
-
-            // Handle MIDI channel messages
-            uint8_t statusType = status & 0xF0;
-
-            if (statusType == 0x90 || statusType == 0x80) { // Note On/Off
-                if (offset + 1 >= fileData.size()) break;
-                uint8_t note = fileData[offset++];
-                uint8_t velocity = fileData[offset++];
-
-                if (statusType == 0x90 && velocity > 0) { // Note On
-                    // Convert MIDI note to step index (0-15)
-                    // Assuming 16 steps per bar, map tick to step
-                    uint32_t step = (currentTick / (static_cast<uint32_t>(timeDivision) / 4)) % 16;
-
-                    if (step < 16) {
-                        // Set step active for the appropriate track
-                        uint32_t track = midiNoteToTrackIndex(note);
-                        pattern.setStepActive(track, step, true);
-                    }
-                }
-            } else if (statusType == 0xB0) { // Control Change
-                if (offset + 1 >= fileData.size()) break;
-                offset += 2; // Skip CC controller and value
-            } else if (statusType == 0xC0) { // Program Change
-                if (offset >= fileData.size()) break;
-                offset++; // Skip program
-            } else if (statusType == 0xE0) { // Pitch Bend
-                if (offset + 1 >= fileData.size()) break;
-                offset += 2; // Skip pitch bend data
-            }
-        }
+        // Map tick to a 16th-note step, wrapping at the pattern length
+        uint32_t step = (event.tick / ticksPerStep) % length;
+        pattern.setStepActive(track, step, true);
 
-        return true;
-    } catch (...) {
-        return false;
-    }
+        StepData data = pattern.getStepData(track, step);
+        data.velocity = event.data2;
+        pattern.setStepData(track, step, data);
+    });
 }
 
 std::vector<MidiEvent> MidiFileManager::getMidiEvents(const std::string& filePath) {
     std::vector<MidiEvent> events;
-    
-    try {
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file) return events;
-
-        std::vector<uint8_t> fileData((std::istreambuf_iterator<char>(file)),
-                                       std::istreambuf_iterator<char>());
-        file.close();
-
-        size_t offset = 0;
-
-        if (fileData.size() < 14 ||
-            fileData[0] != 'M' || fileData[1] != 'T' ||
-            fileData[2] != 'h' || fileData[3] != 'd') {
-            return events;
-        }
 
-        offset += 4;
-        uint32_t headerLength = bytesToUint32(fileData.data() + offset);
-        offset += 4 + headerLength;
-
-        // Parse first track
-        if (offset + 8 > fileData.size() ||
-            fileData[offset] != 'M' || fileData[offset + 1] != 'T' ||
-            fileData[offset + 2] != 'r' || fileData[offset + 3] != 'k') {
-            return events;
-        }
-
-        offset += 4;
-        uint32_t trackLength = bytesToUint32(fileData.data() + offset);
-        offset += 4;
-
-        size_t trackEnd = offset + trackLength;
-        uint32_t currentTick = 0;
-
-        while (offset < trackEnd && offset < fileData.size()) {
-            uint32_t deltaTime = readVariableLength(fileData.data(), offset);
-            currentTick += deltaTime;
-
-            if (offset >= fileData.size()) break;
-
-            uint8_t status = fileData[offset++];
-
-            if (status == 0xFF) {
-                if (offset >= fileData.size()) break;
-                uint8_t metaType = fileData[offset++];
-                uint32_t length = readVariableLength(fileData.data(), offset);
-
-                if (metaType == 0x51) { // Set Tempo
-                    if (offset + 3 <= fileData.size()) {
-                        uint32_t tempo = (static_cast<uint32_t>(fileData[offset]) << 16) |
-                                        (static_cast<uint32_t>(fileData[offset + 1]) << 8) |
-                                        static_cast<uint32_t>(fileData[offset + 2]);
-                        events.push_back({MidiEvent::Type::META_SET_TEMPO, currentTick, 0, 0, 0, 0, 0, tempo, ""});
-                    }
-                }
-
-                offset += length;
-                continue;
+    SmfReader reader;
+    if (!reader.open(filePath)) return events;
+
+    // Events of all tracks, each track in time order (absolute ticks).
+    // A malformed track ends the list where it went wrong.
+    reader.forEachEvent([&events](const SmfEvent& event) {
+        if (event.kind == SmfEvent::Kind::Channel) {
+            const uint8_t channel = event.channel();
+            if (event.isNoteOn()) {
+                events.push_back({MidiEvent::Type::NOTE_ON, event.tick, channel, event.data1, event.data2, 0, 0, 0, ""});
+            } else if (event.isNoteOff()) {
+                events.push_back({MidiEvent::Type::NOTE_OFF, event.tick, channel, event.data1, event.data2, 0, 0, 0, ""});
+            } else if (event.type() == 0xB0) {
+                events.push_back({MidiEvent::Type::CONTROL_CHANGE, event.tick, channel, 0, 0, event.data1, event.data2, 0, ""});
+            } else if (event.type() == 0xC0) {
+                events.push_back({MidiEvent::Type::PROGRAM_CHANGE, event.tick, channel, 0, 0, 0, event.data1, 0, ""});
             }
-
-            uint8_t statusType = status & 0xF0;
-            uint8_t channel = status & 0x0F;
-
-            if (statusType == 0x90 || statusType == 0x80) {
-                if (offset + 1 >= fileData.size()) break;
-                uint8_t note = fileData[offset++];
-                uint8_t velocity = fileData[offset++];
-
-                if (statusType == 0x90) {
-                    events.push_back({MidiEvent::Type::NOTE_ON, currentTick, channel, note, velocity, 0, 0, 0, ""});
-                } else {
-                    events.push_back({MidiEvent::Type::NOTE_OFF, currentTick, channel, note, velocity, 0, 0, 0, ""});
-                }
-            } else if (statusType == 0xB0) {
-                if (offset + 1 >= fileData.size()) break;
-                uint8_t controller = fileData[offset++];
-                uint8_t value = fileData[offset++];
-                events.push_back({MidiEvent::Type::CONTROL_CHANGE, currentTick, channel, 0, 0, controller, value, 0, ""});
+        } else if (event.kind == SmfEvent::Kind::Meta) {
+            if (event.metaType == 0x51 && event.length >= 3) { // Set Tempo
+                uint32_t tempo = (static_cast<uint32_t>(event.data[0]) << 16) |
+                                 (static_cast<uint32_t>(event.data[1]) << 8) |
+                                 static_cast<uint32_t>(event.data[2]);
+                events.push_back({MidiEvent::Type::META_SET_TEMPO, event.tick, 0, 0, 0, 0, 0, tempo, ""});
+            } else if (event.metaType == 0x03) { // Sequence/Track Name
+                std::string name(reinterpret_cast<const char*>(event.data), event.length);
+                events.push_back({MidiEvent::Type::META_TRACK_NAME, event.tick, 0, 0, 0, 0, 0, 0, name});
+            } else if (event.metaType == 0x2F) { // End of Track
+                events.push_back({MidiEvent::Type::META_END_OF_TRACK, event.tick, 0, 0, 0, 0, 0, 0, ""});
             }
         }
-    } catch (...) {
-    }
+    });
 
     return events;
 }
@@ -1,6 +1,7 @@
 #ifndef MIDI_FILE_MANAGER_H
 #define MIDI_FILE_MANAGER_H
 
+#include "../sequencer/KitMap.h"
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -8,6 +9,7 @@
 namespace DrumMachine {
 
 class Pattern;
+class TempoMap;
 
 /**
  * MidiFileManager
@@ -32,7 +34,7 @@ struct MidiEvent {
     };
 
     Type type;
-    uint32_t time;           // Delta time in ticks
+    uint32_t time;           // Absolute time in ticks
     uint8_t channel;         // 0-15
     uint8_t note;            // 0-127
     uint8_t velocity;        // 0-127
@@ -46,33 +48,33 @@ class MidiFileManager {
 public:
     MidiFileManager();
 
-    // Export pattern to MIDI file
+    // Export pattern to MIDI file. With a non-empty tempo map, tempo
+    // events follow the map (ramps are written per 16th step so every
+    // step lands where the transport plays it) and `tempo` is ignored.
     bool exportToMidi(const std::string& filePath, const Pattern& pattern, 
-                      float tempo = 120.0f, uint32_t timeDivision = 480);
+                      float tempo = 120.0f, uint32_t timeDivision = 480,
+                      const TempoMap* tempoMap = nullptr);
 
-    // Import MIDI file to pattern
+    // Import MIDI file to pattern: note-ons of every track, mapped to
+    // tracks by the kit. False if the file is unreadable, SMPTE-timed or
+    // malformed (notes before the bad data are kept).
     bool importFromMidi(const std::string& filePath, Pattern& pattern, 
                         uint32_t targetTrack = 0);
 
     // Get list of notes in a MIDI file (for preview)
     std::vector<MidiEvent> getMidiEvents(const std::string& filePath);
 
+    // Note <-> track mapping used by import and export (copied)
+    void setKitMap(const KitMap& kitMap) { kitMap_ = kitMap; }
+
 private:
-    // MIDI file parsing helpers
-    uint32_t readVariableLength(const uint8_t* data, size_t& offset);
+    KitMap kitMap_;
+
+    // MIDI file writing helpers (reading goes through SmfReader)
     void writeVariableLength(uint32_t value, std::vector<uint8_t>& data);
-    
-    uint16_t bytesToUint16(const uint8_t* data);
-    uint32_t bytesToUint32(const uint8_t* data);
-    
+
     void writeUint16(uint16_t value, std::vector<uint8_t>& data);
     void writeUint32(uint32_t value, std::vector<uint8_t>& data);
-
-    // Convert MIDI note number to drum track index
-    uint32_t midiNoteToTrackIndex(uint8_t midiNote);
-    
-    // Convert track index to MIDI note number
-    uint8_t trackIndexToMidiNote(uint32_t trackIndex);
 };
 
 } // namespace DrumMachine
@@ -0,0 +1,200 @@
+#include "SmfReader.h"
+#include <cstring>
+
+namespace DrumMachine {
+
+namespace {
+
+constexpr size_t CHUNK_HEADER_SIZE = 8;
+constexpr uint32_t MIN_HEADER_LENGTH = 6;
+
+uint16_t readUint16(const uint8_t* data)
+{
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t readUint32(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) |
+           (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) |
+           static_cast<uint32_t>(data[3]);
+}
+
+} // namespace
+
+SmfTrackCursor::SmfTrackCursor(const uint8_t* begin, const uint8_t* end, uint16_t track)
+    : pos_(begin), end_(end), tick_(0), track_(track),
+      runningStatus_(0), done_(false), failed_(false)
+{
+}
+
+bool SmfTrackCursor::fail()
+{
+    failed_ = true;
+    return false;
+}
+
+bool SmfTrackCursor::readVariableLength(uint32_t& value)
+{
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (pos_ >= end_) {
+            return false;
+        }
+        const uint8_t byte = *pos_++;
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;  // More than 4 bytes
+}
+
+bool SmfTrackCursor::next(SmfEvent& event)
+{
+    if (done_ || failed_) {
+        return false;
+    }
+    if (pos_ >= end_) {
+        // No End of Track event: the chunk end closes the track
+        done_ = true;
+        return false;
+    }
+
+    uint32_t delta = 0;
+    if (!readVariableLength(delta) || pos_ >= end_) {
+        return fail();
+    }
+    tick_ += delta;
+
+    event.tick = tick_;
+    event.track = track_;
+    event.data1 = 0;
+    event.data2 = 0;
+    event.metaType = 0;
+    event.data = nullptr;
+    event.length = 0;
+
+    // A data byte where a status belongs repeats the last channel status
+    uint8_t status = *pos_;
+    if (status < 0x80) {
+        if (runningStatus_ == 0) {
+            return fail();
+        }
+        status = runningStatus_;
+    } else {
+        ++pos_;
+    }
+    event.status = status;
+
+    if (status == 0xFF || status == 0xF0 || status == 0xF7) {
+        // Meta and sysex events cancel running status
+        runningStatus_ = 0;
+        if (status == 0xFF) {
+            if (pos_ >= end_) {
+                return fail();
+            }
+            event.kind = SmfEvent::Kind::Meta;
+            event.metaType = *pos_++;
+        } else {
+            event.kind = SmfEvent::Kind::SysEx;
+        }
+
+        uint32_t length = 0;
+        if (!readVariableLength(length) || length > static_cast<size_t>(end_ - pos_)) {
+            return fail();
+        }
+        event.data = pos_;
+        event.length = length;
+        pos_ += length;
+
+        if (status == 0xFF && event.metaType == 0x2F) {
+            done_ = true;  // End of Track
+        }
+        return true;
+    }
+
+    if (status >= 0xF0) {
+        return fail();  // System common/real-time messages cannot appear in a file
+    }
+
+    runningStatus_ = status;
+    event.kind = SmfEvent::Kind::Channel;
+    const uint8_t type = status & 0xF0;
+    const size_t dataBytes = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+    if (static_cast<size_t>(end_ - pos_) < dataBytes) {
+        return fail();
+    }
+    event.data1 = *pos_++;
+    if (dataBytes == 2) {
+        event.data2 = *pos_++;
+    }
+    if ((event.data1 | event.data2) & 0x80) {
+        return fail();
+    }
+    return true;
+}
+
+SmfReader::SmfReader()
+    : format_(0), trackCount_(0), division_(0), firstChunk_(0)
+{
+}
+
+bool SmfReader::open(const std::string& path)
+{
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    if (size < CHUNK_HEADER_SIZE + MIN_HEADER_LENGTH || std::memcmp(data, "MThd", 4) != 0) {
+        close();
+        return false;
+    }
+
+    const uint32_t headerLength = readUint32(data + 4);
+    if (headerLength < MIN_HEADER_LENGTH || headerLength > size - CHUNK_HEADER_SIZE) {
+        close();
+        return false;
+    }
+
+    format_ = readUint16(data + 8);
+    trackCount_ = readUint16(data + 10);
+    division_ = readUint16(data + 12);
+    firstChunk_ = CHUNK_HEADER_SIZE + headerLength;  // Longer headers keep unknown fields
+    return true;
+}
+
+void SmfReader::close()
+{
+    file_.close();
+    format_ = 0;
+    trackCount_ = 0;
+    division_ = 0;
+    firstChunk_ = 0;
+}
+
+bool SmfReader::nextTrack(size_t& offset, const uint8_t*& begin, const uint8_t*& end) const
+{
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    while (offset <= size && size - offset >= CHUNK_HEADER_SIZE) {
+        const uint8_t* chunk = data + offset;
+        const size_t length = readUint32(chunk + 4);
+        const size_t available = size - offset - CHUNK_HEADER_SIZE;
+        const size_t body = length < available ? length : available;
+        offset += CHUNK_HEADER_SIZE + body;
+
+        if (std::memcmp(chunk, "MTrk", 4) == 0) {
+            begin = chunk + CHUNK_HEADER_SIZE;
+            end = begin + body;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,138 @@
+#ifndef SMF_READER_H
+#define SMF_READER_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace DrumMachine {
+
+/**
+ * SmfEvent
+ *
+ * One event of a Standard MIDI File. Channel events carry their status
+ * (running status already resolved) and data bytes; meta and sysex
+ * events carry a view of their payload, which points into the reader's
+ * mapping and stays valid until the reader is closed.
+ */
+struct SmfEvent {
+    enum class Kind : uint8_t { Channel, Meta, SysEx };
+
+    uint32_t tick;        // Absolute, in the file's ticks per quarter note
+    uint16_t track;       // MTrk chunk index, in file order
+    Kind kind;
+    uint8_t status;       // Channel status, 0xFF (meta) or 0xF0/0xF7 (sysex)
+    uint8_t data1;        // Channel events
+    uint8_t data2;        // Channel events with two data bytes
+    uint8_t metaType;     // Meta events
+    const uint8_t* data;  // Meta/sysex payload
+    uint32_t length;
+
+    uint8_t type() const { return status & 0xF0; }
+    uint8_t channel() const { return status & 0x0F; }
+
+    bool isNoteOn() const { return kind == Kind::Channel && type() == 0x90 && data2 > 0; }
+    bool isNoteOff() const
+    {
+        return kind == Kind::Channel && (type() == 0x80 || (type() == 0x90 && data2 == 0));
+    }
+};
+
+/**
+ * SmfTrackCursor
+ *
+ * Decodes one MTrk chunk event by event, straight from its bytes. Every
+ * read is checked against the chunk end, so truncated or corrupt data
+ * stops the walk (failed()) instead of reading past it.
+ */
+class SmfTrackCursor {
+public:
+    SmfTrackCursor(const uint8_t* begin, const uint8_t* end, uint16_t track);
+
+    // Decode the next event; false at the end of the track or on bad data
+    bool next(SmfEvent& event);
+
+    // The walk stopped on malformed data
+    bool failed() const { return failed_; }
+
+private:
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    uint32_t tick_;
+    uint16_t track_;
+    uint8_t runningStatus_;  // 0 when none is in effect
+    bool done_;
+    bool failed_;
+
+    // Variable-length quantity of at most 4 bytes
+    bool readVariableLength(uint32_t& value);
+
+    bool fail();
+};
+
+/**
+ * SmfReader
+ *
+ * Reads Standard MIDI Files (formats 0, 1 and 2) in place from a memory
+ * mapping. forEachEvent() walks every track and hands each event to a
+ * callback without building intermediate buffers; tracks are walked one
+ * after another in file order, so ticks increase within a track only.
+ * Unknown chunks are skipped, and a track whose declared length runs
+ * past the end of the file is read up to the end of the file.
+ */
+class SmfReader {
+public:
+    SmfReader();
+
+    // Map `path` and validate its header
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+
+    uint16_t getFormat() const { return format_; }
+    uint16_t getTrackCount() const { return trackCount_; }  // As declared in the header
+
+    // Ticks per quarter note; 0 for SMPTE time division
+    uint16_t getTicksPerQuarter() const { return (division_ & 0x8000) ? 0 : division_; }
+
+    // Call `callback(const SmfEvent&)` for every event of every track.
+    // False if a track holds malformed data (events before it were delivered).
+    template <typename Callback>
+    bool forEachEvent(Callback&& callback) const;
+
+private:
+    MappedFile file_;
+    uint16_t format_;
+    uint16_t trackCount_;
+    uint16_t division_;
+    size_t firstChunk_;  // Offset of the first chunk after the header
+
+    // Find the next MTrk chunk at or after `offset`, moving `offset` past it
+    bool nextTrack(size_t& offset, const uint8_t*& begin, const uint8_t*& end) const;
+};
+
+template <typename Callback>
+bool SmfReader::forEachEvent(Callback&& callback) const
+{
+    size_t offset = firstChunk_;
+    const uint8_t* begin = nullptr;
+    const uint8_t* end = nullptr;
+    uint16_t track = 0;
+    while (nextTrack(offset, begin, end)) {
+        SmfTrackCursor cursor(begin, end, track++);
+        SmfEvent event;
+        while (cursor.next(event)) {
+            callback(event);
+        }
+        if (cursor.failed()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace DrumMachine
+
+#endif // SMF_READER_H
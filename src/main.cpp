@@ -2,12 +2,15 @@
 #include "audio/AudioEngine.h"
 #include "audio/SamplePlayer.h"
 #include "audio/MidiManager.h"
+#include "audio/MidiOutput.h"
 #include "sequencer/Sequencer.h"
 #include "sequencer/Transport.h"
+#include "core/ParameterJournal.h"
+#include "core/Logger.h"
+#include "data/DataManager.h"
 #include "ui/Window.h"
-#include <iostream>
-#include <fstream>
 #include <filesystem>
+#include <cstring>
 
 using namespace DrumMachine;
 
@@ -27,16 +30,70 @@ std::string findSampleFile(const char* filename) {
     
     for (const auto& path : searchPaths) {
         if (fs::exists(path)) {
-            std::cout << "      Found: " << path << std::endl;
+            LOG_INFO("      Found: %s", path.c_str());
             return path;
         }
     }
     
     // Not found - return original filename and let dr_wav report the error
-    std::cout << "      Not found (searched in: current dir, assets/samples/)" << std::endl;
+    LOG_WARNING("      Not found (searched in: current dir, assets/samples/)");
     return filename;
 }
 
+/**
+ * Announce the starting session on the parameter bus (tempo, meter, bar
+ * count, the edited pattern's steps and the loaded samples), so a journal
+ * recorded from here can rebuild it on replay.
+ */
+void publishSession(Sequencer& sequencer, const std::vector<std::string>& samplePaths)
+{
+    ParameterBus& bus = ParameterBus::getInstance();
+    ParameterChange change;
+    change.moduleId = Symbol::intern("session");
+
+    // A dense pattern can outgrow the queue; dispatch to make room
+    auto publish = [&bus](const ParameterChange& next) {
+        if (!bus.publish(next)) {
+            bus.dispatch();
+            bus.publish(next);
+        }
+    };
+
+    change.type = ParameterType::TEMPO;
+    change.value = sequencer.getTransport().getTempo();
+    publish(change);
+
+    change.type = ParameterType::TIME_SIGNATURE;
+    change.value = static_cast<uint32_t>(sequencer.getTransport().getMeter().pack());
+    publish(change);
+
+    change.type = ParameterType::BAR_COUNT;
+    change.value = sequencer.getTransport().getBarCount();
+    publish(change);
+
+    const Pattern& pattern = sequencer.getPattern();
+    change.type = ParameterType::STEP_ACTIVE;
+    change.value = true;
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        for (uint32_t step = 0; step < pattern.getTrackLength(track); ++step) {
+            if (pattern.isStepActive(track, step)) {
+                change.trackIndex = track;
+                change.stepIndex = step;
+                publish(change);
+            }
+        }
+    }
+
+    change.type = ParameterType::TRACK_SAMPLE;
+    change.stepIndex = 0;
+    for (uint32_t track = 0; track < samplePaths.size(); ++track) {
+        change.trackIndex = track;
+        change.value = Symbol::intern(samplePaths[track]);
+        publish(change);
+    }
+    bus.dispatch();
+}
+
 /**
  * Milestone 5: MIDI Foundation
  * 
@@ -50,20 +107,36 @@ std::string findSampleFile(const char* filename) {
 int main(int argc, char* argv[])
 {
     try {
-    // Open error log file for Windows GUI apps that lose console output
-    std::ofstream logFile("DrumMachine_error.log", std::ios::app);
-    
-    std::cout << "======================================" << std::endl;
-    std::cout << "Drum Machine v" << DRUM_MACHINE_VERSION << std::endl;
-    std::cout << "Milestone 5: MIDI Foundation" << std::endl;
-    std::cout << "======================================" << std::endl;
-    std::cout << std::endl;
-    
-    logFile << "Drum Machine started" << std::endl;
-    logFile.flush();
+    // Also log to a file for Windows GUI apps that lose console output
+    Logger::getInstance().start("DrumMachine.log");
+
+    LOG_INFO("======================================");
+    LOG_INFO("Drum Machine v%s", DRUM_MACHINE_VERSION);
+    LOG_INFO("Milestone 5: MIDI Foundation");
+    LOG_INFO("======================================");
 
     // Configuration
     uint32_t sampleRate = 44100;
+
+    // --journal <file>: record every parameter change for replay
+    // --kit <file>: note map and velocity curves (General MIDI otherwise)
+    const char* journalPath = nullptr;
+    const char* kitPath = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--journal") == 0) {
+            journalPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--kit") == 0) {
+            kitPath = argv[i + 1];
+        }
+    }
+
+    KitMap kitMap;
+    if (kitPath) {
+        DataManager dataManager;
+        if (!dataManager.loadKitMap(kitPath, kitMap)) {
+            LOG_WARNING("WARNING: Failed to load kit, using General MIDI map: %s", kitPath);
+        }
+    }
     
     // Track names and sample files (8 drum kit)
     const char* trackNames[8] = {
@@ -89,22 +162,23 @@ int main(int argc, char* argv[])
     };
 
     // Initialize audio engine
-    std::cout << "[1/5] Initializing audio engine..." << std::endl;
+    LOG_INFO("[1/5] Initializing audio engine...");
     AudioEngine audioEngine(sampleRate);
+    audioEngine.setKitMap(kitMap);
     if (!audioEngine.initialize()) {
-        std::cerr << "FAILED to initialize audio engine" << std::endl;
+        LOG_ERROR("FAILED to initialize audio engine");
         return 1;
     }
-    std::cout << "      Audio engine OK" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("      Audio engine OK");
 
     // Initialize sequencer
-    std::cout << "[2/5] Initializing sequencer..." << std::endl;
+    LOG_INFO("[2/5] Initializing sequencer...");
     Sequencer sequencer(sampleRate);
+    sequencer.setKitMap(kitMap);
     audioEngine.setSequencer(&sequencer);
     sequencer.getTransport().setTempo(120.0f);
-    sequencer.getTransport().setTimeSignature("4/4");
-    sequencer.getTransport().setBarCount(1);
+    sequencer.setMeter(Meter(4, 4));
+    sequencer.setBarCount(1);
     
     // Set default pattern for testing (simple beat: kick on 1, 5, 9, 13; snare on 5, 13)
     Pattern& pattern = sequencer.getPattern();
@@ -114,58 +188,112 @@ int main(int argc, char* argv[])
     pattern.setStepActive(0, 12, true); // Kick on step 12
     pattern.setStepActive(1, 4, true);  // Snare on step 4
     pattern.setStepActive(1, 12, true); // Snare on step 12
+    sequencer.publishPendingEdits();
+    sequencer.clearUndoHistory();       // The default beat is the starting point
     
-    std::cout << "      Sequencer OK (default pattern loaded)" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("      Sequencer OK (default pattern loaded)");
 
     // Load 8 drum samples (one per track)
-    std::cout << "[3/5] Loading drum kit samples..." << std::endl;
+    LOG_INFO("[3/5] Loading drum kit samples...");
     std::vector<std::unique_ptr<SamplePlayer>> samplePlayers;
     std::vector<SamplePlayer*> rawPlayerPtrs;
+    std::vector<std::string> samplePaths;
     
     for (int track = 0; track < 8; ++track) {
         auto player = std::make_unique<SamplePlayer>(sampleRate);
         std::string fullPath = findSampleFile(sampleFiles[track]);
+        samplePaths.push_back(fullPath);
         if (!player->loadSample(fullPath)) {
-            std::cerr << "WARNING: Failed to load sample: " << sampleFiles[track] << std::endl;
+            LOG_WARNING("WARNING: Failed to load sample: %s", sampleFiles[track]);
             // Continue - allow other samples to load
         } else {
-            std::cout << "      ✓ " << trackNames[track] << std::endl;
+            LOG_INFO("      ✓ %s", trackNames[track]);
         }
         rawPlayerPtrs.push_back(player.get());
         samplePlayers.push_back(std::move(player));
     }
     
     // Wire all sample players to audio engine
-    std::cout << "\n[POINTERS] SamplePlayer addresses:" << std::endl;
+    LOG_DEBUG("[POINTERS] SamplePlayer addresses:");
     for (int track = 0; track < 8; ++track) {
         audioEngine.setSamplePlayer(track, rawPlayerPtrs[track]);
-        std::cout << "  Track " << track << ": " << static_cast<void*>(rawPlayerPtrs[track]) << std::endl;
+        LOG_DEBUG("  Track %d: %p", track, static_cast<void*>(rawPlayerPtrs[track]));
     }
-    std::cout << std::endl;
 
     // Initialize MIDI manager
-    std::cout << "[4/5] Initializing MIDI..." << std::endl;
+    LOG_INFO("[4/5] Initializing MIDI...");
     MidiManager midiManager;
     if (!midiManager.initialize()) {
-        std::cerr << "WARNING: MIDI initialization failed" << std::endl;
+        LOG_WARNING("WARNING: MIDI initialization failed");
     }
-    std::cout << "      MIDI OK" << std::endl;
-    std::cout << std::endl;
+
+    // Outgoing clock and notes go through their own sender thread
+    MidiOutput midiOutput;
+    midiOutput.setSequencer(&sequencer);
+    if (!midiOutput.initialize()) {
+        LOG_WARNING("WARNING: MIDI output initialization failed");
+    }
+
+    // Runs on the MIDI input thread. Incoming notes sound their track
+    // through the audio thread's live ring, feed live recording and are
+    // announced on the bus (for the journal); clock messages feed the
+    // clock sync. Recording and sync compensate for the time between
+    // rendering audio and hearing it.
+    sequencer.setOutputLatencyMicros(static_cast<uint32_t>(
+        uint64_t(audioEngine.getOutputLatencyFrames()) * 1000000 / sampleRate));
+    const Symbol midiInputId = Symbol::intern("midi_input");
+    midiManager.setMidiCallback([&sequencer, &kitMap, midiInputId](const MidiMessage& msg) {
+        MidiClockSync& clockSync = sequencer.getClockSync();
+        switch (msg.type) {
+            case MidiMessage::Type::NOTE_ON: {
+                const uint32_t track = kitMap.trackForNote(msg.note);
+                if (track != KitMap::NO_TRACK) {
+                    sequencer.playLiveNote(track, msg.velocity, msg.timestamp);
+                    sequencer.getRecorder().noteOn(track, msg.velocity, msg.timestamp);
+
+                    ParameterChange change;
+                    change.type = ParameterType::LIVE_NOTE;
+                    change.value = static_cast<uint32_t>(msg.velocity);
+                    change.trackIndex = track;
+                    change.moduleId = midiInputId;
+                    ParameterBus::getInstance().publish(change);
+                }
+                break;
+            }
+            case MidiMessage::Type::CLOCK:
+                clockSync.clock(msg.timestamp);
+                break;
+            case MidiMessage::Type::START:
+                clockSync.start();
+                break;
+            case MidiMessage::Type::CONTINUE:
+                clockSync.continuePlayback();
+                break;
+            case MidiMessage::Type::STOP:
+                clockSync.stop();
+                break;
+            case MidiMessage::Type::SONG_POSITION:
+                clockSync.songPosition(msg.position);
+                break;
+            default:
+                break;
+        }
+    });
+    LOG_INFO("      MIDI OK");
 
     // Initialize window and UI
-    std::cout << "[5/5] Initializing UI..." << std::endl;
+    LOG_INFO("[5/5] Initializing UI...");
     Window window(1280, 720);
     if (!window.initialize()) {
-        std::cerr << "FAILED to initialize window" << std::endl;
-        logFile << "ERROR: Failed to initialize window" << std::endl;
-        logFile.close();
+        LOG_ERROR("FAILED to initialize window");
         audioEngine.shutdown();
         return 1;
     }
     window.setAudioEngine(&audioEngine);
     window.setSequencer(&sequencer);
     window.setMidiManager(&midiManager);
+    window.setMidiOutput(&midiOutput);
+    window.setKitMap(kitMap);
     window.setSamplePlayer(rawPlayerPtrs[0]);  // Keep reference for backwards compatibility
     
     // Convert vector of unique_ptrs to array of raw pointers for UI pad triggering
@@ -173,55 +301,69 @@ int main(int argc, char* argv[])
     for (int i = 0; i < 8; ++i) {
         playerArray[i] = rawPlayerPtrs[i];
     }
-    std::cout << "[POINTERS] Passing to StepEditor:" << std::endl;
+    LOG_DEBUG("[POINTERS] Passing to StepEditor:");
     for (int i = 0; i < 8; ++i) {
-        std::cout << "  playerArray[" << i << "] = " << static_cast<void*>(playerArray[i]) << std::endl;
+        LOG_DEBUG("  playerArray[%d] = %p", i, static_cast<void*>(playerArray[i]));
     }
     window.setSamplePlayers(playerArray);
-    std::cout << "      UI OK" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("      UI OK");
+
+    // The journal stamps each change with the transport position
+    ParameterJournal journal;
+    if (journalPath) {
+        const TimelineAnchor& timeline = sequencer.getTimeline();
+        bool recording = journal.start(journalPath, [&timeline](uint64_t hostMicros) {
+            const TimelinePoint point = timeline.read();
+            if (!point.isValid()) {
+                return point.transportTick;
+            }
+            const double elapsed = (static_cast<double>(hostMicros) - static_cast<double>(point.hostMicros)) / 1e6;
+            const double tick = static_cast<double>(point.transportTick) + elapsed * point.ticksPerSecond;
+            return tick > 0.0 ? static_cast<uint64_t>(tick) : uint64_t(0);
+        });
+        if (recording) {
+            publishSession(sequencer, samplePaths);
+        }
+    }
 
-    std::cout << "Starting main event loop..." << std::endl;
-    std::cout << "Press ESC to exit" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("Starting main event loop...");
+    LOG_INFO("Press ESC to exit");
 
     // Main loop
     int frameCount = 0;
     while (window.isOpen()) {
         frameCount++;
         if (frameCount <= 5 || frameCount % 100 == 0) {
-            std::cout << "Frame " << frameCount << ", isOpen: " << window.isOpen() << std::endl;
+            LOG_DEBUG("Frame %d, isOpen: %d", frameCount, window.isOpen() ? 1 : 0);
         }
         if (!window.processFrame()) {
-            std::cout << "processFrame returned false" << std::endl;
+            LOG_INFO("processFrame returned false");
             break;
         }
     }
 
-    std::cout << std::endl;
-    std::cout << "Shutting down..." << std::endl;
+    LOG_INFO("Shutting down...");
 
     // Cleanup
     for (auto& player : samplePlayers) {
         player->stop();
     }
     window.shutdown();
+    journal.stop();
+    midiOutput.shutdown();
     midiManager.shutdown();
     audioEngine.shutdown();
 
-    std::cout << "Drum Machine shutdown cleanly" << std::endl;
-    logFile << "Shutdown successful" << std::endl;
-    logFile.close();
+    LOG_INFO("Drum Machine shutdown cleanly");
+    Logger::getInstance().stop();
     return 0;
     } catch (const std::exception& e) {
-        std::ofstream logFile("DrumMachine_error.log", std::ios::app);
-        logFile << "EXCEPTION: " << e.what() << std::endl;
-        logFile.close();
+        LOG_ERROR("EXCEPTION: %s", e.what());
+        Logger::getInstance().stop();
         return 1;
     } catch (...) {
-        std::ofstream logFile("DrumMachine_error.log", std::ios::app);
-        logFile << "UNKNOWN EXCEPTION" << std::endl;
-        logFile.close();
+        LOG_ERROR("UNKNOWN EXCEPTION");
+        Logger::getInstance().stop();
         return 1;
     }
 }
@@ -4,73 +4,709 @@
 #include "audio/MidiManager.h"
 #include "sequencer/Sequencer.h"
 #include "sequencer/Transport.h"
+#include "sequencer/MusicalClock.h"
+#include "sequencer/MidiClockFilter.h"
+#include "sequencer/MidiClockSync.h"
+#include "sequencer/TimelineAnchor.h"
+#include "core/ParameterBus.h"
+#include "core/ParameterJournal.h"
+#include "core/Logger.h"
+#include "data/SmfReader.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <array>
+#include <vector>
+#include <filesystem>
+#include <map>
 
 using namespace DrumMachine;
 
+/**
+ * Run MusicalClock through hours of simulated playback at sample rates
+ * and tempos whose ratio is not a whole number of frames per tick, in
+ * blocks of varying size, and compare it after every block with the
+ * closed-form position: tick = frames * PPQN * milliBpm / (60000 * rate),
+ * rounded down, and the first frame of the next 16th step. Any
+ * difference is drift. Returns false on the first mismatch.
+ */
+static bool runDriftSimulation()
+{
+    struct Case {
+        uint32_t sampleRate;
+        uint32_t milliBpm;
+    };
+    const Case cases[] = {{44100, 133330}, {48000, 97500}, {96000, 174999}};
+    const uint64_t simulatedHours = 6;
+
+    std::mt19937 random(2024);
+    std::uniform_int_distribution<uint32_t> blockSize(1, 2048);
+    bool ok = true;
+
+    for (const Case& c : cases) {
+        MusicalClock clock(c.sampleRate);
+        clock.setTempoMilliBpm(c.milliBpm);
+
+        // Ticks per frame = num / den, exactly
+        const uint64_t num = static_cast<uint64_t>(MusicalClock::PPQN) * c.milliBpm;
+        const uint64_t den = static_cast<uint64_t>(60000) * c.sampleRate;
+        const uint64_t totalFrames = simulatedHours * 3600 * c.sampleRate;
+
+        uint64_t frames = 0;
+        uint64_t blocks = 0;
+        bool exact = true;
+        while (frames < totalFrames && exact) {
+            const uint64_t tick = clock.getTick();
+            const uint64_t nextStep = (tick / MusicalClock::TICKS_PER_STEP + 1) * MusicalClock::TICKS_PER_STEP;
+            const uint64_t stepFrame = (nextStep * den + num - 1) / num;
+            if (frames + clock.framesUntilTick(nextStep) != stepFrame) {
+                exact = false;
+                break;
+            }
+
+            const uint32_t block = blockSize(random);
+            clock.advance(block);
+            frames += block;
+            blocks++;
+            exact = clock.getFrame() == frames && clock.getTick() == frames * num / den;
+        }
+
+        std::cout << "  " << c.sampleRate << " Hz at " << c.milliBpm / 1000.0 << " BPM: "
+                  << frames / (3600.0 * c.sampleRate) << " h in " << blocks << " blocks, tick "
+                  << clock.getTick() << (exact ? " (exact)" : " DRIFTED") << std::endl;
+        ok = ok && exact;
+    }
+
+    std::cout << (ok ? "Drift simulation passed" : "Drift simulation FAILED") << std::endl;
+    return ok;
+}
+
+/**
+ * Feed the MIDI clock filter a simulated master (no hardware needed):
+ * 120 BPM then a jump to 128 BPM, every pulse jittered like a USB
+ * interface. Reports how long the filter takes to settle on each tempo
+ * and how far the filtered tempo and pulse times stray from the true
+ * ones after that. Returns false if they stray too far.
+ */
+static bool runClockSimulation()
+{
+    const double jitterSeconds = 0.002;    // +/- 2 ms, uniform
+    const double segmentSeconds = 30.0;
+    const double maxTempoError = 0.1;      // BPM
+    const double tempos[] = {120.0, 128.0};
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<double> jitter(-jitterSeconds, jitterSeconds);
+
+    MidiClockFilter filter;
+    double trueTime = 1.0;
+    bool ok = true;
+
+    for (double bpm : tempos) {
+        const double period = 60.0 / (bpm * MidiClockFilter::PULSES_PER_QUARTER);
+        const uint32_t pulses = static_cast<uint32_t>(segmentSeconds / period);
+        const uint32_t settlePulses = pulses / 2;  // Judge the second half
+
+        double worstTempoError = 0.0;
+        double maxPhaseError = 0.0;
+        double settledAfter = 0.0;
+        double rawSquares = 0.0;
+        double filteredSquares = 0.0;
+        uint32_t measured = 0;
+
+        for (uint32_t i = 0; i < pulses; ++i) {
+            const double arrival = trueTime + jitter(random);
+            filter.pulse(arrival);
+            const double tempoError = std::fabs(filter.getBpm() - bpm);
+            if (i < settlePulses && tempoError > maxTempoError) {
+                settledAfter = (i + 1) * period;
+            }
+            if (i >= settlePulses && filter.isLocked()) {
+                const double phaseError = filter.getPulseTime() - trueTime;
+                worstTempoError = std::max(worstTempoError, tempoError);
+                maxPhaseError = std::max(maxPhaseError, std::fabs(phaseError));
+                rawSquares += (arrival - trueTime) * (arrival - trueTime);
+                filteredSquares += phaseError * phaseError;
+                measured++;
+            }
+            trueTime += period;
+        }
+
+        const double rawRms = std::sqrt(rawSquares / std::max<uint32_t>(measured, 1)) * 1000.0;
+        const double filteredRms = std::sqrt(filteredSquares / std::max<uint32_t>(measured, 1)) * 1000.0;
+        std::cout << "  " << bpm << " BPM: settled after " << settledAfter << " s, "
+                  << "tempo error <= " << worstTempoError << " BPM, "
+                  << "pulse jitter " << rawRms << " ms rms in, " << filteredRms << " ms rms out "
+                  << "(max " << maxPhaseError * 1000.0 << " ms)" << std::endl;
+
+        if (measured == 0 || worstTempoError > maxTempoError || filteredRms > rawRms * 0.5) {
+            ok = false;
+        }
+    }
+
+    std::cout << (ok ? "Clock simulation passed" : "Clock simulation FAILED") << std::endl;
+    return ok;
+}
+
+/**
+ * Slave a transport to a simulated master through MidiClockSync, the
+ * way the app wires it: pulses and Start/Stop/Continue/Song Position on
+ * the "MIDI thread", 256-frame blocks on the "audio thread" publishing
+ * the timeline the sync measures phase against. Checks that Start plays
+ * from the top, that the transport locks to the master's tempo and beat,
+ * that Stop halts it, and that a Song Position Pointer plus Continue
+ * re-phases it to the new position. Returns false if any check fails.
+ */
+static bool runClockSyncSimulation()
+{
+    const uint32_t sampleRate = 44100;
+    const uint32_t blockFrames = 256;
+    const double bpm = 126.0;
+    const double jitterSeconds = 0.001;
+    const double maxPhaseTicks = 24.0;  // About 12 ms at 126 BPM
+    const double ticksPerSecond = bpm * MusicalClock::PPQN / 60.0;
+    const double pulsePeriod = 60.0 / (bpm * MidiClockFilter::PULSES_PER_QUARTER);
+    const double blockSeconds = static_cast<double>(blockFrames) / sampleRate;
+
+    std::mt19937 random(99);
+    std::uniform_real_distribution<double> jitter(-jitterSeconds, jitterSeconds);
+
+    Transport transport;
+    transport.setSampleRate(sampleRate);
+    TimelineAnchor timeline;
+    MidiClockSync sync(transport, timeline);
+
+    double now = 1.0;
+    double nextPulse = now;
+    double nextBlock = now;
+    double masterOrigin = now;   // Host time of master tick `masterBase`
+    double masterBase = 0.0;
+    bool ok = true;
+
+    auto check = [&ok](bool passed, const char* what) {
+        std::cout << "  " << (passed ? "ok: " : "FAILED: ") << what << std::endl;
+        ok = ok && passed;
+    };
+
+    // Master minus transport beat phase, in ticks (-PPQN/2 to PPQN/2)
+    auto phaseError = [&]() {
+        const double master = masterBase + (now - masterOrigin) * ticksPerSecond;
+        double error = std::fmod(master - transport.getClock().getTickPosition(), MusicalClock::PPQN);
+        if (error > MusicalClock::PPQN / 2) {
+            error -= MusicalClock::PPQN;
+        } else if (error < -static_cast<double>(MusicalClock::PPQN / 2)) {
+            error += MusicalClock::PPQN;
+        }
+        return error;
+    };
+
+    // Both threads, in host-time order, until `until`
+    auto run = [&](double until) {
+        while (now < until) {
+            if (nextPulse <= nextBlock) {
+                now = nextPulse;
+                sync.clock(static_cast<uint64_t>((nextPulse + jitter(random)) * 1e6));
+                nextPulse += pulsePeriod;
+                continue;
+            }
+            now = nextBlock;
+            if (sync.takeRestart()) {
+                transport.reset();
+            }
+            if (transport.getPlayState() == Transport::PlayState::Playing) {
+                const double samplesPerTick = transport.getSamplesPerStep() / MusicalClock::TICKS_PER_STEP;
+                timeline.publish({static_cast<uint64_t>(now * 1e6), transport.getClock().getTick(), 0,
+                                  sampleRate / samplesPerTick, 0});
+            } else {
+                timeline.invalidate();
+            }
+            transport.advance(blockFrames);
+            nextBlock += blockSeconds;
+        }
+    };
+
+    // Ignored while disabled
+    sync.start();
+    sync.songPosition(8);
+    check(transport.getPlayState() == Transport::PlayState::Stopped && !sync.takeRestart(),
+          "messages ignored while sync is off");
+
+    sync.setEnabled(true);
+    run(now + 2.0);  // Master clock running, stopped
+
+    // Start: the next pulse is the top of the song
+    now = nextPulse;
+    sync.start();
+    masterOrigin = nextPulse;
+    masterBase = 0.0;
+    check(transport.getPlayState() == Transport::PlayState::Playing, "Start plays the transport");
+    run(now + 20.0);
+    check(std::fabs(transport.getTempo() - bpm) < 0.5, "transport follows the master tempo");
+    check(std::fabs(phaseError()) < maxPhaseTicks, "transport beat locked to the master after Start");
+
+    // Stop: the transport holds its position while pulses keep coming
+    sync.stop();
+    run(now + blockSeconds);
+    const uint64_t stoppedTick = transport.getClock().getTick();
+    run(now + 2.0);
+    check(transport.getPlayState() == Transport::PlayState::Stopped
+              && transport.getClock().getTick() == stoppedTick,
+          "Stop halts the transport");
+
+    // Song Position half a beat off the current phase, then Continue
+    const uint32_t position = static_cast<uint32_t>(transport.getClock().getTick() / MusicalClock::PPQN) * 4 + 2;
+    now = nextPulse;
+    sync.songPosition(position);
+    sync.continuePlayback();
+    masterOrigin = nextPulse;
+    masterBase = static_cast<double>(position) * MusicalClock::TICKS_PER_STEP;
+    const double offBy = std::fabs(phaseError());
+    run(now + 20.0);
+    check(offBy > MusicalClock::PPQN / 4 && std::fabs(phaseError()) < maxPhaseTicks,
+          "Song Position + Continue re-phases the transport");
+    check(transport.getClock().getTick() > stoppedTick && !sync.takeRestart(),
+          "Continue resumes without restarting");
+
+    std::cout << (ok ? "Clock sync simulation passed" : "Clock sync simulation FAILED") << std::endl;
+    return ok;
+}
+
+/**
+ * Time ParameterBus publish() (including its dispatch()) and
+ * getParameterValue() on the kinds of changes the app sends (per-track
+ * floats, per-step flags), and a per-frame CC sweep with and without
+ * coalescing.
+ */
+static void runParameterBenchmark()
+{
+    const uint32_t iterations = 1000000;
+    ParameterBus& bus = ParameterBus::getInstance();
+    bus.reset();
+
+    ParameterChange change;
+    change.moduleId = Symbol::intern("benchmark");
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        if (i & 1) {
+            change.type = ParameterType::TRACK_VOLUME;
+            change.value = 0.5f;
+        } else {
+            change.type = ParameterType::STEP_ACTIVE;
+            change.value = true;
+        }
+        change.trackIndex = i % 8;
+        change.stepIndex = i % 16;
+        bus.publish(change);
+        if (i % (ParameterBus::QUEUE_CAPACITY / 2) == 0) {
+            bus.dispatch();
+        }
+    }
+    bus.dispatch();
+    auto published = std::chrono::steady_clock::now();
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        ParameterValue value = bus.getParameterValue(ParameterType::TRACK_VOLUME, i % 8);
+        if (const float* volume = std::get_if<float>(&value)) {
+            sum += *volume;
+        }
+    }
+    auto read = std::chrono::steady_clock::now();
+
+    const double publishNs = std::chrono::duration<double, std::nano>(published - start).count() / iterations;
+    const double getNs = std::chrono::duration<double, std::nano>(read - published).count() / iterations;
+    std::cout << "ParameterBus: publish " << publishNs << " ns, get " << getNs << " ns"
+              << " (checksum " << sum << ", dropped " << bus.getDroppedCount() << ")" << std::endl;
+
+    // A fast CC7 sweep on 4 tracks: ~17 changes per track per 60 Hz frame
+    const uint32_t frames = 10000;
+    const uint32_t changesPerFrame = 68;
+    uint64_t batchChanges = 0;
+    for (bool coalescing : {false, true}) {
+        bus.reset();
+        bus.setCoalescing(coalescing);
+        batchChanges = 0;
+        ParameterSubscription volume = bus.subscribe(ParameterType::TRACK_VOLUME,
+                                                     [&sum](const ParameterChange& change) {
+                                                         sum += std::get<float>(change.value);
+                                                     });
+        ParameterSubscription batch = bus.subscribeBatch([&batchChanges](const ParameterBatch& changes) {
+            batchChanges += changes.size;
+        });
+
+        change.type = ParameterType::TRACK_VOLUME;
+        const uint64_t deliveredBefore = bus.getDeliveredCount();
+        auto sweepStart = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            for (uint32_t i = 0; i < changesPerFrame; ++i) {
+                change.trackIndex = i % 4;
+                change.value = static_cast<float>(i) / changesPerFrame;
+                bus.publish(change);
+            }
+            bus.dispatch();
+        }
+        auto sweepEnd = std::chrono::steady_clock::now();
+
+        const double sweepNs = std::chrono::duration<double, std::nano>(sweepEnd - sweepStart).count()
+                             / (static_cast<double>(frames) * changesPerFrame);
+        std::cout << "CC sweep" << (coalescing ? " (coalescing): " : ": ") << sweepNs
+                  << " ns per change, " << (bus.getDeliveredCount() - deliveredBefore) / frames
+                  << " of " << changesPerFrame << " delivered per frame, "
+                  << batchChanges / frames << " per batch" << std::endl;
+    }
+    bus.setCoalescing(false);
+    bus.reset();
+}
+
+/**
+ * Replay a parameter journal (recorded with DrumMachine --journal) through
+ * a fresh sequencer and the offline renderer. Each change is applied at
+ * the frame of its host time, counted from the journal's earliest stamp
+ * (blocks are split there), so a journal always renders the same audio;
+ * pad hits sound on that frame rather than a device block later. The
+ * hash of the rendered samples identifies it for regression runs. Sample
+ * paths in the journal are resolved from the current directory.
+ *
+ * Replayed: tempo, swing, meter, bar count, play/stop, the edited bank
+ * slot, step on/off (with the click's audition), step data, parameter
+ * locks, track length and rate, mutes, samples, tempo map on/off and pad
+ * hits. Undo/redo, song chain and mode, lanes, tempo map points, live
+ * recording and MIDI clock sync only leave a marker in the journal; if
+ * one is present the render diverges from the session from there on,
+ * and a warning names them.
+ */
+static bool runReplay(const char* path)
+{
+    const uint32_t sampleRate = 44100;
+    const uint32_t blockFrames = 256;
+    const uint64_t tailFrames = sampleRate * 2;  // Let the last hits ring out
+
+    std::vector<JournalRecord> records;
+    if (!ParameterJournal::load(path, records)) {
+        return false;
+    }
+    if (records.empty()) {
+        std::cerr << "Journal has no changes: " << path << std::endl;
+        return false;
+    }
+
+    // Same starting point as the app
+    AudioEngine engine(sampleRate);
+    Sequencer sequencer(sampleRate);
+    engine.setSequencer(&sequencer);
+    sequencer.setMeter(Meter(4, 4));
+    sequencer.setBarCount(1);
+    std::array<std::unique_ptr<SamplePlayer>, AudioEngine::NUM_TRACKS> players;
+    for (int track = 0; track < AudioEngine::NUM_TRACKS; ++track) {
+        players[track] = std::make_unique<SamplePlayer>(sampleRate);
+        engine.setSamplePlayer(track, players[track].get());
+    }
+
+    // Apply journaled changes the way the UI made them
+    ParameterBus& bus = ParameterBus::getInstance();
+    bus.reset();
+    const Symbol stepEditorId = Symbol::intern("step_editor");
+    std::map<std::string, uint32_t> opaqueEdits;  // Edits this replay can't reproduce
+    uint64_t frame = 0;
+    uint64_t divergeFrame = 0;
+    ParameterSubscription apply = bus.subscribeToAll([&](const ParameterChange& change) {
+        Transport& transport = sequencer.getTransport();
+        Pattern& pattern = sequencer.getPattern();
+        switch (change.type) {
+            case ParameterType::TEMPO:
+                transport.setTempo(std::get<float>(change.value));
+                break;
+            case ParameterType::SWING:
+                transport.setSwing(std::get<float>(change.value));
+                break;
+            case ParameterType::TIME_SIGNATURE:
+                sequencer.setMeter(Meter::unpack(static_cast<uint16_t>(std::get<uint32_t>(change.value))));
+                break;
+            case ParameterType::PLAY_STATE:
+                if (std::get<bool>(change.value)) {
+                    transport.play();
+                } else {
+                    transport.stop();
+                }
+                break;
+            case ParameterType::BAR_COUNT:
+                sequencer.setBarCount(std::get<uint32_t>(change.value));
+                break;
+            case ParameterType::TEMPO_MAP_ENABLED:
+                transport.setTempoMapEnabled(std::get<bool>(change.value));
+                break;
+            case ParameterType::PATTERN_SLOT:
+                if (std::get<uint32_t>(change.value) < Sequencer::NUM_PATTERN_SLOTS) {
+                    sequencer.selectPattern(std::get<uint32_t>(change.value));
+                }
+                break;
+            case ParameterType::STEP_ACTIVE:
+                pattern.setStepActive(change.trackIndex, change.stepIndex, std::get<bool>(change.value));
+                // A click in the step editor also auditions the track
+                if (change.moduleId == stepEditorId && change.trackIndex < players.size()) {
+                    players[change.trackIndex]->trigger();
+                }
+                break;
+            case ParameterType::STEP_DATA:
+                pattern.setStepData(change.trackIndex, change.stepIndex,
+                                    StepData::unpack(std::get<uint32_t>(change.value)));
+                break;
+            case ParameterType::STEP_LOCKS:
+                pattern.setStepLocks(change.trackIndex, change.stepIndex,
+                                     StepLocks::unpack(std::get<uint64_t>(change.value)));
+                break;
+            case ParameterType::TRACK_LENGTH:
+                if (change.trackIndex < Pattern::NUM_TRACKS) {
+                    pattern.setTrackLength(change.trackIndex, std::get<uint32_t>(change.value));
+                }
+                break;
+            case ParameterType::TRACK_STEP_TICKS:
+                if (change.trackIndex < Pattern::NUM_TRACKS) {
+                    pattern.setTrackStepTicks(change.trackIndex, std::get<uint32_t>(change.value));
+                }
+                break;
+            case ParameterType::TRACK_MUTED:
+                pattern.setTrackMuted(change.trackIndex, std::get<bool>(change.value));
+                break;
+            case ParameterType::LIVE_NOTE:
+                // An old host time sounds at the start of the next block
+                sequencer.playLiveNote(change.trackIndex, static_cast<uint8_t>(std::get<uint32_t>(change.value)), 0);
+                break;
+            case ParameterType::OPAQUE_EDIT:
+                if (opaqueEdits.empty()) {
+                    divergeFrame = frame;
+                }
+                opaqueEdits[std::get<Symbol>(change.value).str()]++;
+                break;
+            case ParameterType::TRACK_SAMPLE:
+                if (change.trackIndex < players.size()) {
+                    const std::string& samplePath = std::get<Symbol>(change.value).str();
+                    if (!players[change.trackIndex]->loadSample(samplePath)) {
+                        std::cerr << "WARNING: Failed to load sample: " << samplePath << std::endl;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    });
+
+    // Frame of each change. Stamps taken on different threads can be a
+    // little out of order, so count from the earliest one and never place
+    // a change ahead of the one before it in the file (publish order).
+    uint64_t startMicros = records.front().hostMicros;
+    for (const JournalRecord& record : records) {
+        startMicros = std::min(startMicros, record.hostMicros);
+    }
+    std::vector<uint64_t> changeFrames(records.size());
+    uint64_t latestFrame = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        latestFrame = std::max(latestFrame, (records[i].hostMicros - startMicros) * sampleRate / 1000000);
+        changeFrames[i] = latestFrame;
+    }
+
+    std::vector<float> block(blockFrames * 2);
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a over the sample bits
+    uint64_t endFrame = 0;
+    size_t next = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        bool applied = false;
+        while (next < records.size() && changeFrames[next] <= frame) {
+            if (!bus.publish(records[next].change)) {
+                bus.dispatch();
+                bus.publish(records[next].change);
+            }
+            next++;
+            applied = true;
+        }
+        if (applied) {
+            bus.dispatch();
+            sequencer.publishPendingEdits();
+        }
+        if (next == records.size() && endFrame == 0) {
+            endFrame = frame + tailFrames;
+        }
+        if (endFrame != 0 && frame >= endFrame) {
+            break;
+        }
+
+        // Render up to the next change (or the end of the tail)
+        uint64_t frames = blockFrames;
+        if (next < records.size()) {
+            frames = std::min(frames, changeFrames[next] - frame);
+        } else {
+            frames = std::min(frames, endFrame - frame);
+        }
+        engine.renderOffline(block.data(), static_cast<uint32_t>(frames));
+        for (uint64_t i = 0; i < frames * 2; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, &block[i], sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+        frame += frames;
+    }
+    auto end = std::chrono::steady_clock::now();
+    bus.reset();
+
+    const double audioSeconds = static_cast<double>(frame) / sampleRate;
+    const double renderSeconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Replayed " << records.size() << " changes: " << audioSeconds << " s of audio in "
+              << renderSeconds * 1000.0 << " ms (" << audioSeconds / std::max(renderSeconds, 1e-9)
+              << "x realtime), hash " << std::hex << hash << std::dec << std::endl;
+    if (!opaqueEdits.empty()) {
+        std::cerr << "WARNING: the journal holds edits replay can't reproduce, so the render differs "
+                  << "from the session from " << static_cast<double>(divergeFrame) / sampleRate << " s:";
+        for (const auto& edit : opaqueEdits) {
+            std::cerr << " " << edit.first << " (x" << edit.second << ")";
+        }
+        std::cerr << std::endl;
+    }
+    return true;
+}
+
+/**
+ * Time SmfReader over a corpus of MIDI files: each file is mapped and
+ * walked repeatedly (every track, every event) for at least 50 ms, and
+ * the per-file time is reported alongside the event and note counts.
+ */
+static bool runSmfBenchmark(int fileCount, char* files[])
+{
+    const double minSeconds = 0.05;
+    bool ok = true;
+    uint64_t totalBytes = 0;
+    uint64_t totalEvents = 0;
+    double totalSeconds = 0.0;
+
+    for (int i = 0; i < fileCount; ++i) {
+        uint64_t events = 0;
+        uint64_t notes = 0;
+        std::error_code error;
+        const uint64_t bytes = std::filesystem::file_size(files[i], error);
+        uint32_t passes = 0;
+        bool parsed = true;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        while (seconds < minSeconds) {
+            SmfReader reader;
+            if (!reader.open(files[i])) {
+                parsed = false;
+                break;
+            }
+            events = 0;
+            notes = 0;
+            parsed = reader.forEachEvent([&events, &notes](const SmfEvent& event) {
+                ++events;
+                notes += event.isNoteOn() ? 1 : 0;
+            });
+            ++passes;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (passes == 0) {
+            std::cerr << "Not a MIDI file: " << files[i] << std::endl;
+            ok = false;
+            continue;
+        }
+
+        const double micros = seconds * 1e6 / passes;
+        std::cout << files[i] << ": " << events << " events, " << notes << " notes, "
+                  << micros << " us per parse" << (parsed ? "" : " (malformed)") << std::endl;
+        totalBytes += bytes;
+        totalEvents += events;
+        totalSeconds += seconds / passes;
+        ok = ok && parsed;
+    }
+
+    if (totalSeconds > 0.0) {
+        std::cout << "SMF corpus: " << totalEvents / totalSeconds / 1e6 << " M events/s, "
+                  << totalBytes / totalSeconds / 1e6 << " MB/s" << std::endl;
+    }
+    return ok;
+}
+
 /**
  * CLI Version - No UI
  * Tests core audio/sequencer functionality without SDL2/OpenGL
  */
 int main(int argc, char* argv[])
 {
-    std::cout << "======================================" << std::endl;
-    std::cout << "Drum Machine v" << DRUM_MACHINE_VERSION << std::endl;
-    std::cout << "Milestone 5: MIDI Foundation (CLI)" << std::endl;
-    std::cout << "======================================" << std::endl;
-    std::cout << std::endl;
+    // Console only; the file log belongs to the app
+    Logger::getInstance().start();
+
+    if (argc > 1 && std::strcmp(argv[1], "--clock-sim") == 0) {
+        const bool filterOk = runClockSimulation();
+        const bool syncOk = runClockSyncSimulation();
+        return filterOk && syncOk ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--drift-sim") == 0) {
+        return runDriftSimulation() ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-params") == 0) {
+        runParameterBenchmark();
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--replay") == 0) {
+        return runReplay(argv[2]) ? 0 : 1;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--bench-smf") == 0) {
+        return runSmfBenchmark(argc - 2, argv + 2) ? 0 : 1;
+    }
+
+    LOG_INFO("======================================");
+    LOG_INFO("Drum Machine v%s", DRUM_MACHINE_VERSION);
+    LOG_INFO("Milestone 5: MIDI Foundation (CLI)");
+    LOG_INFO("======================================");
 
     // Configuration
     uint32_t sampleRate = 44100;
     std::string samplePath = "assets/samples/test_kick.wav";
 
     // Initialize audio engine
-    std::cout << "[1/4] Initializing audio engine..." << std::endl;
+    LOG_INFO("[1/4] Initializing audio engine...");
     AudioEngine audioEngine(sampleRate);
     if (!audioEngine.initialize()) {
-        std::cerr << "FAILED to initialize audio engine" << std::endl;
+        LOG_ERROR("FAILED to initialize audio engine");
         return 1;
     }
-    std::cout << "      Audio engine OK" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("      Audio engine OK");
 
     // Initialize sequencer
-    std::cout << "[2/4] Initializing sequencer..." << std::endl;
+    LOG_INFO("[2/4] Initializing sequencer...");
     Sequencer sequencer(sampleRate);
     audioEngine.setSequencer(&sequencer);
     sequencer.getTransport().setTempo(120.0f);
-    sequencer.getTransport().setTimeSignature("4/4");
-    sequencer.getTransport().setBarCount(1);
-    std::cout << "      Sequencer OK" << std::endl;
-    std::cout << std::endl;
+    sequencer.setMeter(Meter(4, 4));
+    sequencer.setBarCount(1);
+    LOG_INFO("      Sequencer OK");
 
     // Load sample
-    std::cout << "[3/4] Loading sample..." << std::endl;
+    LOG_INFO("[3/4] Loading sample...");
     SamplePlayer samplePlayer(sampleRate);
     if (!samplePlayer.loadSample(samplePath)) {
-        std::cerr << "FAILED to load sample: " << samplePath << std::endl;
+        LOG_ERROR("FAILED to load sample: %s", samplePath.c_str());
         audioEngine.shutdown();
         return 1;
     }
-    std::cout << "      Sample OK (" << samplePlayer.getDurationSeconds() << " seconds)" << std::endl;
+    LOG_INFO("      Sample OK (%g seconds)", samplePlayer.getDurationSeconds());
     samplePlayer.start();
-    std::cout << std::endl;
 
     // Initialize MIDI manager
-    std::cout << "[4/4] Initializing MIDI..." << std::endl;
+    LOG_INFO("[4/4] Initializing MIDI...");
     MidiManager midiManager;
     if (!midiManager.initialize()) {
-        std::cout << "      WARNING: MIDI initialization failed (continuing without MIDI)" << std::endl;
+        LOG_WARNING("      WARNING: MIDI initialization failed (continuing without MIDI)");
     } else {
-        std::cout << "      MIDI OK" << std::endl;
+        LOG_INFO("      MIDI OK");
     }
-    std::cout << std::endl;
-
-    std::cout << "Audio engine running for 30 seconds..." << std::endl;
-    std::cout << "Press Ctrl+C to exit early" << std::endl;
-    std::cout << std::endl;
+    LOG_INFO("Audio engine running for 30 seconds...");
+    LOG_INFO("Press Ctrl+C to exit early");
 
     // Run for 30 seconds
     auto start = std::chrono::steady_clock::now();
@@ -83,17 +719,17 @@ int main(int argc, char* argv[])
         std::cout << "\rRunning: " << seconds << " seconds (" << frames << " frames)" << std::flush;
     }
 
-    std::cout << std::endl << std::endl;
-    std::cout << "Test complete!" << std::endl;
-    std::cout << "Total frames processed: " << audioEngine.getTotalFramesProcessed() << std::endl;
     std::cout << std::endl;
+    LOG_INFO("Test complete!");
+    LOG_INFO("Total frames processed: %llu", static_cast<unsigned long long>(audioEngine.getTotalFramesProcessed()));
 
     // Cleanup
-    std::cout << "Shutting down..." << std::endl;
+    LOG_INFO("Shutting down...");
     samplePlayer.stop();
     midiManager.shutdown();
     audioEngine.shutdown();
 
-    std::cout << "Drum Machine shutdown cleanly" << std::endl;
+    LOG_INFO("Drum Machine shutdown cleanly");
+    Logger::getInstance().stop();
     return 0;
 }
@@ -0,0 +1,77 @@
+#include "KitMap.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DrumMachine {
+
+KitMap::KitMap()
+{
+    // General MIDI drum notes onto the default kit: kick, snare, closed
+    // hat, open hat, high/mid/low tom, ride
+    struct Route { uint8_t note; uint8_t track; };
+    static const Route GENERAL_MIDI[] = {
+        {35, 0}, {36, 0},                    // Acoustic/electric bass drum
+        {37, 1}, {38, 1}, {39, 1}, {40, 1},  // Side stick, snares, clap
+        {42, 2}, {44, 2},                    // Closed and pedal hi-hat
+        {46, 3},                             // Open hi-hat
+        {48, 4}, {50, 4},                    // High toms
+        {45, 5}, {47, 5},                    // Low and low-mid tom
+        {41, 6}, {43, 6},                    // Floor toms
+        {49, 7}, {51, 7}, {52, 7}, {53, 7}, {55, 7}, {57, 7}, {59, 7}  // Cymbals
+    };
+    static const uint8_t EXPORT_NOTES[NUM_TRACKS] = {36, 38, 42, 46, 50, 47, 43, 51};
+    static constexpr uint8_t DRUM_CHANNEL = 9;  // Channel 10
+
+    clearNotes();
+    for (const Route& route : GENERAL_MIDI) {
+        noteTracks_[route.note] = route.track;
+    }
+    for (uint32_t track = 0; track < NUM_TRACKS; ++track) {
+        trackNotes_[track] = EXPORT_NOTES[track];
+        trackChannels_[track] = DRUM_CHANNEL;
+        setVelocityCurve(track, 1.0f);
+    }
+}
+
+void KitMap::setNote(uint8_t note, uint32_t track)
+{
+    noteTracks_[note & 0x7F] = track < NUM_TRACKS ? static_cast<uint8_t>(track) : NO_TRACK;
+}
+
+void KitMap::clearNotes()
+{
+    noteTracks_.fill(NO_TRACK);
+}
+
+void KitMap::setTrackNote(uint32_t track, uint8_t note)
+{
+    if (track < NUM_TRACKS) {
+        trackNotes_[track] = note & 0x7F;
+    }
+}
+
+void KitMap::setTrackChannel(uint32_t track, uint8_t channel)
+{
+    if (track < NUM_TRACKS) {
+        trackChannels_[track] = channel & 0x0F;
+    }
+}
+
+void KitMap::setVelocityCurve(uint32_t track, float exponent)
+{
+    if (track >= NUM_TRACKS) {
+        return;
+    }
+    exponent = std::max(0.0f, exponent);
+    curves_[track] = exponent;
+
+    std::array<float, NUM_NOTES>& gains = gains_[track];
+    gains[0] = 0.0f;
+    for (uint32_t velocity = 1; velocity < NUM_NOTES; ++velocity) {
+        // Linear matches the engine's plain velocity / 127 exactly
+        const float linear = velocity / 127.0f;
+        gains[velocity] = exponent == 1.0f ? linear : std::pow(linear, exponent);
+    }
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,70 @@
+#ifndef KIT_MAP_H
+#define KIT_MAP_H
+
+#include "Pattern.h"
+#include <cstdint>
+#include <array>
+
+namespace DrumMachine {
+
+/**
+ * KitMap
+ *
+ * How MIDI notes reach the kit's tracks: a 128-entry note -> track table
+ * shared by live MIDI input and MIDI file import/export, and a
+ * precomputed velocity -> gain table per track, so mapping a note or a
+ * velocity is one array index. Each track also has the note and channel
+ * it is written as (MIDI files, MIDI note output). Defaults to the
+ * General MIDI drum map on channel 10 with linear curves; a kit file
+ * (DataManager::loadKitMap) overrides it.
+ *
+ * Threading: set up before audio starts; read-only afterwards.
+ */
+class KitMap {
+public:
+    static constexpr uint32_t NUM_TRACKS = Pattern::NUM_TRACKS;
+    static constexpr uint32_t NUM_NOTES = 128;
+    static constexpr uint8_t NO_TRACK = 0xFF;
+
+    KitMap();
+
+    // Track a note plays, NO_TRACK if unmapped
+    uint32_t trackForNote(uint8_t note) const { return noteTracks_[note & 0x7F]; }
+
+    // Note a track is written as in exported MIDI files and note output
+    uint8_t noteForTrack(uint32_t track) const { return trackNotes_[track % NUM_TRACKS]; }
+
+    // Channel (0-15) a track's notes are sent on
+    uint8_t channelForTrack(uint32_t track) const { return trackChannels_[track % NUM_TRACKS]; }
+
+    // Gain (0-1) of a hit at `velocity` on `track`
+    float gainFor(uint32_t track, uint32_t velocity) const { return gains_[track % NUM_TRACKS][velocity & 0x7F]; }
+
+    // Route `note` to `track` (NO_TRACK unmaps it)
+    void setNote(uint8_t note, uint32_t track);
+
+    // Unmap every note
+    void clearNotes();
+
+    // Note used for `track` in exported files and note output
+    void setTrackNote(uint32_t track, uint8_t note);
+
+    // Channel (0-15) used for `track` in note output
+    void setTrackChannel(uint32_t track, uint8_t channel);
+
+    // Velocity curve: gain = (velocity / 127) ^ exponent. 1 is linear,
+    // above 1 softer, below 1 harder, 0 ignores velocity.
+    void setVelocityCurve(uint32_t track, float exponent);
+    float getVelocityCurve(uint32_t track) const { return curves_[track % NUM_TRACKS]; }
+
+private:
+    std::array<uint8_t, NUM_NOTES> noteTracks_;
+    std::array<uint8_t, NUM_TRACKS> trackNotes_;
+    std::array<uint8_t, NUM_TRACKS> trackChannels_;
+    std::array<float, NUM_TRACKS> curves_;
+    std::array<std::array<float, NUM_NOTES>, NUM_TRACKS> gains_;
+};
+
+} // namespace DrumMachine
+
+#endif // KIT_MAP_H
@@ -0,0 +1,43 @@
+#include "LiveRecorder.h"
+#include "Pattern.h"
+#include "../core/Logger.h"
+#include <cmath>
+
+namespace DrumMachine {
+
+LiveRecorder::LiveRecorder(const TimelineAnchor& timeline)
+    : timeline_(timeline), armed_(false), quantize_(true), inputLatency_(0), outputLatency_(0)
+{
+}
+
+bool LiveRecorder::noteOn(uint32_t track, uint8_t velocity, uint64_t timestampMicros)
+{
+    if (!isArmed() || track >= Pattern::NUM_TRACKS || velocity == 0) {
+        return false;
+    }
+
+    const TimelinePoint anchor = timeline_.read();
+    if (!anchor.isValid()) {
+        return false;
+    }
+
+    // The player reacted to what they heard: the note left their hands an
+    // input latency ago, and what they heard was rendered an output
+    // latency before that
+    const int64_t playedMicros = static_cast<int64_t>(timestampMicros)
+        - getInputLatencyMicros() - getOutputLatencyMicros();
+    const double offsetSeconds = static_cast<double>(playedMicros - static_cast<int64_t>(anchor.hostMicros)) * 1e-6;
+
+    RecordedHit hit;
+    hit.laneTick = anchor.laneTick + static_cast<int64_t>(std::llround(offsetSeconds * anchor.ticksPerSecond));
+    hit.slot = anchor.slot;
+    hit.track = static_cast<uint8_t>(track);
+    hit.velocity = velocity;
+    if (!hits_.push(hit)) {
+        LOG_WARNING("[RECORD] Hit queue full, note dropped");
+        return false;
+    }
+    return true;
+}
+
+} // namespace DrumMachine
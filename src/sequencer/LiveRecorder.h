@@ -0,0 +1,78 @@
+#ifndef LIVE_RECORDER_H
+#define LIVE_RECORDER_H
+
+#include "TimelineAnchor.h"
+#include "../core/SpscQueue.h"
+#include <cstdint>
+#include <atomic>
+
+namespace DrumMachine {
+
+/**
+ * RecordedHit
+ *
+ * One played note, already placed on the timeline of the lane it was
+ * played against (clock ticks since that lane started).
+ */
+struct RecordedHit {
+    int64_t laneTick;
+    uint32_t slot;     // Bank slot that was playing
+    uint8_t track;
+    uint8_t velocity;
+};
+
+/**
+ * LiveRecorder
+ *
+ * Turns timestamped MIDI notes into pattern hits while the transport
+ * plays. A note's host time, minus input and output latency, is placed on
+ * the main lane through the sequencer's TimelineAnchor, so positions
+ * never drift however long the session runs.
+ *
+ * Hits travel through a lock-free queue to the thread that owns the
+ * patterns, which writes them as quantized or microtimed steps.
+ *
+ * Threading: settings from the UI thread, noteOn() from one MIDI thread,
+ * takeHit() from the UI thread.
+ */
+class LiveRecorder {
+public:
+    explicit LiveRecorder(const TimelineAnchor& timeline);
+
+    void setArmed(bool armed) { armed_.store(armed, std::memory_order_relaxed); }
+    bool isArmed() const { return armed_.load(std::memory_order_relaxed); }
+
+    // Snap hits to the track's step grid; otherwise the offset is kept
+    // as microtiming
+    void setQuantize(bool quantize) { quantize_.store(quantize, std::memory_order_relaxed); }
+    bool isQuantize() const { return quantize_.load(std::memory_order_relaxed); }
+
+    // Controller/driver delay before a note reaches us
+    void setInputLatencyMicros(uint32_t micros) { inputLatency_.store(micros, std::memory_order_relaxed); }
+    uint32_t getInputLatencyMicros() const { return inputLatency_.load(std::memory_order_relaxed); }
+
+    // Delay from rendering a block to hearing it (device buffers)
+    void setOutputLatencyMicros(uint32_t micros) { outputLatency_.store(micros, std::memory_order_relaxed); }
+    uint32_t getOutputLatencyMicros() const { return outputLatency_.load(std::memory_order_relaxed); }
+
+    // MIDI thread: a note for `track` (mapped through the KitMap) arrived
+    // at host time `timestampMicros`. False if not armed or nothing is
+    // playing.
+    bool noteOn(uint32_t track, uint8_t velocity, uint64_t timestampMicros);
+
+    // Pattern owner: next recorded hit, false when none are waiting
+    bool takeHit(RecordedHit& hit) { return hits_.pop(hit); }
+
+private:
+    const TimelineAnchor& timeline_;
+    std::atomic<bool> armed_;
+    std::atomic<bool> quantize_;
+    std::atomic<uint32_t> inputLatency_;
+    std::atomic<uint32_t> outputLatency_;
+
+    SpscQueue<RecordedHit, 256> hits_;
+};
+
+} // namespace DrumMachine
+
+#endif // LIVE_RECORDER_H
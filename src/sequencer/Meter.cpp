@@ -0,0 +1,95 @@
+#include "Meter.h"
+#include "MusicalClock.h"
+#include <cstdio>
+
+namespace DrumMachine {
+
+Meter::Meter()
+    : Meter(4, 4)
+{
+}
+
+Meter::Meter(uint32_t numerator, uint32_t denominator)
+{
+    // Fall back to 4/4 rather than producing an unplayable bar
+    if (!isValid(numerator, denominator)) {
+        numerator = 4;
+        denominator = 4;
+    }
+    numerator_ = static_cast<uint8_t>(numerator);
+    denominator_ = static_cast<uint8_t>(denominator);
+    computeLayout();
+}
+
+bool Meter::isValid(uint32_t numerator, uint32_t denominator)
+{
+    if (numerator == 0) {
+        return false;
+    }
+    if (denominator != 1 && denominator != 2 && denominator != 4 &&
+        denominator != 8 && denominator != 16) {
+        return false;
+    }
+    return numerator * (16 / denominator) <= MAX_STEPS_PER_BAR;
+}
+
+bool Meter::parse(const std::string& text, Meter& meter)
+{
+    unsigned int numerator = 0;
+    unsigned int denominator = 0;
+    if (std::sscanf(text.c_str(), "%u/%u", &numerator, &denominator) != 2 ||
+        !isValid(numerator, denominator)) {
+        return false;
+    }
+    meter = Meter(numerator, denominator);
+    return true;
+}
+
+std::string Meter::toString() const
+{
+    return std::to_string(numerator_) + "/" + std::to_string(denominator_);
+}
+
+void Meter::computeLayout()
+{
+    const uint32_t stepsPerNote = 16 / denominator_;
+    stepsPerBar_ = static_cast<uint8_t>(numerator_ * stepsPerNote);
+    ticksPerBar_ = stepsPerBar_ * MusicalClock::TICKS_PER_STEP;
+
+    // Group the bar into beats, in units of the denominator note
+    std::array<uint8_t, MAX_BEAT_GROUPS> groups{};
+    uint32_t groupCount = 0;
+
+    if (denominator_ >= 8 && numerator_ % 3 == 0) {
+        // Compound meters (3/8, 6/8, 9/8, 12/8): dotted beats of three
+        for (uint32_t i = 0; i < numerator_ / 3u; ++i) {
+            groups[groupCount++] = 3;
+        }
+    } else if (denominator_ >= 8) {
+        // Odd/additive meters: pairs, with a final three if needed (7/8 = 2+2+3)
+        uint32_t remaining = numerator_;
+        while (remaining > 0 && groupCount < MAX_BEAT_GROUPS) {
+            uint32_t group = (remaining == 3) ? 3 : (remaining >= 2 ? 2 : 1);
+            groups[groupCount++] = static_cast<uint8_t>(group);
+            remaining -= group;
+        }
+    } else {
+        // Simple meters: one beat per denominator note
+        for (uint32_t i = 0; i < numerator_ && groupCount < MAX_BEAT_GROUPS; ++i) {
+            groups[groupCount++] = 1;
+        }
+    }
+
+    beatSteps_.fill(0);
+    beatStartMask_ = 0;
+    beatCount_ = static_cast<uint8_t>(groupCount);
+
+    uint32_t step = 0;
+    for (uint32_t i = 0; i < groupCount; ++i) {
+        beatSteps_[i] = static_cast<uint8_t>(groups[i] * stepsPerNote);
+        beatStartMask_ |= 1u << step;
+        step += beatSteps_[i];
+    }
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,67 @@
+#ifndef METER_H
+#define METER_H
+
+#include <cstdint>
+#include <string>
+#include <array>
+
+namespace DrumMachine {
+
+/**
+ * Meter
+ *
+ * Compact rational time signature (numerator / denominator).
+ * Steps per bar, bar length in ticks and beat grouping are computed once
+ * when the meter is constructed, so the audio thread only reads integers.
+ * Steps are 16th notes: a 4/4 bar has 16 steps, 3/4 and 6/8 have 12,
+ * 5/4 has 20 and 7/8 has 14.
+ */
+class Meter {
+public:
+    static constexpr uint32_t MAX_STEPS_PER_BAR = 32;
+    static constexpr uint32_t MAX_BEAT_GROUPS = 16;
+
+    Meter();  // 4/4
+    Meter(uint32_t numerator, uint32_t denominator);
+
+    // Denominator must be 1, 2, 4, 8 or 16 and the bar must fit MAX_STEPS_PER_BAR
+    static bool isValid(uint32_t numerator, uint32_t denominator);
+
+    // Parse "7/8" style text (UI thread only). Returns false if invalid.
+    static bool parse(const std::string& text, Meter& meter);
+    std::string toString() const;
+
+    uint32_t getNumerator() const { return numerator_; }
+    uint32_t getDenominator() const { return denominator_; }
+
+    // Precomputed bar layout
+    uint32_t getStepsPerBar() const { return stepsPerBar_; }
+    uint32_t getTicksPerBar() const { return ticksPerBar_; }
+
+    // Beat grouping (e.g. 7/8 = 2+2+3 eighths = 4+4+6 steps)
+    uint32_t getBeatCount() const { return beatCount_; }
+    uint32_t getBeatLengthSteps(uint32_t beatIndex) const { return beatSteps_[beatIndex]; }
+    bool isBeatStart(uint32_t step) const { return step < 32 && (beatStartMask_ >> step) & 1u; }
+
+    // Pack into 16 bits for lock-free hand-off between threads
+    uint16_t pack() const { return static_cast<uint16_t>((numerator_ << 8) | denominator_); }
+    static Meter unpack(uint16_t packed) { return Meter(packed >> 8, packed & 0xFF); }
+
+    bool operator==(const Meter& other) const { return pack() == other.pack(); }
+    bool operator!=(const Meter& other) const { return pack() != other.pack(); }
+
+private:
+    uint8_t numerator_;
+    uint8_t denominator_;
+    uint8_t stepsPerBar_;
+    uint8_t beatCount_;
+    uint32_t ticksPerBar_;
+    uint32_t beatStartMask_;  // Bit s set if step s starts a beat
+    std::array<uint8_t, MAX_BEAT_GROUPS> beatSteps_;
+
+    void computeLayout();
+};
+
+} // namespace DrumMachine
+
+#endif // METER_H
@@ -0,0 +1,69 @@
+#include "MidiClockFilter.h"
+#include <cmath>
+
+namespace DrumMachine {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double MAX_GAP_PERIODS = 4.0;  // Longer silence restarts the loop
+
+} // namespace
+
+MidiClockFilter::MidiClockFilter(double bandwidthHz)
+    : bandwidth_(bandwidthHz), pulseTime_(0.0), nextPulseTime_(0.0), period_(0.0), pulses_(0)
+{
+}
+
+void MidiClockFilter::reset()
+{
+    pulseTime_ = 0.0;
+    nextPulseTime_ = 0.0;
+    period_ = 0.0;
+    pulses_ = 0;
+}
+
+void MidiClockFilter::pulse(double seconds)
+{
+    if (pulses_ > 1 && seconds - pulseTime_ > MAX_GAP_PERIODS * period_) {
+        reset();
+    }
+
+    if (pulses_ == 0) {
+        pulseTime_ = seconds;
+        pulses_ = 1;
+        return;
+    }
+    if (pulses_ == 1) {
+        // Seed the loop with the first raw period
+        period_ = seconds - pulseTime_;
+        if (period_ <= 0.0) {
+            pulseTime_ = seconds;
+            period_ = 0.0;
+            return;
+        }
+        pulseTime_ = seconds;
+        nextPulseTime_ = seconds + period_;
+        pulses_ = 2;
+        return;
+    }
+
+    // Critically damped second-order loop; the gains follow the current
+    // period so the bandwidth holds in Hz at any tempo
+    const double omega = 2.0 * PI * bandwidth_ * period_;
+    const double b = std::sqrt(2.0) * omega;
+    const double c = omega * omega;
+
+    const double error = seconds - nextPulseTime_;
+    pulseTime_ = nextPulseTime_;
+    nextPulseTime_ += b * error + period_;
+    period_ += c * error;
+    pulses_++;
+}
+
+double MidiClockFilter::getBpm() const
+{
+    return period_ > 0.0 ? 60.0 / (period_ * PULSES_PER_QUARTER) : 0.0;
+}
+
+} // namespace DrumMachine
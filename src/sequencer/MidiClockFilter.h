@@ -0,0 +1,63 @@
+#ifndef MIDI_CLOCK_FILTER_H
+#define MIDI_CLOCK_FILTER_H
+
+#include <cstdint>
+
+namespace DrumMachine {
+
+/**
+ * MidiClockFilter
+ *
+ * Second-order delay-locked loop over the arrival times of MIDI clock
+ * pulses (24 per quarter note). Arrival times jitter by a millisecond or
+ * more over USB; the loop tracks the pulse period and phase with a
+ * critically damped filter, so tempo and position follow slow changes of
+ * the master while the jitter averages out. A gap longer than a few
+ * periods (stopped or unplugged master) restarts the loop.
+ *
+ * Pure and deterministic: the caller supplies the times, so the filter
+ * runs the same on live input and on simulated pulses.
+ */
+class MidiClockFilter {
+public:
+    static constexpr uint32_t PULSES_PER_QUARTER = 24;
+    static constexpr uint32_t LOCK_PULSES = PULSES_PER_QUARTER;  // Pulses before the output is trusted
+
+    // `bandwidthHz`: loop bandwidth; lower rejects more jitter, higher
+    // follows tempo changes faster
+    explicit MidiClockFilter(double bandwidthHz = 0.2);
+
+    void setBandwidth(double bandwidthHz) { bandwidth_ = bandwidthHz; }
+
+    // Forget the current estimate
+    void reset();
+
+    // A pulse arrived at `seconds` (any monotonic timebase)
+    void pulse(double seconds);
+
+    bool isLocked() const { return pulses_ >= LOCK_PULSES; }
+
+    // Pulses since the last reset
+    uint64_t getPulseCount() const { return pulses_; }
+
+    // Filtered pulse period in seconds (0 until two pulses have arrived)
+    double getPeriod() const { return period_; }
+
+    // Filtered tempo in BPM (0 until two pulses have arrived)
+    double getBpm() const;
+
+    // Filtered time of the latest pulse and predicted time of the next
+    double getPulseTime() const { return pulseTime_; }
+    double getNextPulseTime() const { return nextPulseTime_; }
+
+private:
+    double bandwidth_;
+    double pulseTime_;      // Filtered time of the latest pulse
+    double nextPulseTime_;  // Loop prediction for the next pulse
+    double period_;         // Loop's period estimate
+    uint64_t pulses_;
+};
+
+} // namespace DrumMachine
+
+#endif // MIDI_CLOCK_FILTER_H
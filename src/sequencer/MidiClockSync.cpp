@@ -0,0 +1,120 @@
+#include "MidiClockSync.h"
+#include "Transport.h"
+#include "MusicalClock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DrumMachine {
+
+namespace {
+
+// Fraction of the beat phase error corrected per beat, and the largest
+// tempo nudge the correction may apply
+constexpr double PHASE_GAIN = 0.25;
+constexpr double MAX_PHASE_NUDGE = 0.05;
+
+} // namespace
+
+static_assert(MidiClockSync::TICKS_PER_PULSE * MidiClockFilter::PULSES_PER_QUARTER
+                  == MusicalClock::PPQN,
+              "MIDI clock pulses must land on whole ticks");
+
+MidiClockSync::MidiClockSync(Transport& transport, const TimelineAnchor& timeline)
+    : transport_(transport), timeline_(timeline), enabled_(false), outputLatency_(0),
+      restart_(false), locked_(false), masterTempo_(0.0f), nextPulseTick_(0), running_(false)
+{
+}
+
+void MidiClockSync::setEnabled(bool enabled)
+{
+    enabled_.store(enabled, std::memory_order_relaxed);
+    if (!enabled) {
+        locked_.store(false, std::memory_order_relaxed);
+        masterTempo_.store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+void MidiClockSync::clock(uint64_t hostMicros)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    filter_.pulse(static_cast<double>(hostMicros) * 1e-6);
+    const int64_t masterTick = nextPulseTick_;
+    if (running_) {
+        nextPulseTick_ += TICKS_PER_PULSE;
+    }
+
+    const bool locked = filter_.isLocked();
+    locked_.store(locked, std::memory_order_relaxed);
+    if (!locked) {
+        return;
+    }
+
+    const double bpm = filter_.getBpm();
+    masterTempo_.store(static_cast<float>(bpm), std::memory_order_relaxed);
+
+    // Beat phase of the transport against the master at the filtered
+    // pulse time, as heard
+    double nudge = 0.0;
+    const TimelinePoint anchor = timeline_.read();
+    if (running_ && anchor.isValid()) {
+        const double renderSeconds = filter_.getPulseTime()
+            - static_cast<double>(anchor.hostMicros) * 1e-6
+            - outputLatency_.load(std::memory_order_relaxed) * 1e-6;
+        const double transportTick = static_cast<double>(anchor.transportTick)
+            + renderSeconds * anchor.ticksPerSecond;
+
+        double error = std::fmod(static_cast<double>(masterTick) - transportTick, MusicalClock::PPQN);
+        if (error > MusicalClock::PPQN / 2) {
+            error -= MusicalClock::PPQN;
+        } else if (error < -static_cast<double>(MusicalClock::PPQN / 2)) {
+            error += MusicalClock::PPQN;
+        }
+        nudge = std::clamp(PHASE_GAIN * error / MusicalClock::PPQN, -MAX_PHASE_NUDGE, MAX_PHASE_NUDGE);
+    }
+
+    transport_.setTempo(static_cast<float>(bpm * (1.0 + nudge)));
+}
+
+void MidiClockSync::start()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    // The first pulse after Start is the top of the song
+    nextPulseTick_ = 0;
+    running_ = true;
+    restart_.store(true, std::memory_order_release);
+    transport_.play();
+}
+
+void MidiClockSync::continuePlayback()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    running_ = true;
+    transport_.play();
+}
+
+void MidiClockSync::stop()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    running_ = false;
+    transport_.stop();
+}
+
+void MidiClockSync::songPosition(uint32_t sixteenths)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    // Takes effect with the next Continue
+    nextPulseTick_ = static_cast<int64_t>(sixteenths) * MusicalClock::TICKS_PER_STEP;
+}
+
+} // namespace DrumMachine
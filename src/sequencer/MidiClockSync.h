@@ -0,0 +1,76 @@
+#ifndef MIDI_CLOCK_SYNC_H
+#define MIDI_CLOCK_SYNC_H
+
+#include "MidiClockFilter.h"
+#include "TimelineAnchor.h"
+#include <cstdint>
+#include <atomic>
+
+namespace DrumMachine {
+
+class Transport;
+
+/**
+ * MidiClockSync
+ *
+ * Slaves the transport to incoming MIDI clock. Pulse times go through a
+ * MidiClockFilter; its tempo drives the transport, nudged by a small
+ * phase correction so the transport's beat lines up with the master's
+ * (measured through the TimelineAnchor at what the listener hears, i.e.
+ * after the output latency). Start, Continue, Stop and Song Position
+ * Pointer messages drive playback; the transport does not seek, so a
+ * song position only sets the beat phase to lock to.
+ *
+ * Threading: setters from the UI thread, message handlers from one MIDI
+ * thread, takeRestart() from the audio thread.
+ */
+class MidiClockSync {
+public:
+    static constexpr uint32_t TICKS_PER_PULSE = 40;  // MusicalClock ticks per MIDI clock
+
+    MidiClockSync(Transport& transport, const TimelineAnchor& timeline);
+
+    // Follow incoming clock (tempo and start/stop)
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Delay from rendering a block to hearing it (device buffers)
+    void setOutputLatencyMicros(uint32_t micros) { outputLatency_.store(micros, std::memory_order_relaxed); }
+
+    // MIDI thread: realtime messages, stamped with host time
+    void clock(uint64_t hostMicros);
+    void start();
+    void continuePlayback();
+    void stop();
+
+    // MIDI thread: Song Position Pointer, in 16th notes
+    void songPosition(uint32_t sixteenths);
+
+    // Locked to the master (UI display)
+    bool isLocked() const { return locked_.load(std::memory_order_relaxed); }
+
+    // Filtered master tempo (UI display), 0 until locked
+    float getMasterTempo() const { return masterTempo_.load(std::memory_order_relaxed); }
+
+    // Audio thread: true once after Start asked playback to restart
+    // from the top
+    bool takeRestart() { return restart_.exchange(false, std::memory_order_acquire); }
+
+private:
+    Transport& transport_;
+    const TimelineAnchor& timeline_;
+    std::atomic<bool> enabled_;
+    std::atomic<uint32_t> outputLatency_;
+    std::atomic<bool> restart_;
+    std::atomic<bool> locked_;
+    std::atomic<float> masterTempo_;
+
+    // MIDI thread
+    MidiClockFilter filter_;
+    int64_t nextPulseTick_;  // Master position of the next pulse, in clock ticks
+    bool running_;           // Master is playing
+};
+
+} // namespace DrumMachine
+
+#endif // MIDI_CLOCK_SYNC_H
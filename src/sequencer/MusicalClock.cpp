@@ -0,0 +1,156 @@
+#include "MusicalClock.h"
+#include "TempoMap.h"
+#include <numeric>
+#include <cmath>
+
+namespace DrumMachine {
+
+MusicalClock::MusicalClock(uint32_t sampleRate)
+    : sampleRate_(sampleRate), tempoMilliBpm_(120000), rateNum_(1), rateDen_(1),
+      frame_(0), tick_(0), remainder_(0),
+      tempoMap_(nullptr), anchorFrame_(0), anchorSeconds_(0.0)
+{
+    updateRate();
+}
+
+void MusicalClock::setSampleRate(uint32_t sampleRate)
+{
+    if (sampleRate == 0 || sampleRate == sampleRate_) {
+        return;
+    }
+    sampleRate_ = sampleRate;
+    updateRate();
+    if (tempoMap_) {
+        anchorTempoMap();
+    }
+}
+
+void MusicalClock::setTempoMilliBpm(uint32_t milliBpm)
+{
+    if (milliBpm == 0 || milliBpm == tempoMilliBpm_ || tempoMap_) {
+        return;
+    }
+    tempoMilliBpm_ = milliBpm;
+    updateRate();
+}
+
+void MusicalClock::setTempoMap(const TempoMap* tempoMap)
+{
+    if (tempoMap == tempoMap_) {
+        return;
+    }
+    tempoMap_ = tempoMap;
+    if (tempoMap_) {
+        anchorTempoMap();
+    }
+}
+
+void MusicalClock::reset()
+{
+    frame_ = 0;
+    tick_ = 0;
+    remainder_ = 0;
+    if (tempoMap_) {
+        anchorTempoMap();
+    }
+}
+
+void MusicalClock::anchorTempoMap()
+{
+    // Continue from exactly where we are, whatever the map says the time
+    // at this tick would have been
+    anchorFrame_ = frame_;
+    anchorSeconds_ = tempoMap_->secondsAtTick(getTickPosition());
+}
+
+double MusicalClock::frameAtTick(uint64_t tick) const
+{
+    double seconds = tempoMap_->secondsAtTick(static_cast<double>(tick)) - anchorSeconds_;
+    return static_cast<double>(anchorFrame_) + seconds * sampleRate_;
+}
+
+void MusicalClock::updateRate()
+{
+    // ticks per frame = PPQN * (milliBpm / 1000) / 60 / sampleRate
+    uint64_t num = static_cast<uint64_t>(PPQN) * tempoMilliBpm_;
+    uint64_t den = static_cast<uint64_t>(60000) * sampleRate_;
+    uint64_t divisor = std::gcd(num, den);
+    num /= divisor;
+    den /= divisor;
+
+    // Keep the fractional tick when the rate changes. This is the only
+    // place a rounding happens, and only when tempo actually changes.
+    if (den != rateDen_) {
+        remainder_ = static_cast<uint64_t>(
+            static_cast<double>(remainder_) / rateDen_ * den);
+        if (remainder_ >= den) {
+            remainder_ = den - 1;
+        }
+    }
+
+    rateNum_ = num;
+    rateDen_ = den;
+}
+
+double MusicalClock::getTickPosition() const
+{
+    return static_cast<double>(tick_) + static_cast<double>(remainder_) / rateDen_;
+}
+
+uint64_t MusicalClock::framesUntilTick(uint64_t tick) const
+{
+    if (tick <= tick_) {
+        return 0;
+    }
+
+    if (tempoMap_) {
+        // First whole frame at or after the tick's exact time
+        double frames = std::ceil(frameAtTick(tick) - static_cast<double>(frame_) - 1e-9);
+        return frames > 0.0 ? static_cast<uint64_t>(frames) : 0;
+    }
+
+    // Smallest n with (n * rateNum_ + remainder_) >= (tick - tick_) * rateDen_
+    uint64_t needed = (tick - tick_) * rateDen_ - remainder_;
+    return (needed + rateNum_ - 1) / rateNum_;
+}
+
+void MusicalClock::advance(uint32_t numFrames)
+{
+    if (tempoMap_) {
+        frame_ += numFrames;
+
+        // Closed-form position from elapsed time; the rate tracks the
+        // map's tempo here so offsets and displays stay consistent
+        double seconds = anchorSeconds_ + static_cast<double>(frame_ - anchorFrame_) / sampleRate_;
+        double position = tempoMap_->tickAtSeconds(seconds);
+        uint64_t milliBpm = static_cast<uint64_t>(std::llround(tempoMap_->getBpmAt(position) * 1000.0));
+        if (milliBpm != tempoMilliBpm_ && milliBpm > 0) {
+            tempoMilliBpm_ = static_cast<uint32_t>(milliBpm);
+            updateRate();
+        }
+
+        // Never move backwards through float rounding
+        double whole = std::floor(position);
+        uint64_t tick = whole > 0.0 ? static_cast<uint64_t>(whole) : 0;
+        if (tick >= tick_) {
+            tick_ = tick;
+            remainder_ = static_cast<uint64_t>((position - whole) * rateDen_);
+            if (remainder_ >= rateDen_) {
+                remainder_ = rateDen_ - 1;
+            }
+        }
+        return;
+    }
+
+    uint64_t units = static_cast<uint64_t>(numFrames) * rateNum_ + remainder_;
+    tick_ += units / rateDen_;
+    remainder_ = units % rateDen_;
+    frame_ += numFrames;
+}
+
+double MusicalClock::getSamplesPerTick() const
+{
+    return static_cast<double>(rateDen_) / static_cast<double>(rateNum_);
+}
+
+} // namespace DrumMachine
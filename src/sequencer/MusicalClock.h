@@ -0,0 +1,97 @@
+#ifndef MUSICAL_CLOCK_H
+#define MUSICAL_CLOCK_H
+
+#include <cstdint>
+
+namespace DrumMachine {
+
+class TempoMap;
+
+/**
+ * MusicalClock
+ *
+ * Drift-free musical position for the transport.
+ * Position is an integer tick count (PPQN resolution) plus an exact
+ * remainder, advanced with integer arithmetic only. The tick rate is
+ * kept as a reduced rational (ticks per frame = rateNum_ / rateDen_),
+ * so step lengths are exact and no rounding error ever accumulates,
+ * no matter how long the transport runs.
+ *
+ * With a TempoMap attached, position is instead derived from the frame
+ * count through the map's closed-form time <-> tick conversion, relative
+ * to the point where the map was attached. Nothing is integrated step by
+ * step, so ramps do not drift either.
+ */
+class MusicalClock {
+public:
+    static constexpr uint32_t PPQN = 960;                 // Ticks per quarter note
+    static constexpr uint32_t TICKS_PER_STEP = PPQN / 4;  // 16th note grid
+    static constexpr float MIN_BPM = 20.0f;
+    static constexpr float MAX_BPM = 999.0f;
+
+    MusicalClock(uint32_t sampleRate = 44100);
+
+    // Sample rate of the frames passed to advance()
+    void setSampleRate(uint32_t sampleRate);
+    uint32_t getSampleRate() const { return sampleRate_; }
+
+    // Tempo in thousandths of a BPM (120 BPM = 120000).
+    // Ignored while a tempo map is attached.
+    void setTempoMilliBpm(uint32_t milliBpm);
+    uint32_t getTempoMilliBpm() const { return tempoMilliBpm_; }
+
+    // Follow a tempo map from the current position (nullptr = constant
+    // tempo). The map must stay alive until detached or replaced.
+    void setTempoMap(const TempoMap* tempoMap);
+    const TempoMap* getTempoMap() const { return tempoMap_; }
+
+    // Rewind to tick 0, frame 0
+    void reset();
+
+    // Whole ticks elapsed
+    uint64_t getTick() const { return tick_; }
+
+    // Ticks elapsed including the fractional part (for display)
+    double getTickPosition() const;
+
+    // Frames elapsed since reset
+    uint64_t getFrame() const { return frame_; }
+
+    // Number of frames from the current position until the clock
+    // reaches `tick` (0 if already reached)
+    uint64_t framesUntilTick(uint64_t tick) const;
+
+    // Advance the clock by a block of frames
+    void advance(uint32_t numFrames);
+
+    // Exact step/tick lengths as floating point (for display and offsets)
+    double getSamplesPerTick() const;
+    double getSamplesPerStep() const { return getSamplesPerTick() * TICKS_PER_STEP; }
+
+private:
+    uint32_t sampleRate_;
+    uint32_t tempoMilliBpm_;
+    uint64_t rateNum_;    // Ticks per frame numerator (reduced)
+    uint64_t rateDen_;    // Ticks per frame denominator (reduced)
+    uint64_t frame_;      // Frames since reset
+    uint64_t tick_;       // Whole ticks since reset
+    uint64_t remainder_;  // Fractional tick, in units of 1/rateDen_
+
+    // Tempo map mode: position = map.tickAtSeconds(anchor + elapsed frames)
+    const TempoMap* tempoMap_;
+    uint64_t anchorFrame_;
+    double anchorSeconds_;
+
+    // Recompute rateNum_/rateDen_, rescaling the fractional tick
+    void updateRate();
+
+    // Map mode: anchor the map's timeline to the current position
+    void anchorTempoMap();
+
+    // Map mode: frame (fractional) at which the clock reaches `tick`
+    double frameAtTick(uint64_t tick) const;
+};
+
+} // namespace DrumMachine
+
+#endif // MUSICAL_CLOCK_H
@@ -0,0 +1,25 @@
+#ifndef OUTGOING_MIDI_H
+#define OUTGOING_MIDI_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * OutgoingMidi
+ *
+ * A short MIDI message produced by the audio thread, stamped with the
+ * host time at which it should leave the output port (already shifted by
+ * the audio output latency, so external gear lines up with what is heard).
+ */
+struct OutgoingMidi {
+    uint64_t hostMicros;
+    uint8_t size;     // 1-3 bytes used
+    uint8_t data[3];
+};
+static_assert(std::is_trivially_copyable<OutgoingMidi>::value, "Messages are copied between threads");
+
+} // namespace DrumMachine
+
+#endif // OUTGOING_MIDI_H
@@ -1,10 +1,12 @@
 #include "Pattern.h"
 #include <algorithm>
-#include <iostream>
+#include "../core/Logger.h"
 
 namespace DrumMachine {
 
 Pattern::Pattern()
+    : mutedMask_(0), length_(STEPS_PER_BAR), editFirst_(0), editLast_(MAX_STEPS - 1),
+      trackSettingsModified_(true), revision_(0)
 {
     initializeDefaultTracks();
 }
@@ -24,65 +26,271 @@ void Pattern::initializeDefaultTracks()
     }};
 
     for (uint32_t i = 0; i < NUM_TRACKS; ++i) {
-        tracks_[i].name = defaults[i].first;
-        tracks_[i].type = defaults[i].second;
-        tracks_[i].samplePath = "";
-        tracks_[i].volume = 0.8f;
-        tracks_[i].muted = false;
-        tracks_[i].steps.fill(0); // All steps off by default
+        auto track = std::make_shared<Track>();
+        track->name = defaults[i].first;
+        track->type = defaults[i].second;
+        track->samplePath = "";
+        track->volume = 0.8f;
+        track->muted = false;
+        track->steps.clear(); // All steps off by default
+        track->length = 0;
+        track->stepTicks = DEFAULT_STEP_TICKS;
+        tracks_[i] = std::move(track);
     }
 }
 
 Pattern::Track& Pattern::getTrack(uint32_t trackIndex)
 {
-    return tracks_[trackIndex];
+    revision_++;  // The caller may write through the reference
+    return mutableTrack(trackIndex);
 }
 
 const Pattern::Track& Pattern::getTrack(uint32_t trackIndex) const
 {
-    return tracks_[trackIndex];
+    return *tracks_[trackIndex];
+}
+
+Pattern::Track& Pattern::mutableTrack(uint32_t trackIndex)
+{
+    // Patterns only live on the editor thread, so use_count() is exact
+    std::shared_ptr<Track>& track = tracks_[trackIndex];
+    if (track.use_count() > 1) {
+        track = std::make_shared<Track>(*track);
+    }
+    return *track;
+}
+
+void Pattern::setLength(uint32_t steps)
+{
+    length_ = std::clamp(steps, 1u, MAX_STEPS);
+    markEdited(0, MAX_STEPS - 1);
 }
 
 bool Pattern::isStepActive(uint32_t trackIndex, uint32_t stepIndex) const
 {
-    return tracks_[trackIndex].steps[stepIndex] != 0;
+    return tracks_[trackIndex]->steps.test(stepIndex);
 }
 
 void Pattern::setStepActive(uint32_t trackIndex, uint32_t stepIndex, bool active)
 {
-    tracks_[trackIndex].steps[stepIndex] = active ? 1 : 0;
-    std::cout << "[PATTERN] Track " << trackIndex << " Step " << stepIndex 
-              << " set to " << (active ? "ON" : "OFF") << std::endl;
+    if (stepIndex >= MAX_STEPS) {
+        return;
+    }
+
+    // Unchanged steps don't touch (or unshare) the track
+    if (tracks_[trackIndex]->steps.test(stepIndex) == active) {
+        return;
+    }
+
+    // Keep the packed step data in step with the bitset
+    Track& track = mutableTrack(trackIndex);
+    auto position = track.stepData.begin() + track.steps.rank(stepIndex);
+    if (active) {
+        track.stepData.insert(position, StepData());
+    } else {
+        track.stepData.erase(position);
+        if (track.lockedSteps.test(stepIndex)) {
+            track.locks.erase(track.locks.begin() + track.lockedSteps.rank(stepIndex));
+            track.lockedSteps.set(stepIndex, false);
+        }
+    }
+    track.steps.set(stepIndex, active);
+    markEdited(stepIndex, stepIndex);
+    LOG_DEBUG("[PATTERN] Track %u Step %u set to %s", trackIndex, stepIndex, active ? "ON" : "OFF");
+}
+
+void Pattern::clearTrackSteps(uint32_t trackIndex)
+{
+    Track& track = mutableTrack(trackIndex);
+    track.steps.clear();
+    track.stepData.clear();
+    track.lockedSteps.clear();
+    track.locks.clear();
+    markEdited(0, MAX_STEPS - 1);
+}
+
+StepData Pattern::getStepData(uint32_t trackIndex, uint32_t stepIndex) const
+{
+    const Track& track = *tracks_[trackIndex];
+    if (!track.steps.test(stepIndex)) {
+        return StepData();
+    }
+    return track.stepData[track.steps.rank(stepIndex)];
+}
+
+void Pattern::setStepData(uint32_t trackIndex, uint32_t stepIndex, const StepData& data)
+{
+    if (!tracks_[trackIndex]->steps.test(stepIndex)) {
+        return;
+    }
+
+    Track& track = mutableTrack(trackIndex);
+    StepData& stored = track.stepData[track.steps.rank(stepIndex)];
+    stored.velocity = std::clamp<uint8_t>(data.velocity, 1, 127);
+    stored.probability = std::min<uint8_t>(data.probability, 100);
+    stored.microtiming = std::clamp<int8_t>(data.microtiming, -StepData::MAX_MICROTIMING,
+                                            StepData::MAX_MICROTIMING);
+    stored.ratchetCount = std::clamp<uint8_t>(data.ratchetCount, 1, StepData::MAX_RATCHETS);
+    stored.ratchetRate = std::clamp<uint8_t>(data.ratchetRate, 1, 8);
+    markEdited(stepIndex, stepIndex);
+}
+
+StepLocks Pattern::getStepLocks(uint32_t trackIndex, uint32_t stepIndex) const
+{
+    const Track& track = *tracks_[trackIndex];
+    if (!track.lockedSteps.test(stepIndex)) {
+        return StepLocks();
+    }
+    return track.locks[track.lockedSteps.rank(stepIndex)];
+}
+
+void Pattern::setStepLocks(uint32_t trackIndex, uint32_t stepIndex, const StepLocks& locks)
+{
+    if (!tracks_[trackIndex]->steps.test(stepIndex)) {
+        return;
+    }
+    const bool locked = (locks.mask & StepLocks::ALL) != 0;
+    if (!locked && !tracks_[trackIndex]->lockedSteps.test(stepIndex)) {
+        return;
+    }
+
+    // Locks are packed like step data, indexed by rank in lockedSteps
+    Track& track = mutableTrack(trackIndex);
+    auto position = track.locks.begin() + track.lockedSteps.rank(stepIndex);
+    if (!locked) {
+        track.locks.erase(position);
+        track.lockedSteps.set(stepIndex, false);
+        markEdited(stepIndex, stepIndex);
+        return;
+    }
+    if (!track.lockedSteps.test(stepIndex)) {
+        position = track.locks.insert(position, StepLocks());
+        track.lockedSteps.set(stepIndex, true);
+    }
+
+    StepLocks& stored = *position;
+    stored.mask = locks.mask & StepLocks::ALL;
+    stored.volume = std::min<uint8_t>(locks.volume, 127);
+    stored.pan = std::clamp<int8_t>(locks.pan, -64, 63);
+    stored.pitch = std::clamp<int8_t>(locks.pitch, -StepLocks::MAX_PITCH, StepLocks::MAX_PITCH);
+    stored.decay = std::min<uint8_t>(locks.decay, 127);
+    stored.sampleStart = std::min<uint8_t>(locks.sampleStart, 127);
+    markEdited(stepIndex, stepIndex);
+}
+
+bool Pattern::hasStepLocks(uint32_t trackIndex, uint32_t stepIndex) const
+{
+    return tracks_[trackIndex]->lockedSteps.test(stepIndex);
+}
+
+bool Pattern::takeEditSpan(uint32_t& firstStep, uint32_t& lastStep)
+{
+    if (editFirst_ > editLast_) {
+        return false;
+    }
+
+    firstStep = editFirst_;
+    lastStep = editLast_;
+    editFirst_ = MAX_STEPS;
+    editLast_ = 0;
+    return true;
+}
+
+bool Pattern::takeTrackSettingsModified()
+{
+    bool modified = trackSettingsModified_;
+    trackSettingsModified_ = false;
+    return modified;
+}
+
+void Pattern::markAllEdited()
+{
+    editFirst_ = 0;
+    editLast_ = MAX_STEPS - 1;
+    trackSettingsModified_ = true;
+}
+
+void Pattern::markEdited(uint32_t firstStep, uint32_t lastStep)
+{
+    revision_++;
+    editFirst_ = std::min(editFirst_, firstStep);
+    editLast_ = std::max(editLast_, lastStep);
+}
+
+uint32_t Pattern::getActiveStepCount(uint32_t trackIndex) const
+{
+    return tracks_[trackIndex]->steps.count(getTrackLength(trackIndex));
+}
+
+float Pattern::getTrackDensity(uint32_t trackIndex) const
+{
+    return static_cast<float>(getActiveStepCount(trackIndex)) / getTrackLength(trackIndex);
+}
+
+float Pattern::getDensity() const
+{
+    uint32_t total = 0;
+    uint32_t steps = 0;
+    for (uint32_t i = 0; i < NUM_TRACKS; ++i) {
+        total += getActiveStepCount(i);
+        steps += getTrackLength(i);
+    }
+    return static_cast<float>(total) / steps;
+}
+
+void Pattern::setTrackLength(uint32_t trackIndex, uint32_t steps)
+{
+    mutableTrack(trackIndex).length = std::min(steps, MAX_STEPS);
+    markEdited(0, MAX_STEPS - 1);
+}
+
+uint32_t Pattern::getTrackLength(uint32_t trackIndex) const
+{
+    const uint32_t length = tracks_[trackIndex]->length;
+    return length != 0 ? length : length_;
+}
+
+void Pattern::setTrackStepTicks(uint32_t trackIndex, uint32_t ticks)
+{
+    mutableTrack(trackIndex).stepTicks = std::clamp(ticks, MIN_STEP_TICKS, MAX_STEP_TICKS);
+    markEdited(0, MAX_STEPS - 1);
 }
 
 void Pattern::setTrackVolume(uint32_t trackIndex, float volume)
 {
-    tracks_[trackIndex].volume = std::clamp(volume, 0.0f, 1.0f);
+    mutableTrack(trackIndex).volume = std::clamp(volume, 0.0f, 1.0f);
+    revision_++;
 }
 
 float Pattern::getTrackVolume(uint32_t trackIndex) const
 {
-    return tracks_[trackIndex].volume;
+    return tracks_[trackIndex]->volume;
 }
 
 void Pattern::setTrackMuted(uint32_t trackIndex, bool muted)
 {
-    tracks_[trackIndex].muted = muted;
+    mutableTrack(trackIndex).muted = muted;
+    revision_++;
+
+    const uint16_t trackBit = static_cast<uint16_t>(1u << trackIndex);
+    mutedMask_ = muted ? (mutedMask_ | trackBit) : (mutedMask_ & static_cast<uint16_t>(~trackBit));
+    trackSettingsModified_ = true;
 }
 
 bool Pattern::isTrackMuted(uint32_t trackIndex) const
 {
-    return tracks_[trackIndex].muted;
+    return tracks_[trackIndex]->muted;
 }
 
 void Pattern::setTrackSample(uint32_t trackIndex, const std::string& samplePath)
 {
-    tracks_[trackIndex].samplePath = samplePath;
+    mutableTrack(trackIndex).samplePath = samplePath;
+    revision_++;
 }
 
 std::string Pattern::getTrackSample(uint32_t trackIndex) const
 {
-    return tracks_[trackIndex].samplePath;
+    return tracks_[trackIndex]->samplePath;
 }
 
 } // namespace DrumMachine
@@ -1,24 +1,79 @@
 #ifndef PATTERN_H
 #define PATTERN_H
 
+#include "Meter.h"
+#include "StepBitset.h"
+#include "StepLocks.h"
 #include <cstdint>
 #include <string>
 #include <array>
+#include <vector>
+#include <memory>
 
 namespace DrumMachine {
 
+/**
+ * StepData
+ *
+ * Per-hit parameters of an active step, packed into 4 bytes. Only active
+ * steps store one; inactive steps cost nothing.
+ */
+struct StepData {
+    static constexpr int8_t MAX_MICROTIMING = 120;  // Ticks (half a 16th)
+    static constexpr uint8_t MAX_RATCHETS = 8;
+
+    uint8_t velocity = 100;      // 1-127
+    uint8_t probability = 100;   // Trigger chance in percent (0-100)
+    int8_t microtiming = 0;      // Offset from the grid in clock ticks
+    uint8_t ratchetCount : 4;    // Hits per step (1 = no ratchet)
+    uint8_t ratchetRate : 4;     // Ratchet hits per track step (1-8)
+
+    StepData() : ratchetCount(1), ratchetRate(2) {}
+
+    // Pack into 32 bits for the parameter bus
+    uint32_t pack() const
+    {
+        return uint32_t(velocity) | (uint32_t(probability) << 8) |
+               (uint32_t(static_cast<uint8_t>(microtiming)) << 16) |
+               (uint32_t(ratchetCount) << 24) | (uint32_t(ratchetRate) << 28);
+    }
+    static StepData unpack(uint32_t packed)
+    {
+        StepData data;
+        data.velocity = static_cast<uint8_t>(packed);
+        data.probability = static_cast<uint8_t>(packed >> 8);
+        data.microtiming = static_cast<int8_t>(packed >> 16);
+        data.ratchetCount = (packed >> 24) & 0x0F;
+        data.ratchetRate = (packed >> 28) & 0x0F;
+        return data;
+    }
+};
+static_assert(sizeof(StepData) == 4, "StepData should stay packed");
+
 /**
  * Pattern
  * 
- * A single drum pattern with 8 tracks and 16 steps.
- * Data model for storage and playback.
+ * A single drum pattern with 8 tracks and up to MAX_STEPS steps
+ * (multi-bar). Steps are stored as one bitset per track. Tracks are
+ * copy-on-write: copying a Pattern shares every track, and an edit copies
+ * only the track it touches, so the versions kept for undo cost little.
+ * Data model for storage and editing. The audio thread never reads it;
+ * it plays a compiled PatternSchedule snapshot instead.
  * Milestone 2: Pattern data model and step management
  */
 class Pattern {
 public:
     static constexpr uint32_t NUM_TRACKS = 8;
-    static constexpr uint32_t STEPS_PER_BAR = 16;
-    static constexpr uint32_t MAX_BARS = 5;
+    static constexpr uint32_t STEPS_PER_BAR = 16;  // Default 4/4 grid
+    static constexpr uint32_t MAX_STEPS_PER_BAR = Meter::MAX_STEPS_PER_BAR;
+    static constexpr uint32_t MAX_BARS = 8;
+    static constexpr uint32_t MAX_STEPS = StepBitset::MAX_STEPS;
+    static_assert(MAX_BARS * MAX_STEPS_PER_BAR <= MAX_STEPS, "Step storage too small for MAX_BARS");
+    static_assert(NUM_TRACKS <= 16, "Track masks are 16 bits wide");
+    static constexpr uint8_t DEFAULT_VELOCITY = 100;
+    static constexpr uint32_t DEFAULT_STEP_TICKS = 240;  // A 16th at 960 PPQN
+    static constexpr uint32_t MIN_STEP_TICKS = 60;       // 1/64
+    static constexpr uint32_t MAX_STEP_TICKS = 960;      // Quarter note
 
     enum class TrackType {
         Kick,
@@ -37,7 +92,12 @@ public:
         std::string samplePath;
         float volume;
         bool muted;
-        std::array<uint8_t, STEPS_PER_BAR> steps; // 1 = active, 0 = inactive
+        StepBitset steps;
+        std::vector<StepData> stepData;  // One entry per active step, in step order
+        StepBitset lockedSteps;          // Active steps with parameter locks
+        std::vector<StepLocks> locks;    // One entry per locked step, in step order
+        uint32_t length;                 // Own cycle in steps (0 = pattern length)
+        uint32_t stepTicks;              // Clock ticks per step (the track's rate)
     };
 
     Pattern();
@@ -46,9 +106,58 @@ public:
     Track& getTrack(uint32_t trackIndex);
     const Track& getTrack(uint32_t trackIndex) const;
 
+    // Pattern length in steps (bars * steps per bar)
+    uint32_t getLength() const { return length_; }
+    void setLength(uint32_t steps);
+
     // Step management
     bool isStepActive(uint32_t trackIndex, uint32_t stepIndex) const;
     void setStepActive(uint32_t trackIndex, uint32_t stepIndex, bool active);
+    void clearTrackSteps(uint32_t trackIndex);
+
+    // Per-step parameters (defaults for inactive steps; setting them on an
+    // inactive step does nothing)
+    StepData getStepData(uint32_t trackIndex, uint32_t stepIndex) const;
+    void setStepData(uint32_t trackIndex, uint32_t stepIndex, const StepData& data);
+
+    // Parameter locks of an active step (no locks for other steps; setting
+    // them on an inactive step does nothing, an empty mask removes them).
+    // Turning a step off drops its locks.
+    StepLocks getStepLocks(uint32_t trackIndex, uint32_t stepIndex) const;
+    void setStepLocks(uint32_t trackIndex, uint32_t stepIndex, const StepLocks& locks);
+    bool hasStepLocks(uint32_t trackIndex, uint32_t stepIndex) const;
+
+    // Bit t set if track t is muted
+    uint16_t getMutedMask() const { return mutedMask_; }
+
+    // Span of steps edited since the last call; false if nothing changed.
+    // Used to recompile only that part of the playback schedule.
+    bool takeEditSpan(uint32_t& firstStep, uint32_t& lastStep);
+
+    // True once after a change to track settings that affect playback
+    // (mutes), which republish the playback snapshot without recompiling
+    bool takeTrackSettingsModified();
+
+    // Mark everything for recompiling and republishing (after the whole
+    // pattern was replaced, e.g. by undo)
+    void markAllEdited();
+
+    // Bumped by every change; equal revisions of copies mean equal content
+    uint64_t getRevision() const { return revision_; }
+
+    // Density stats (popcount over the pattern length)
+    uint32_t getActiveStepCount(uint32_t trackIndex) const;
+    float getTrackDensity(uint32_t trackIndex) const;
+    float getDensity() const;
+
+    // Polymeter: a track may loop over its own number of steps at its own
+    // rate, independently of the pattern length
+    void setTrackLength(uint32_t trackIndex, uint32_t steps);  // 0 = follow the pattern
+    uint32_t getTrackLength(uint32_t trackIndex) const;        // Effective length in steps
+    bool followsPatternLength(uint32_t trackIndex) const { return tracks_[trackIndex]->length == 0; }
+
+    void setTrackStepTicks(uint32_t trackIndex, uint32_t ticks);
+    uint32_t getTrackStepTicks(uint32_t trackIndex) const { return tracks_[trackIndex]->stepTicks; }
 
     // Track volume and mute
     void setTrackVolume(uint32_t trackIndex, float volume);
@@ -62,7 +171,18 @@ public:
     std::string getTrackSample(uint32_t trackIndex) const;
 
 private:
-    std::array<Track, NUM_TRACKS> tracks_;
+    std::array<std::shared_ptr<Track>, NUM_TRACKS> tracks_;  // Shared between copies
+    uint16_t mutedMask_;
+    uint32_t length_;
+    uint32_t editFirst_;  // Pending edit span (editFirst_ > editLast_ when clean)
+    uint32_t editLast_;
+    bool trackSettingsModified_;
+    uint64_t revision_;
+
+    // Track for writing; copied first if another version shares it
+    Track& mutableTrack(uint32_t trackIndex);
+
+    void markEdited(uint32_t firstStep, uint32_t lastStep);
 
     // Initialize default tracks with GM drum mapping
     void initializeDefaultTracks();
@@ -0,0 +1,62 @@
+#include "PatternHistory.h"
+#include <utility>
+
+namespace DrumMachine {
+
+void PatternHistory::record(uint32_t slot, const Pattern& before, uint32_t firstStep, uint32_t lastStep,
+                            uint64_t nowMicros)
+{
+    redo_.clear();
+
+    // Same steps edited again right away: the existing level already
+    // holds the state from before the gesture started
+    const bool coalesce = canCoalesce_ && !undo_.empty() && firstStep != NO_SPAN
+        && undo_.back().slot == slot && undo_.back().firstStep == firstStep
+        && undo_.back().lastStep == lastStep && nowMicros - lastRecordMicros_ < COALESCE_MICROS;
+    lastRecordMicros_ = nowMicros;
+    canCoalesce_ = true;
+    if (coalesce) {
+        return;
+    }
+
+    undo_.push_back({slot, before, firstStep, lastStep});
+    if (undo_.size() > MAX_LEVELS) {
+        undo_.pop_front();
+    }
+}
+
+bool PatternHistory::undo(Pattern* bank, uint32_t& slot)
+{
+    return swapLevel(undo_, redo_, bank, slot);
+}
+
+bool PatternHistory::redo(Pattern* bank, uint32_t& slot)
+{
+    return swapLevel(redo_, undo_, bank, slot);
+}
+
+void PatternHistory::clear()
+{
+    undo_.clear();
+    redo_.clear();
+    canCoalesce_ = false;
+}
+
+template <typename From, typename To>
+bool PatternHistory::swapLevel(From& from, To& to, Pattern* bank, uint32_t& slot)
+{
+    if (from.empty()) {
+        return false;
+    }
+
+    // The level takes the bank's current version, ready to be swapped back
+    Level level = std::move(from.back());
+    from.pop_back();
+    slot = level.slot;
+    std::swap(bank[slot], level.pattern);
+    to.push_back(std::move(level));
+    canCoalesce_ = false;
+    return true;
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,64 @@
+#ifndef PATTERN_HISTORY_H
+#define PATTERN_HISTORY_H
+
+#include "Pattern.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace DrumMachine {
+
+/**
+ * PatternHistory
+ *
+ * Undo/redo for the pattern bank. Each level keeps a whole Pattern
+ * version, but versions share every track they didn't change (see
+ * Pattern), so a level costs a Pattern header plus the tracks that edit
+ * touched. Undo and redo swap versions in place; no step data is copied.
+ * Quick repeated edits of the same steps (a slider drag) coalesce into
+ * one level.
+ *
+ * Threading: editor (UI) thread only.
+ */
+class PatternHistory {
+public:
+    static constexpr size_t MAX_LEVELS = 4096;
+    static constexpr uint32_t NO_SPAN = UINT32_MAX;
+    static constexpr uint64_t COALESCE_MICROS = 750000;
+
+    // `before` is `slot` as it was ahead of an edit to steps
+    // [firstStep, lastStep] (NO_SPAN for other edits), made at `nowMicros`
+    void record(uint32_t slot, const Pattern& before, uint32_t firstStep, uint32_t lastStep,
+                uint64_t nowMicros);
+
+    // Swap the latest level into `bank`; `slot` is the slot that changed
+    bool undo(Pattern* bank, uint32_t& slot);
+    bool redo(Pattern* bank, uint32_t& slot);
+
+    bool canUndo() const { return !undo_.empty(); }
+    bool canRedo() const { return !redo_.empty(); }
+    size_t getUndoCount() const { return undo_.size(); }
+
+    void clear();
+
+private:
+    struct Level {
+        uint32_t slot;
+        Pattern pattern;
+        uint32_t firstStep;
+        uint32_t lastStep;
+    };
+
+    std::deque<Level> undo_;
+    std::vector<Level> redo_;
+    uint64_t lastRecordMicros_ = 0;
+    bool canCoalesce_ = false;  // Cleared by undo/redo so the next edit starts a level
+
+    // Swap the newest level of `from` into `bank` and move it to `to`
+    template <typename From, typename To>
+    bool swapLevel(From& from, To& to, Pattern* bank, uint32_t& slot);
+};
+
+} // namespace DrumMachine
+
+#endif // PATTERN_HISTORY_H
@@ -0,0 +1,195 @@
+#include "PatternSchedule.h"
+#include "Pattern.h"
+#include "MusicalClock.h"
+#include <algorithm>
+#include <iterator>
+
+namespace DrumMachine {
+
+namespace {
+
+bool eventOrder(const ScheduledEvent& a, const ScheduledEvent& b)
+{
+    return a.tick != b.tick ? a.tick < b.tick : a.track < b.track;
+}
+
+} // namespace
+
+static_assert(Pattern::DEFAULT_STEP_TICKS == MusicalClock::TICKS_PER_STEP,
+              "Default track rate must be one grid step");
+
+std::unique_ptr<PatternSchedule> PatternSchedule::compile(const Pattern& pattern)
+{
+    std::unique_ptr<PatternSchedule> schedule(new PatternSchedule());
+    schedule->lengthSteps_ = pattern.getLength();
+    schedule->mutedMask_ = pattern.getMutedMask();
+
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        const uint32_t trackLength = pattern.getTrackLength(track);
+        schedule->cycleTicks_[track] = trackLength * pattern.getTrackStepTicks(track);
+        schedule->trackOffsets_[track] = static_cast<uint32_t>(schedule->events_.size());
+
+        for (uint32_t step = 0; step < trackLength; ++step) {
+            appendStepEvents(pattern, track, step, schedule->events_, schedule->locks_);
+        }
+        std::stable_sort(schedule->events_.begin() + schedule->trackOffsets_[track],
+                         schedule->events_.end(), eventOrder);
+    }
+    schedule->trackOffsets_[Pattern::NUM_TRACKS] = static_cast<uint32_t>(schedule->events_.size());
+
+    return schedule;
+}
+
+std::unique_ptr<PatternSchedule> PatternSchedule::recompileSpan(const PatternSchedule& previous,
+                                                                const Pattern& pattern,
+                                                                uint32_t firstStep, uint32_t lastStep)
+{
+    // A length or rate change moves every step; fall back to a full compile
+    if (previous.lengthSteps_ != pattern.getLength() || !previous.hasSameGeometry(pattern)) {
+        return compile(pattern);
+    }
+
+    std::unique_ptr<PatternSchedule> schedule(new PatternSchedule());
+    schedule->lengthSteps_ = previous.lengthSteps_;
+    schedule->mutedMask_ = pattern.getMutedMask();
+    schedule->cycleTicks_ = previous.cycleTicks_;
+    schedule->events_.reserve(previous.events_.size() + Pattern::NUM_TRACKS);
+    schedule->locks_.reserve(previous.locks_.size());
+
+    std::vector<ScheduledEvent> kept;
+    std::vector<ScheduledEvent> span;
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        schedule->trackOffsets_[track] = static_cast<uint32_t>(schedule->events_.size());
+
+        // Keep the track's other events as is (already sorted), moving
+        // their locks into the new table
+        kept.clear();
+        for (uint32_t i = previous.getTrackBegin(track); i < previous.getTrackEnd(track); ++i) {
+            ScheduledEvent event = previous.events_[i];
+            if (event.step < firstStep || event.step > lastStep) {
+                if (event.locks != ScheduledEvent::NO_LOCKS) {
+                    schedule->locks_.push_back(previous.locks_[event.locks]);
+                    event.locks = static_cast<uint16_t>(schedule->locks_.size() - 1);
+                }
+                kept.push_back(event);
+            }
+        }
+
+        // Regenerate only the edited steps that fall inside the track's cycle
+        span.clear();
+        const uint32_t spanLast = std::min(lastStep, pattern.getTrackLength(track) - 1);
+        for (uint32_t step = firstStep; step <= spanLast; ++step) {
+            appendStepEvents(pattern, track, step, span, schedule->locks_);
+        }
+        std::stable_sort(span.begin(), span.end(), eventOrder);
+
+        std::merge(kept.begin(), kept.end(), span.begin(), span.end(),
+                   std::back_inserter(schedule->events_), eventOrder);
+    }
+    schedule->trackOffsets_[Pattern::NUM_TRACKS] = static_cast<uint32_t>(schedule->events_.size());
+
+    return schedule;
+}
+
+std::unique_ptr<PatternSchedule> PatternSchedule::updateTrackSettings(const PatternSchedule& previous,
+                                                                      const Pattern& pattern)
+{
+    std::unique_ptr<PatternSchedule> schedule(new PatternSchedule(previous));
+    schedule->mutedMask_ = pattern.getMutedMask();
+    return schedule;
+}
+
+uint32_t PatternSchedule::getLengthTicks() const
+{
+    return lengthSteps_ * MusicalClock::TICKS_PER_STEP;
+}
+
+uint32_t PatternSchedule::findFirstAtOrAfter(uint32_t track, uint32_t tick) const
+{
+    auto begin = events_.begin() + trackOffsets_[track];
+    auto end = events_.begin() + trackOffsets_[track + 1];
+    auto it = std::lower_bound(begin, end, tick,
+                               [](const ScheduledEvent& event, uint32_t value) {
+                                   return event.tick < value;
+                               });
+    return static_cast<uint32_t>(it - events_.begin());
+}
+
+std::vector<ScheduledEvent> PatternSchedule::expand(uint32_t lengthTicks) const
+{
+    std::vector<ScheduledEvent> expanded;
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        const uint32_t cycleTicks = cycleTicks_[track];
+        if (cycleTicks == 0) {
+            continue;
+        }
+
+        for (uint32_t cycleStart = 0; cycleStart < lengthTicks; cycleStart += cycleTicks) {
+            for (uint32_t i = getTrackBegin(track); i < getTrackEnd(track); ++i) {
+                ScheduledEvent event = events_[i];
+                event.tick += cycleStart;
+                if (event.tick < lengthTicks) {
+                    expanded.push_back(event);
+                }
+            }
+        }
+    }
+    std::stable_sort(expanded.begin(), expanded.end(), eventOrder);
+    return expanded;
+}
+
+bool PatternSchedule::hasSameGeometry(const Pattern& pattern) const
+{
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        if (cycleTicks_[track] != pattern.getTrackLength(track) * pattern.getTrackStepTicks(track)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PatternSchedule::appendStepEvents(const Pattern& pattern, uint32_t track, uint32_t step,
+                                       std::vector<ScheduledEvent>& events, std::vector<StepLocks>& locks)
+{
+    if (!pattern.isStepActive(track, step)) {
+        return;
+    }
+
+    const int64_t stepTicks = pattern.getTrackStepTicks(track);
+    const int64_t cycleTicks = static_cast<int64_t>(pattern.getTrackLength(track)) * stepTicks;
+    const int64_t gridTick = static_cast<int64_t>(step) * stepTicks;
+
+    const StepData data = pattern.getStepData(track, step);
+    const int64_t baseTick = gridTick + data.microtiming;
+    const int64_t ratchetTicks = stepTicks / std::max<uint32_t>(data.ratchetRate, 1);
+
+    // Swing shifts hits that sit on an off-beat 16th of the grid
+    const bool offBeat = gridTick % (2 * MusicalClock::TICKS_PER_STEP) == MusicalClock::TICKS_PER_STEP;
+
+    // Ratchet hits share the step's locks
+    uint16_t lockIndex = ScheduledEvent::NO_LOCKS;
+    if (pattern.hasStepLocks(track, step)) {
+        locks.push_back(pattern.getStepLocks(track, step));
+        lockIndex = static_cast<uint16_t>(locks.size() - 1);
+    }
+
+    // One event per ratchet hit; all hits share the step's probability roll
+    for (uint32_t hit = 0; hit < data.ratchetCount; ++hit) {
+        int64_t tick = (baseTick + hit * ratchetTicks) % cycleTicks;
+        if (tick < 0) {
+            tick += cycleTicks;
+        }
+
+        ScheduledEvent event;
+        event.tick = static_cast<uint32_t>(tick);
+        event.step = static_cast<uint16_t>(step);
+        event.flags = offBeat ? ScheduledEvent::FLAG_SWING : 0;
+        event.track = static_cast<uint8_t>(track);
+        event.velocity = data.velocity;
+        event.probability = data.probability;
+        event.locks = lockIndex;
+        events.push_back(event);
+    }
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,115 @@
+#ifndef PATTERN_SCHEDULE_H
+#define PATTERN_SCHEDULE_H
+
+#include "Pattern.h"
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * ScheduledEvent
+ *
+ * One compiled trigger: where it falls in the pattern (in clock ticks),
+ * which track it plays and how.
+ */
+struct ScheduledEvent {
+    static constexpr uint16_t FLAG_SWING = 1 << 0;  // Off-beat 16th: swing applies
+    static constexpr uint16_t NO_LOCKS = UINT16_MAX;
+
+    uint32_t tick;      // Offset from the start of the track's cycle in clock ticks
+    uint16_t step;      // Track step the event was compiled from
+    uint16_t flags;     // FLAG_* bits
+    uint8_t track;        // Track index
+    uint8_t velocity;     // 1-127
+    uint8_t probability;  // Trigger chance in percent
+    uint16_t locks;       // Index into the schedule's parameter locks, NO_LOCKS if none
+};
+static_assert(std::is_trivially_copyable<ScheduledEvent>::value, "Events must stay POD");
+
+/**
+ * PatternSchedule
+ *
+ * The audio thread's view of a pattern: a flat array of POD events
+ * grouped by track, each group sorted by tick, plus the POD track state
+ * playback needs (cycle lengths, mutes). Every track is its own cyclic
+ * stream: a track with its own length or rate loops over its own cycle,
+ * so tracks can run polymetrically against the pattern. The audio thread
+ * walks each stream with a cursor. No strings or other Pattern members are
+ * reachable from here, so the editor can change or reload the Pattern
+ * while it plays. Built on the editor thread and
+ * published to the audio thread as an immutable snapshot; after an edit
+ * only the changed span of steps is regenerated. Microtiming and ratchets
+ * are expanded here, so an event may sit outside its own step's window
+ * (wrapping around the end of its track's cycle). Parameter locks are
+ * copied into a side table that only locked events index, so unlocked
+ * tracks carry nothing extra.
+ */
+class PatternSchedule {
+public:
+    // Compile a whole pattern
+    static std::unique_ptr<PatternSchedule> compile(const Pattern& pattern);
+
+    // Copy `previous`, regenerating only steps [firstStep, lastStep]
+    static std::unique_ptr<PatternSchedule> recompileSpan(const PatternSchedule& previous,
+                                                          const Pattern& pattern,
+                                                          uint32_t firstStep, uint32_t lastStep);
+
+    // Copy `previous` with the pattern's current track settings (mutes)
+    static std::unique_ptr<PatternSchedule> updateTrackSettings(const PatternSchedule& previous,
+                                                                const Pattern& pattern);
+
+    uint32_t getLengthSteps() const { return lengthSteps_; }
+    uint32_t getLengthTicks() const;
+
+    // Bit t set if track t is muted
+    uint16_t getMutedMask() const { return mutedMask_; }
+
+    const std::vector<ScheduledEvent>& getEvents() const { return events_; }
+    uint32_t getEventCount() const { return static_cast<uint32_t>(events_.size()); }
+
+    // Track t's events are getEvents()[getTrackBegin(t), getTrackEnd(t))
+    uint32_t getTrackBegin(uint32_t track) const { return trackOffsets_[track]; }
+    uint32_t getTrackEnd(uint32_t track) const { return trackOffsets_[track + 1]; }
+
+    // Parameter locks of an event with locks != NO_LOCKS
+    const StepLocks& getLocks(uint16_t index) const { return locks_[index]; }
+
+    // Length of track t's cycle in clock ticks
+    uint32_t getCycleTicks(uint32_t track) const { return cycleTicks_[track]; }
+
+    // Index of the first event of `track` with tick >= `tick`
+    uint32_t findFirstAtOrAfter(uint32_t track, uint32_t tick) const;
+
+    // Every track's events over [0, lengthTicks), repeating each track's
+    // cycle, sorted by tick (for export; not for the audio thread)
+    std::vector<ScheduledEvent> expand(uint32_t lengthTicks) const;
+
+private:
+    PatternSchedule() : lengthSteps_(0), mutedMask_(0)
+    {
+        trackOffsets_.fill(0);
+        cycleTicks_.fill(0);
+    }
+
+    std::vector<ScheduledEvent> events_;
+    std::vector<StepLocks> locks_;  // Indexed by ScheduledEvent::locks
+    std::array<uint32_t, Pattern::NUM_TRACKS + 1> trackOffsets_;
+    std::array<uint32_t, Pattern::NUM_TRACKS> cycleTicks_;
+    uint32_t lengthSteps_;
+    uint16_t mutedMask_;
+
+    // True if the track lengths and rates still match `pattern`
+    bool hasSameGeometry(const Pattern& pattern) const;
+
+    // Append the events of one track step (and its locks)
+    static void appendStepEvents(const Pattern& pattern, uint32_t track, uint32_t step,
+                                 std::vector<ScheduledEvent>& events, std::vector<StepLocks>& locks);
+};
+
+} // namespace DrumMachine
+
+#endif // PATTERN_SCHEDULE_H
@@ -0,0 +1,32 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+namespace DrumMachine {
+
+/**
+ * Counter-based random numbers (SplitMix64 finaliser).
+ *
+ * A roll depends only on the seed and a counter built from the musical
+ * position, never on how many rolls came before. Playback from the same
+ * seed therefore gives the same result at any block size, which keeps
+ * offline renders reproducible.
+ */
+inline uint64_t splitMix64(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// Uniform value in [0, 100) for `counter` under `seed`
+inline uint32_t randomPercent(uint64_t seed, uint64_t counter)
+{
+    return static_cast<uint32_t>(((splitMix64(seed ^ splitMix64(counter)) >> 32) * 100) >> 32);
+}
+
+} // namespace DrumMachine
+
+#endif // RANDOM_H
@@ -1,52 +1,638 @@
 #include "Sequencer.h"
+#include "Random.h"
+#include "../core/HostClock.h"
 #include <cmath>
+#include <algorithm>
 
 namespace DrumMachine {
 
 Sequencer::Sequencer(uint32_t sampleRate)
-    : sampleRate_(sampleRate), absoluteFrameCounter_(0)
+    : editSlot_(0), recorder_(timeline_), clockSync_(transport_, timeline_), sampleRate_(sampleRate),
+      absoluteFrameCounter_(0), requestedSlot_(0), songMode_(false), randomSeed_(1),
+      clockOutput_(false), noteOutput_(false), outputLatency_(0), playingSlotView_(0),
+      songEntryView_(NO_SLOT), playingSlot_(0), armedSlot_(NO_SLOT), armedEntry_(NO_SLOT),
+      songEntry_(NO_SLOT), songRepeat_(0), streamHeapSize_(0), streamHeapDirty_(false), globalTick_(0),
+      clockOutRunning_(false), blockHostMicros_(0.0), lastBlockFrames_(0)
 {
+    for (auto& request : laneRequests_) {
+        request.store(NO_SLOT, std::memory_order_relaxed);
+    }
+    for (Lane& lane : lanes_) {
+        lane = {NO_SLOT, nullptr, 0};
+    }
+    for (StreamCursor& cursor : streams_) {
+        cursor = {0, 0, 0, INACTIVE_STREAM};
+    }
+    blockSchedules_.fill(nullptr);
+
+    transport_.setSampleRate(sampleRate);
+    publishPendingEdits();
+}
+
+void Sequencer::selectPattern(uint32_t slot)
+{
+    if (slot >= NUM_PATTERN_SLOTS) {
+        return;
+    }
+    editSlot_ = slot;
+    requestedSlot_.store(slot, std::memory_order_relaxed);
+}
+
+void Sequencer::setLanePattern(uint32_t lane, uint32_t slot)
+{
+    if (lane == 0 || lane >= NUM_LANES || (slot >= NUM_PATTERN_SLOTS && slot != NO_SLOT)) {
+        return;
+    }
+    laneRequests_[lane].store(slot, std::memory_order_relaxed);
+}
+
+uint32_t Sequencer::getLanePattern(uint32_t lane) const
+{
+    if (lane == 0) {
+        return requestedSlot_.load(std::memory_order_relaxed);
+    }
+    return lane < NUM_LANES ? laneRequests_[lane].load(std::memory_order_relaxed) : NO_SLOT;
+}
+
+void Sequencer::setOutputLatencyMicros(uint32_t micros)
+{
+    outputLatency_.store(micros, std::memory_order_relaxed);
+    recorder_.setOutputLatencyMicros(micros);
+    clockSync_.setOutputLatencyMicros(micros);
+}
+
+void Sequencer::rewind()
+{
+    transport_.reset();
+    pendingTriggers_.clear();
+    absoluteFrameCounter_ = 0;
+    playingSlot_ = requestedSlot_.load(std::memory_order_relaxed);
+    armedSlot_ = NO_SLOT;
+    armedEntry_ = NO_SLOT;
+    songEntry_ = NO_SLOT;
+    songRepeat_ = 0;
+    for (Lane& lane : lanes_) {
+        lane = {NO_SLOT, nullptr, 0};
+    }
+    streamHeapSize_ = 0;
+    streamHeapDirty_ = false;
+    globalTick_ = 0;
+    clockOutRunning_ = false;  // Clock output restarts with Start
+}
+
+void Sequencer::setMeter(const Meter& meter)
+{
+    transport_.setMeter(meter);
+    getPattern().setLength(transport_.getBarCount() * meter.getStepsPerBar());
+}
+
+void Sequencer::setBarCount(uint32_t bars)
+{
+    transport_.setBarCount(bars);
+    getPattern().setLength(transport_.getBarCount() * transport_.getActiveStepsPerBar());
+}
+
+void Sequencer::publishPendingEdits()
+{
+    applyRecordedHits();
+
+    for (uint32_t slot = 0; slot < NUM_PATTERN_SLOTS; ++slot) {
+        RtSnapshot<PatternSchedule>& schedule = schedules_[slot];
+
+        Pattern& pattern = patterns_[slot];
+        uint32_t firstStep = 0;
+        uint32_t lastStep = 0;
+        bool stepsEdited = pattern.takeEditSpan(firstStep, lastStep);
+        bool settingsEdited = pattern.takeTrackSettingsModified();
+        if (stepsEdited) {
+            recordHistory(slot, firstStep, lastStep);
+        } else {
+            recordHistory(slot, PatternHistory::NO_SPAN, PatternHistory::NO_SPAN);
+        }
+        if (!stepsEdited && !settingsEdited) {
+            // Nothing to publish; still free versions the audio thread has let go of
+            schedule.reclaim();
+            continue;
+        }
+
+        const PatternSchedule* current = schedule.peek();
+        if (!current) {
+            schedule.publish(PatternSchedule::compile(pattern));
+        } else if (stepsEdited) {
+            schedule.publish(PatternSchedule::recompileSpan(*current, pattern, firstStep, lastStep));
+        } else {
+            schedule.publish(PatternSchedule::updateTrackSettings(*current, pattern));
+        }
+    }
+
+    transport_.publishTempoMap();
+
+    if (song_.takeModified()) {
+        songSnapshot_.publish(std::make_unique<Song>(song_));
+    } else {
+        songSnapshot_.reclaim();
+    }
 }
 
 bool Sequencer::shouldTrigger(uint32_t trackIndex, uint32_t step, uint64_t currentSample)
 {
     // Check if step is active for this track
-    if (!pattern_.isStepActive(trackIndex, step)) {
+    if (!getPattern().isStepActive(trackIndex, step)) {
         return false;
     }
 
     // Check if track is muted
-    if (pattern_.isTrackMuted(trackIndex)) {
+    if (getPattern().isTrackMuted(trackIndex)) {
         return false;
     }
 
-    // TODO: Implement timing check with swing
-    // Get expected sample for this step (considering swing)
-    // Return true if currentSample matches
+    // Timing (including swing) is resolved by process(), which only asks
+    // about steps whose boundary falls inside the current block
+    (void)currentSample;
 
     return true;
 }
 
-void Sequencer::advanceFrame(uint32_t numFrames)
+void Sequencer::process(uint32_t numFrames, TriggerBuffer& triggers)
 {
-    // Advance transport by numFrames (once per sample)
-    for (uint32_t i = 0; i < numFrames; i++) {
-        transport_.advanceFrame(sampleRate_);
+    triggers.clear();
+
+    uint64_t blockStart = absoluteFrameCounter_;
+    uint64_t blockEnd = blockStart + numFrames;
+
+    // An external Start plays from the top
+    if (clockSync_.takeRestart()) {
+        rewind();
+        blockStart = 0;
+        blockEnd = numFrames;
+    }
+
+    const uint64_t blockHostMicros = nextBlockHostMicros(numFrames);
+    drainLiveNotes(blockHostMicros, numFrames, triggers);
+    const bool clockOutput = clockOutput_.load(std::memory_order_relaxed);
+    const bool noteOutput = noteOutput_.load(std::memory_order_relaxed);
+    if (clockOutRunning_ && (!clockOutput || transport_.getPlayState() != Transport::PlayState::Playing)) {
+        sendMidi(blockHostMicros, 0.0, 1, 0xFC);  // Stop
+        clockOutRunning_ = false;
+    }
+
+    if (transport_.getPlayState() != Transport::PlayState::Playing) {
+        // Swung triggers still pending when the transport stops are dropped
+        pendingTriggers_.clear();
+        timeline_.invalidate();  // Nothing to record or sync against
+        triggers.sortByOffset();
+        absoluteFrameCounter_ = blockEnd;
+        return;
+    }
+
+    // Triggers delayed past the end of an earlier block
+    pendingTriggers_.drainDue(blockStart, numFrames, triggers);
+
+    // Decide what follows the current loop before the block is played
+    blockSchedules_.fill(nullptr);
+    armNextLoop();
+
+    uint32_t crossed = transport_.advance(numFrames, stepBoundaries_.data(), MAX_STEP_BOUNDARIES);
+    crossed = std::min(crossed, MAX_STEP_BOUNDARIES);
+
+    // Latest compiled patterns; lanes whose schedule changed are re-seeked
+    syncLane(0, playingSlot_);
+    for (uint32_t lane = 1; lane < NUM_LANES; ++lane) {
+        syncLane(lane, lanes_[lane].slot);
+    }
+
+    const uint64_t seed = randomSeed_.load(std::memory_order_relaxed);
+    const double samplesPerTick = transport_.getSamplesPerStep() / MusicalClock::TICKS_PER_STEP;
+    const uint32_t swingFrames = static_cast<uint32_t>(
+        std::lround(transport_.getSwing() * transport_.getSamplesPerStep()));
+    auto later = [this](uint8_t a, uint8_t b) { return streamLater(a, b); };
+
+    for (uint32_t i = 0; i < crossed; ++i) {
+        const Transport::StepBoundary& boundary = stepBoundaries_[i];
+        uint64_t stepFrame = blockStart + boundary.frameOffset;
+
+        if (boundary.loopStep == 0) {
+            // Pattern and lane switches land exactly on the loop boundary;
+            // the new slots' schedules were compiled and published long before
+            onLoopStart();
+            syncLane(0, playingSlot_);
+            for (uint32_t lane = 1; lane < NUM_LANES; ++lane) {
+                syncLane(lane, laneRequests_[lane].load(std::memory_order_relaxed));
+            }
+
+            // Re-phase the main lane if the loop no longer matches its length
+            Lane& main = lanes_[0];
+            if (main.schedule && (globalTick_ - main.originTick) % main.schedule->getLengthTicks() != 0) {
+                main.originTick = globalTick_;
+                seekLane(0);
+            }
+        }
+        if (streamHeapDirty_) {
+            rebuildStreamHeap();
+        }
+
+        // Tell the recorder and clock sync where playback is on the host timeline
+        if (i == 0) {
+            const uint64_t boundaryMicros = blockHostMicros + boundary.frameOffset * 1000000ull / sampleRate_;
+            timeline_.publish({boundaryMicros, globalTick_, static_cast<int64_t>(globalTick_ - lanes_[0].originTick),
+                               sampleRate_ / samplesPerTick, playingSlot_});
+        }
+
+        if (clockOutput) {
+            sendClock(boundary.frameOffset, blockHostMicros, samplesPerTick);
+        }
+
+        // Pop every stream whose next event falls inside this step
+        const uint64_t windowEnd = globalTick_ + MusicalClock::TICKS_PER_STEP;
+        while (streamHeapSize_ > 0 && streams_[streamHeap_[0]].nextTick < windowEnd) {
+            const uint32_t stream = streamHeap_[0];
+            const uint32_t lane = stream / Pattern::NUM_TRACKS;
+            const StreamCursor& cursor = streams_[stream];
+            const PatternSchedule& schedule = *lanes_[lane].schedule;
+            const ScheduledEvent& event = schedule.getEvents()[cursor.index];
+
+            bool play = !(schedule.getMutedMask() & (1u << event.track));
+
+            // Probability roll keyed by cycle, lane, step and track, so all
+            // ratchet hits of a step live or die together
+            if (play && event.probability < 100) {
+                uint64_t counter = (static_cast<uint64_t>(cursor.cycle) << 16)
+                    | (lane << 12) | (static_cast<uint64_t>(event.step) << 4) | event.track;
+                play = randomPercent(seed, counter) < event.probability;
+            }
+
+            if (play) {
+                uint64_t dueFrame = stepFrame
+                    + static_cast<uint64_t>(std::lround((cursor.nextTick - globalTick_) * samplesPerTick));
+                if (event.flags & ScheduledEvent::FLAG_SWING) {
+                    dueFrame += swingFrames;
+                }
+
+                // Locks ride along by value; the schedule may be retired
+                // before a pending trigger fires
+                const StepLocks locks = event.locks == ScheduledEvent::NO_LOCKS
+                    ? StepLocks() : schedule.getLocks(event.locks);
+                if (dueFrame < blockEnd) {
+                    triggers.push({static_cast<uint32_t>(dueFrame - blockStart), event.track, event.velocity, locks});
+                } else {
+                    pendingTriggers_.push(dueFrame, event.track, event.velocity, locks);
+                }
+                if (noteOutput) {
+                    sendNote(blockHostMicros, static_cast<double>(dueFrame - blockStart), event.track, event.velocity);
+                }
+            }
+
+            std::pop_heap(streamHeap_.begin(), streamHeap_.begin() + streamHeapSize_, later);
+            advanceStream(stream);
+            std::push_heap(streamHeap_.begin(), streamHeap_.begin() + streamHeapSize_, later);
+        }
+
+        globalTick_ = windowEnd;
+    }
+
+    triggers.sortByOffset();
+    absoluteFrameCounter_ = blockEnd;
+}
+
+bool Sequencer::playLiveNote(uint32_t trackIndex, uint8_t velocity, uint64_t hostMicros)
+{
+    if (trackIndex >= Pattern::NUM_TRACKS || velocity == 0) {
+        return false;
+    }
+    return liveNotes_.push({hostMicros, trackIndex, velocity});
+}
+
+void Sequencer::drainLiveNotes(uint64_t blockHostMicros, uint32_t numFrames, TriggerBuffer& triggers)
+{
+    // A hit arrives while the previous block plays, so it sounds one block
+    // after it was played. The fixed delay keeps a hit's timing within the
+    // block instead of snapping it to the block start.
+    LiveNote note;
+    while (liveNotes_.pop(note)) {
+        const double delayFrames = (static_cast<double>(note.hostMicros) - static_cast<double>(blockHostMicros))
+            * sampleRate_ / 1000000.0 + numFrames;
+        const double lastFrame = static_cast<double>(numFrames - 1);
+        TriggerEvent event;
+        event.frameOffset = static_cast<uint32_t>(std::min(std::max(delayFrames, 0.0), lastFrame));
+        event.trackIndex = note.trackIndex;
+        event.velocity = note.velocity;
+        triggers.push(event);
+    }
+}
+
+uint64_t Sequencer::nextBlockHostMicros(uint32_t numFrames)
+{
+    // Lean slowly towards the measured time so clock drift is followed;
+    // a large gap (first block, xrun) resyncs
+    const double measured = static_cast<double>(hostTimeMicros());
+    const double predicted = blockHostMicros_ + lastBlockFrames_ * 1000000.0 / sampleRate_;
+    if (blockHostMicros_ == 0.0 || std::fabs(measured - predicted) > 5000.0) {
+        blockHostMicros_ = measured;
+    } else {
+        blockHostMicros_ = predicted + (measured - predicted) * 0.05;
+    }
+    lastBlockFrames_ = numFrames;
+    return static_cast<uint64_t>(blockHostMicros_);
+}
+
+void Sequencer::sendClock(uint32_t stepFrame, uint64_t blockHostMicros, double samplesPerTick)
+{
+    if (!clockOutRunning_) {
+        if (globalTick_ == 0) {
+            sendMidi(blockHostMicros, stepFrame, 1, 0xFA);  // Start
+        } else {
+            // Song Position Pointer counts 16ths, one per step
+            const uint32_t position = static_cast<uint32_t>(
+                std::min<uint64_t>(globalTick_ / MusicalClock::TICKS_PER_STEP, 0x3FFF));
+            sendMidi(blockHostMicros, stepFrame, 3, 0xF2, position & 0x7F, position >> 7);
+            sendMidi(blockHostMicros, stepFrame, 1, 0xFB);  // Continue
+        }
+        clockOutRunning_ = true;
+    }
+
+    // Pulses fall on exact tick multiples inside the step
+    const double pulseFrames = MidiClockSync::TICKS_PER_PULSE * samplesPerTick;
+    for (uint32_t pulse = 0; pulse < CLOCK_PULSES_PER_STEP; ++pulse) {
+        sendMidi(blockHostMicros, stepFrame + pulse * pulseFrames, 1, 0xF8);
     }
+}
+
+void Sequencer::sendNote(uint64_t blockHostMicros, double frameOffset, uint32_t track, uint32_t velocity)
+{
+    const uint8_t channel = kitMap_.channelForTrack(track);
+    const uint8_t note = kitMap_.noteForTrack(track);
+    const double gateFrames = NOTE_GATE_MICROS * 1e-6 * sampleRate_;
+    sendMidi(blockHostMicros, frameOffset, 3, 0x90 | channel, note, static_cast<uint8_t>(velocity));
+    sendMidi(blockHostMicros, frameOffset + gateFrames, 3, 0x80 | channel, note, 0);
+}
+
+void Sequencer::sendMidi(uint64_t blockHostMicros, double frameOffset, uint8_t size, uint8_t status,
+                         uint8_t data1, uint8_t data2)
+{
+    OutgoingMidi message;
+    message.hostMicros = blockHostMicros + outputLatency_.load(std::memory_order_relaxed)
+        + static_cast<uint64_t>(std::llround(frameOffset * 1000000.0 / sampleRate_));
+    message.size = size;
+    message.data[0] = status;
+    message.data[1] = data1;
+    message.data[2] = data2;
+    midiOut_.push(message);  // Dropped if no output thread drains the queue
+}
+
+bool Sequencer::undo()
+{
+    return restoreFromHistory(false);
+}
+
+bool Sequencer::redo()
+{
+    return restoreFromHistory(true);
+}
+
+bool Sequencer::restoreFromHistory(bool redoing)
+{
+    // Edits not yet published get their own level first
+    for (uint32_t slot = 0; slot < NUM_PATTERN_SLOTS; ++slot) {
+        recordHistory(slot, PatternHistory::NO_SPAN, PatternHistory::NO_SPAN);
+    }
+
+    uint32_t slot = NO_SLOT;
+    bool restored = redoing ? history_.redo(patterns_.data(), slot) : history_.undo(patterns_.data(), slot);
+    if (!restored) {
+        return false;
+    }
+
+    // The swapped-in version shares its tracks; only its schedule is rebuilt
+    committed_[slot] = patterns_[slot];
+    patterns_[slot].markAllEdited();
+    return true;
+}
+
+void Sequencer::recordHistory(uint32_t slot, uint32_t firstStep, uint32_t lastStep)
+{
+    if (patterns_[slot].getRevision() == committed_[slot].getRevision()) {
+        return;
+    }
+    history_.record(slot, committed_[slot], firstStep, lastStep, hostTimeMicros());
+    committed_[slot] = patterns_[slot];
+}
+
+void Sequencer::applyRecordedHits()
+{
+    const bool quantize = recorder_.isQuantize();
+
+    RecordedHit hit;
+    while (recorder_.takeHit(hit)) {
+        if (hit.slot >= NUM_PATTERN_SLOTS || hit.track >= Pattern::NUM_TRACKS) {
+            continue;
+        }
+
+        // Fold the lane position into the track's own cycle and find the
+        // nearest step on the track's grid
+        Pattern& pattern = patterns_[hit.slot];
+        const int64_t stepTicks = pattern.getTrackStepTicks(hit.track);
+        const int64_t length = pattern.getTrackLength(hit.track);
+        int64_t tick = hit.laneTick % (length * stepTicks);
+        if (tick < 0) {
+            tick += length * stepTicks;
+        }
+        int64_t step = (tick + stepTicks / 2) / stepTicks;
+        const int64_t offset = tick - step * stepTicks;
+        step %= length;
+
+        pattern.setStepActive(hit.track, static_cast<uint32_t>(step), true);
+        StepData data = pattern.getStepData(hit.track, static_cast<uint32_t>(step));
+        data.velocity = hit.velocity;
+        data.microtiming = quantize ? 0 : static_cast<int8_t>(std::clamp<int64_t>(
+            offset, -StepData::MAX_MICROTIMING, StepData::MAX_MICROTIMING));
+        pattern.setStepData(hit.track, static_cast<uint32_t>(step), data);
+    }
+}
+
+void Sequencer::armNextLoop()
+{
+    const bool songMode = songMode_.load(std::memory_order_relaxed);
+    if (transport_.isLoopChangeArmed()) {
+        // Already decided, unless the user picked another pattern since
+        bool reselected = !songMode && armedEntry_ == NO_SLOT
+            && requestedSlot_.load(std::memory_order_relaxed) != armedSlot_;
+        if (!reselected) {
+            return;
+        }
+    }
+
+    uint32_t nextSlot = NO_SLOT;
+    uint32_t nextEntry = NO_SLOT;
+    Transport::LoopChange change = {0, 0, 0};
+    Meter meter = transport_.getMeter();
+
+    const Song* song = songMode ? songSnapshot_.acquire() : nullptr;
+    if (song && !song->isEmpty()) {
+        const uint32_t entryCount = song->getEntryCount();
+        if (songEntry_ >= entryCount) {
+            nextEntry = 0;  // Song starts (or its chain was shortened)
+        } else if (songRepeat_ + 1 < song->getEntry(songEntry_).repeats) {
+            return;  // Same entry plays again, nothing changes
+        } else {
+            nextEntry = (songEntry_ + 1) % entryCount;  // Chain loops
+        }
+
+        const SongEntry& entry = song->getEntry(nextEntry);
+        nextSlot = std::min(entry.patternSlot, NUM_PATTERN_SLOTS - 1);
+        if (entry.tempo > 0.0f) {
+            change.tempoMilliBpm = static_cast<uint32_t>(std::lround(entry.tempo * 1000.0f));
+        }
+        if (entry.changesMeter) {
+            meter = entry.meter;
+            change.meter = meter.pack();
+        }
+    } else {
+        uint32_t requested = requestedSlot_.load(std::memory_order_relaxed);
+        if (requested >= NUM_PATTERN_SLOTS
+            || (requested == playingSlot_ && !transport_.isLoopChangeArmed())) {
+            return;
+        }
+        nextSlot = requested;
+    }
+
+    // Loop length follows the incoming pattern
+    const uint32_t stepsPerBar = meter.getStepsPerBar();
+    const uint32_t length = scheduleForSlot(nextSlot)->getLengthSteps();
+    change.bars = std::clamp((length + stepsPerBar - 1) / stepsPerBar, 1u, Pattern::MAX_BARS);
+
+    transport_.armLoopChange(change);
+    armedSlot_ = nextSlot;
+    armedEntry_ = nextEntry;
+}
+
+void Sequencer::onLoopStart()
+{
+    if (armedSlot_ != NO_SLOT) {
+        playingSlot_ = armedSlot_;
+        songEntry_ = armedEntry_;
+        songRepeat_ = 0;
+        armedSlot_ = NO_SLOT;
+    } else if (songEntry_ != NO_SLOT) {
+        if (songMode_.load(std::memory_order_relaxed)) {
+            songRepeat_++;
+        } else {
+            songEntry_ = NO_SLOT;
+        }
+    }
+
+    playingSlotView_.store(playingSlot_, std::memory_order_relaxed);
+    songEntryView_.store(songEntry_, std::memory_order_relaxed);
+}
+
+const PatternSchedule* Sequencer::scheduleForSlot(uint32_t slot)
+{
+    if (!blockSchedules_[slot]) {
+        blockSchedules_[slot] = schedules_[slot].acquire();
+    }
+    return blockSchedules_[slot];
+}
+
+void Sequencer::syncLane(uint32_t lane, uint32_t slot)
+{
+    Lane& state = lanes_[lane];
+    const PatternSchedule* schedule = slot != NO_SLOT ? scheduleForSlot(slot) : nullptr;
+    if (slot != state.slot) {
+        state.slot = slot;
+        state.originTick = globalTick_;
+    } else if (schedule == state.schedule) {
+        return;
+    }
+
+    state.schedule = schedule;
+    seekLane(lane);
+}
+
+void Sequencer::seekLane(uint32_t lane)
+{
+    const Lane& state = lanes_[lane];
+    const uint64_t laneTick = globalTick_ - state.originTick;
+
+    for (uint32_t track = 0; track < Pattern::NUM_TRACKS; ++track) {
+        StreamCursor& cursor = streams_[lane * Pattern::NUM_TRACKS + track];
+        const PatternSchedule* schedule = state.schedule;
+        if (!schedule || schedule->getTrackBegin(track) == schedule->getTrackEnd(track)) {
+            cursor.index = INACTIVE_STREAM;
+            continue;
+        }
+
+        const uint64_t cycleTicks = schedule->getCycleTicks(track);
+        cursor.cycle = static_cast<uint32_t>(laneTick / cycleTicks);
+        cursor.cycleStart = state.originTick + cursor.cycle * cycleTicks;
+        cursor.index = schedule->findFirstAtOrAfter(
+            track, static_cast<uint32_t>(laneTick - cursor.cycle * cycleTicks));
+        if (cursor.index == schedule->getTrackEnd(track)) {
+            cursor.index = schedule->getTrackBegin(track);
+            cursor.cycleStart += cycleTicks;
+            cursor.cycle++;
+        }
+        cursor.nextTick = cursor.cycleStart + schedule->getEvents()[cursor.index].tick;
+    }
+
+    streamHeapDirty_ = true;
+}
+
+void Sequencer::advanceStream(uint32_t stream)
+{
+    const uint32_t track = stream % Pattern::NUM_TRACKS;
+    const PatternSchedule& schedule = *lanes_[stream / Pattern::NUM_TRACKS].schedule;
+    StreamCursor& cursor = streams_[stream];
+
+    if (++cursor.index == schedule.getTrackEnd(track)) {
+        cursor.index = schedule.getTrackBegin(track);
+        cursor.cycleStart += schedule.getCycleTicks(track);
+        cursor.cycle++;
+    }
+    cursor.nextTick = cursor.cycleStart + schedule.getEvents()[cursor.index].tick;
+}
+
+void Sequencer::rebuildStreamHeap()
+{
+    streamHeapSize_ = 0;
+    for (uint32_t stream = 0; stream < NUM_STREAMS; ++stream) {
+        if (streams_[stream].index != INACTIVE_STREAM) {
+            streamHeap_[streamHeapSize_++] = static_cast<uint8_t>(stream);
+        }
+    }
+    std::make_heap(streamHeap_.begin(), streamHeap_.begin() + streamHeapSize_,
+                   [this](uint8_t a, uint8_t b) { return streamLater(a, b); });
+    streamHeapDirty_ = false;
+}
+
+bool Sequencer::streamLater(uint8_t a, uint8_t b) const
+{
+    // Ties go to the lower stream id, so simultaneous hits keep a fixed order
+    const uint64_t tickA = streams_[a].nextTick;
+    const uint64_t tickB = streams_[b].nextTick;
+    return tickA != tickB ? tickA > tickB : a > b;
+}
+
+void Sequencer::advanceFrame(uint32_t numFrames)
+{
+    // Advance transport by the whole block; step boundaries are exact
+    transport_.advance(numFrames);
     absoluteFrameCounter_ += numFrames;
 }
 
-uint32_t Sequencer::getSwingDelayedSample(uint32_t stepIndex, uint32_t baseSample) const
+uint32_t Sequencer::getSwingDelayFrames(uint32_t stepIndex) const
 {
-    // Swing applies to even-numbered steps (2, 4, 6, etc.)
+    // Swing delays the off-beat 16ths (steps 1, 3, 5, ... in 0-based indexing)
     if (stepIndex % 2 == 0) {
-        float swingAmount = transport_.getSwing();
-        uint32_t samplesPerStep = transport_.getSamplesPerStep(sampleRate_);
-        uint32_t swingDelay = static_cast<uint32_t>(swingAmount * samplesPerStep);
-        return baseSample + swingDelay;
+        return 0;
     }
 
-    return baseSample;
+    float swingAmount = transport_.getSwing();
+    double samplesPerStep = transport_.getSamplesPerStep();
+    return static_cast<uint32_t>(std::lround(swingAmount * samplesPerStep));
+}
+
+uint32_t Sequencer::getSwingDelayedSample(uint32_t stepIndex, uint32_t baseSample) const
+{
+    return baseSample + getSwingDelayFrames(stepIndex);
 }
 
 } // namespace DrumMachine
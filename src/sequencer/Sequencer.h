@@ -3,8 +3,21 @@
 
 #include "Pattern.h"
 #include "Transport.h"
+#include "TriggerQueue.h"
+#include "PatternSchedule.h"
+#include "Song.h"
+#include "LiveRecorder.h"
+#include "PatternHistory.h"
+#include "TimelineAnchor.h"
+#include "MidiClockSync.h"
+#include "OutgoingMidi.h"
+#include "KitMap.h"
+#include "../core/RtSnapshot.h"
+#include "../core/SpscQueue.h"
 #include <memory>
 #include <vector>
+#include <array>
+#include <atomic>
 
 namespace DrumMachine {
 
@@ -13,35 +26,287 @@ namespace DrumMachine {
  * 
  * Main sequencer logic.
  * Manages pattern playback, step scheduling, and timing.
+ * Holds a bank of patterns and a song chain; in song mode the chain
+ * decides which pattern plays and switches happen on the loop boundary.
+ * Extra lanes play further bank slots alongside it on the same transport.
+ * Every track of every lane is a cyclic event stream; process() merges
+ * the streams with a small min-heap keyed by their next event, so its
+ * cost follows the events in the block, not lanes x steps.
+ * It can also send MIDI clock (24 PPQN) derived sample-accurately from
+ * the transport, and follow an external clock through MidiClockSync.
  * Milestone 2: Step sequencer logic with swing
  */
 class Sequencer {
 public:
+    static constexpr uint32_t NUM_PATTERN_SLOTS = 8;
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint32_t NUM_LANES = 4;  // Lane 0 plays the bank/song
+
     Sequencer(uint32_t sampleRate = 44100);
 
-    // Pattern management
-    Pattern& getPattern() { return pattern_; }
-    const Pattern& getPattern() const { return pattern_; }
+    // Pattern being edited (the selected bank slot)
+    Pattern& getPattern() { return patterns_[editSlot_]; }
+    const Pattern& getPattern() const { return patterns_[editSlot_]; }
+
+    // Pattern bank
+    Pattern& getPattern(uint32_t slot) { return patterns_[slot]; }
+    const Pattern& getPattern(uint32_t slot) const { return patterns_[slot]; }
+
+    // Select the slot to edit; outside song mode it also becomes the
+    // playing pattern at the next loop boundary
+    void selectPattern(uint32_t slot);
+    uint32_t getSelectedSlot() const { return editSlot_; }
+
+    // Slot currently heard (written by the audio thread)
+    uint32_t getPlayingSlot() const { return playingSlotView_.load(std::memory_order_relaxed); }
+
+    // Lanes 1..NUM_LANES-1 play another bank slot in parallel with the
+    // main pattern (NO_SLOT = off). A change starts at the next loop
+    // boundary, so lanes stay in phase with the main pattern.
+    void setLanePattern(uint32_t lane, uint32_t slot);
+    uint32_t getLanePattern(uint32_t lane) const;
+
+    // Song chain (edit on the UI thread, then publishPendingEdits())
+    Song& getSong() { return song_; }
+    const Song& getSong() const { return song_; }
+
+    void setSongMode(bool enabled) { songMode_.store(enabled, std::memory_order_relaxed); }
+    bool isSongMode() const { return songMode_.load(std::memory_order_relaxed); }
+
+    // Song entry currently heard, NO_SLOT when not playing a song
+    uint32_t getSongPosition() const { return songEntryView_.load(std::memory_order_relaxed); }
+
+    // Undo/redo of pattern edits across the bank. Every publish that
+    // carries edits becomes a level; the restored pattern goes out with
+    // the next publishPendingEdits().
+    bool undo();
+    bool redo();
+    bool canUndo() const { return history_.canUndo(); }
+    bool canRedo() const { return history_.canRedo(); }
+    void clearUndoHistory() { history_.clear(); }
+
+    // Live MIDI recording into the playing pattern. Recorded hits are
+    // written by publishPendingEdits().
+    LiveRecorder& getRecorder() { return recorder_; }
+
+    // Host time <-> transport position, published by the audio thread
+    const TimelineAnchor& getTimeline() const { return timeline_; }
+
+    // Delay from rendering a block to hearing it; recording, clock output
+    // and clock sync compensate for it
+    void setOutputLatencyMicros(uint32_t micros);
+
+    // Follow an external MIDI clock (feed it from the MIDI thread)
+    MidiClockSync& getClockSync() { return clockSync_; }
+
+    // MIDI thread: sound a track for a pad hit played at host time
+    // `hostMicros`, whether or not the transport is playing. The audio
+    // thread plays it one block after it was played. False if the ring
+    // is full.
+    bool playLiveNote(uint32_t trackIndex, uint8_t velocity, uint64_t hostMicros);
+
+    // Send MIDI clock, Start/Continue/Stop and Song Position Pointer.
+    // Messages are queued for a MIDI output thread (takeOutgoingMidi).
+    void setClockOutput(bool enabled) { clockOutput_.store(enabled, std::memory_order_relaxed); }
+    bool isClockOutput() const { return clockOutput_.load(std::memory_order_relaxed); }
+
+    // Send a note-on/off pair for every scheduled hit, on the track's
+    // channel and note from the kit map. Stamped like the clock, so
+    // external modules line up with the samples.
+    void setNoteOutput(bool enabled) { noteOutput_.store(enabled, std::memory_order_relaxed); }
+    bool isNoteOutput() const { return noteOutput_.load(std::memory_order_relaxed); }
+
+    // Note and channel of each track for note output (copied). Call
+    // before the audio thread runs.
+    void setKitMap(const KitMap& kitMap) { kitMap_ = kitMap; }
+
+    // MIDI output thread: next outgoing message, false when none are
+    // waiting. Notes may be queued ahead of clock messages stamped
+    // earlier (swing, microtiming), so the sender orders by time.
+    bool takeOutgoingMidi(OutgoingMidi& message) { return midiOut_.pop(message); }
 
     // Transport access
     Transport& getTransport() { return transport_; }
     const Transport& getTransport() const { return transport_; }
 
+    // Time signature and bar count; the edited pattern is resized to match
+    void setMeter(const Meter& meter);
+    void setBarCount(uint32_t bars);
+
+    // Write recorded hits, then recompile the edited parts of every
+    // pattern and publish them, the song chain and the tempo map to the
+    // audio thread. Call from the thread that edits the patterns (UI),
+    // after edits.
+    void publishPendingEdits();
+
+    // Seed for step probability rolls. Rolls depend only on the seed and
+    // the musical position, so renders from the same seed are identical.
+    void setRandomSeed(uint64_t seed) { randomSeed_.store(seed, std::memory_order_relaxed); }
+    uint64_t getRandomSeed() const { return randomSeed_.load(std::memory_order_relaxed); }
+
+    // Return playback to the start of the pattern/song. Only call while
+    // the audio callback is not running (e.g. before an offline render);
+    // an external MIDI Start rewinds from inside process().
+    void rewind();
+
     // Check if a note should trigger on this step
     // Takes swing into account
     bool shouldTrigger(uint32_t trackIndex, uint32_t step, uint64_t currentSample);
 
-    // Advance sequencer by one audio frame
+    // Advance sequencer by one audio block and collect the sample-accurate
+    // triggers falling inside it (called from the audio thread)
+    void process(uint32_t numFrames, TriggerBuffer& triggers);
+
+    // Advance sequencer by one audio block without collecting triggers
     void advanceFrame(uint32_t numFrames);
 
+    // Swing delay in frames for a step (odd 16ths are delayed).
+    // Shared by the scheduler and the swing visualizer.
+    uint32_t getSwingDelayFrames(uint32_t stepIndex) const;
+
     // Get swing-delayed sample position for a step
     uint32_t getSwingDelayedSample(uint32_t stepIndex, uint32_t baseSample) const;
 
 private:
-    Pattern pattern_;
+    static constexpr uint32_t MAX_STEP_BOUNDARIES = 16; // Per block
+    static constexpr uint32_t NUM_STREAMS = NUM_LANES * Pattern::NUM_TRACKS;
+    static constexpr uint32_t INACTIVE_STREAM = UINT32_MAX;
+    static constexpr uint32_t CLOCK_PULSES_PER_STEP = MusicalClock::TICKS_PER_STEP / MidiClockSync::TICKS_PER_PULSE;
+    static constexpr uint32_t NOTE_GATE_MICROS = 20000;  // Note-on to note-off for note output
+    static_assert(NUM_STREAMS <= 256, "Stream ids are 8 bits wide");
+
+    // One pattern playing on the shared transport
+    struct Lane {
+        uint32_t slot;                    // NO_SLOT when off
+        const PatternSchedule* schedule;  // Version the lane's streams point into
+        uint64_t originTick;              // Global tick where the lane started
+    };
+
+    // Cursor over one track of one lane (stream id = lane * NUM_TRACKS + track)
+    struct StreamCursor {
+        uint64_t nextTick;    // Global tick of the next event
+        uint64_t cycleStart;  // Global tick where the current cycle began
+        uint32_t cycle;       // Cycles completed since the lane started
+        uint32_t index;       // Next event in the schedule, INACTIVE_STREAM if none
+    };
+
+    std::array<Pattern, NUM_PATTERN_SLOTS> patterns_;
+    std::array<Pattern, NUM_PATTERN_SLOTS> committed_;  // Versions last recorded in history_
+    PatternHistory history_;
+    uint32_t editSlot_;
+    Song song_;
     Transport transport_;
+    TimelineAnchor timeline_;
+    LiveRecorder recorder_;
+    MidiClockSync clockSync_;
     uint32_t sampleRate_;
     uint64_t absoluteFrameCounter_; // Global frame counter for timing
+
+    // UI -> audio requests
+    std::atomic<uint32_t> requestedSlot_;
+    std::atomic<bool> songMode_;
+    std::atomic<uint64_t> randomSeed_;
+    std::array<std::atomic<uint32_t>, NUM_LANES> laneRequests_;
+    std::atomic<bool> clockOutput_;
+    std::atomic<bool> noteOutput_;
+    std::atomic<uint32_t> outputLatency_;
+
+    // Audio -> UI display
+    std::atomic<uint32_t> playingSlotView_;
+    std::atomic<uint32_t> songEntryView_;
+
+    // Audio-thread scheduling state (preallocated)
+    std::array<Transport::StepBoundary, MAX_STEP_BOUNDARIES> stepBoundaries_;
+    PendingTriggerQueue pendingTriggers_;
+
+    // Compiled patterns and song: written by the editor thread, read by
+    // the audio thread. Every slot is kept compiled, so switching
+    // patterns never compiles anything in the callback.
+    std::array<RtSnapshot<PatternSchedule>, NUM_PATTERN_SLOTS> schedules_;
+    RtSnapshot<Song> songSnapshot_;
+
+    // Audio thread: playback position in the bank/song
+    uint32_t playingSlot_;
+    uint32_t armedSlot_;      // Slot that starts at the next loop boundary
+    uint32_t armedEntry_;     // Song entry that starts with it (NO_SLOT if none)
+    uint32_t songEntry_;      // NO_SLOT when no song is playing
+    uint32_t songRepeat_;     // Passes completed of the current entry
+
+    // Audio thread: lanes and their merged event streams
+    std::array<Lane, NUM_LANES> lanes_;
+    std::array<StreamCursor, NUM_STREAMS> streams_;
+    std::array<uint8_t, NUM_STREAMS> streamHeap_;  // Min-heap of stream ids by nextTick
+    uint32_t streamHeapSize_;
+    bool streamHeapDirty_;
+    uint64_t globalTick_;  // Tick of the next step boundary since rewind
+
+    // MIDI thread -> audio thread: pad hits to sound
+    struct LiveNote {
+        uint64_t hostMicros;
+        uint32_t trackIndex;
+        uint32_t velocity;
+    };
+    SpscQueue<LiveNote, 256> liveNotes_;
+
+    // Audio thread -> MIDI output thread
+    SpscQueue<OutgoingMidi, 1024> midiOut_;
+    bool clockOutRunning_;  // Start/Continue sent, Stop not yet
+    KitMap kitMap_;         // Track notes and channels for note output
+
+    // Audio thread: smoothed host time of the block's first frame
+    double blockHostMicros_;
+    uint32_t lastBlockFrames_;
+
+    // Schedules acquired this block, one acquire per slot so lanes sharing
+    // a slot never re-pin it under each other
+    std::array<const PatternSchedule*, NUM_PATTERN_SLOTS> blockSchedules_;
+
+    // Audio thread: turn queued pad hits into triggers for this block
+    void drainLiveNotes(uint64_t blockHostMicros, uint32_t numFrames, TriggerBuffer& triggers);
+
+    // Write hits from the recorder into the bank (pattern owner thread)
+    void applyRecordedHits();
+
+    // Add an undo level if `slot` changed since it was last recorded
+    void recordHistory(uint32_t slot, uint32_t firstStep, uint32_t lastStep);
+
+    bool restoreFromHistory(bool redoing);
+
+    // Decide what plays after the current loop and arm the transport
+    void armNextLoop();
+
+    // Loop start reached: make the armed slot/entry current
+    void onLoopStart();
+
+    const PatternSchedule* scheduleForSlot(uint32_t slot);
+
+    // Point a lane at `slot` (restarting it if the slot changed) and pick
+    // up a newly published version of its schedule
+    void syncLane(uint32_t lane, uint32_t slot);
+
+    // Position a lane's stream cursors at globalTick_
+    void seekLane(uint32_t lane);
+
+    // Step a stream to its next event, wrapping into the next cycle
+    void advanceStream(uint32_t stream);
+
+    // Host time of the block about to be rendered, following the frame
+    // count rather than the jittery callback wake-up time
+    uint64_t nextBlockHostMicros(uint32_t numFrames);
+
+    // Queue clock output for the step starting at `stepFrame` (block-relative)
+    void sendClock(uint32_t stepFrame, uint64_t blockHostMicros, double samplesPerTick);
+
+    // Queue note-on and note-off for a hit `frameOffset` frames into the
+    // block (may lie beyond it)
+    void sendNote(uint64_t blockHostMicros, double frameOffset, uint32_t track, uint32_t velocity);
+
+    // Queue a message leaving `frameOffset` frames into the block, as heard
+    void sendMidi(uint64_t blockHostMicros, double frameOffset, uint8_t size, uint8_t status,
+                  uint8_t data1 = 0, uint8_t data2 = 0);
+
+    void rebuildStreamHeap();
+    bool streamLater(uint8_t a, uint8_t b) const;
 };
 
 } // namespace DrumMachine
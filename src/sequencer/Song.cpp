@@ -0,0 +1,49 @@
+#include "Song.h"
+#include <algorithm>
+
+namespace DrumMachine {
+
+bool Song::addEntry(const SongEntry& entry)
+{
+    if (entries_.size() >= MAX_ENTRIES) {
+        return false;
+    }
+    entries_.push_back(entry);
+    entries_.back().repeats = std::max(entry.repeats, 1u);
+    modified_ = true;
+    return true;
+}
+
+void Song::removeEntry(uint32_t index)
+{
+    if (index >= entries_.size()) {
+        return;
+    }
+    entries_.erase(entries_.begin() + index);
+    modified_ = true;
+}
+
+void Song::setEntry(uint32_t index, const SongEntry& entry)
+{
+    if (index >= entries_.size()) {
+        return;
+    }
+    entries_[index] = entry;
+    entries_[index].repeats = std::max(entry.repeats, 1u);
+    modified_ = true;
+}
+
+void Song::clear()
+{
+    entries_.clear();
+    modified_ = true;
+}
+
+bool Song::takeModified()
+{
+    bool modified = modified_;
+    modified_ = false;
+    return modified;
+}
+
+} // namespace DrumMachine
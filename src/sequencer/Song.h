@@ -0,0 +1,56 @@
+#ifndef SONG_H
+#define SONG_H
+
+#include "Meter.h"
+#include <cstdint>
+#include <vector>
+
+namespace DrumMachine {
+
+/**
+ * SongEntry
+ *
+ * One link of the song chain: a pattern slot played `repeats` times,
+ * optionally changing tempo and time signature when it starts.
+ */
+struct SongEntry {
+    uint32_t patternSlot = 0;
+    uint32_t repeats = 1;
+    float tempo = 0.0f;      // BPM; 0 keeps the current tempo
+    bool changesMeter = false;
+    Meter meter;             // Used when changesMeter is set
+};
+
+/**
+ * Song
+ *
+ * Ordered chain of pattern slots for song mode. Edited on the UI thread;
+ * the sequencer publishes a copy to the audio thread when it changes.
+ */
+class Song {
+public:
+    static constexpr uint32_t MAX_ENTRIES = 64;
+
+    Song() : modified_(true) {}
+
+    // Returns false if the chain is full
+    bool addEntry(const SongEntry& entry);
+    void removeEntry(uint32_t index);
+    void setEntry(uint32_t index, const SongEntry& entry);
+    void clear();
+
+    const SongEntry& getEntry(uint32_t index) const { return entries_[index]; }
+    uint32_t getEntryCount() const { return static_cast<uint32_t>(entries_.size()); }
+    bool isEmpty() const { return entries_.empty(); }
+
+    // True once after each change (used to republish the song)
+    bool takeModified();
+
+private:
+    std::vector<SongEntry> entries_;
+    bool modified_;
+};
+
+} // namespace DrumMachine
+
+#endif // SONG_H
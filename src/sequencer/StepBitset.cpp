@@ -0,0 +1,26 @@
+#include "StepBitset.h"
+
+namespace DrumMachine {
+
+uint32_t StepBitset::count(uint32_t length) const
+{
+    if (length > MAX_STEPS) {
+        length = MAX_STEPS;
+    }
+
+    uint32_t total = 0;
+    uint32_t fullWords = length / WORD_BITS;
+    for (uint32_t i = 0; i < fullWords; ++i) {
+        total += popcount64(words_[i]);
+    }
+
+    uint32_t tailBits = length % WORD_BITS;
+    if (tailBits > 0) {
+        uint64_t mask = (uint64_t(1) << tailBits) - 1;
+        total += popcount64(words_[fullWords] & mask);
+    }
+
+    return total;
+}
+
+} // namespace DrumMachine
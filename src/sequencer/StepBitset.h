@@ -0,0 +1,95 @@
+#ifndef STEP_BITSET_H
+#define STEP_BITSET_H
+
+#include <cstdint>
+#include <array>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace DrumMachine {
+
+// Portable 64-bit population count
+inline uint32_t popcount64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<uint32_t>(__popcnt64(value));
+#elif defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_popcountll(value));
+#else
+    uint32_t count = 0;
+    while (value) {
+        value &= value - 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Index of the lowest set bit (value must be non-zero)
+inline uint32_t countTrailingZeros(uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, value);
+    return static_cast<uint32_t>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctz(value));
+#else
+    uint32_t index = 0;
+    while ((value & 1u) == 0) {
+        value >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/**
+ * StepBitset
+ *
+ * Compact on/off step storage for one track: one uint64_t word per
+ * 64 steps. Supports variable-length multi-bar patterns up to MAX_STEPS.
+ */
+class StepBitset {
+public:
+    static constexpr uint32_t WORD_BITS = 64;
+    static constexpr uint32_t NUM_WORDS = 4;
+    static constexpr uint32_t MAX_STEPS = NUM_WORDS * WORD_BITS;
+
+    StepBitset() { words_.fill(0); }
+
+    bool test(uint32_t step) const
+    {
+        return step < MAX_STEPS && (words_[step / WORD_BITS] >> (step % WORD_BITS)) & 1u;
+    }
+
+    void set(uint32_t step, bool active)
+    {
+        if (step >= MAX_STEPS) return;
+        const uint64_t bit = uint64_t(1) << (step % WORD_BITS);
+        if (active) {
+            words_[step / WORD_BITS] |= bit;
+        } else {
+            words_[step / WORD_BITS] &= ~bit;
+        }
+    }
+
+    void clear() { words_.fill(0); }
+
+    uint64_t getWord(uint32_t wordIndex) const { return words_[wordIndex]; }
+
+    // Number of active steps in [0, length)
+    uint32_t count(uint32_t length = MAX_STEPS) const;
+
+    // Number of active steps before `step` (index into per-step data)
+    uint32_t rank(uint32_t step) const { return count(step); }
+
+private:
+    std::array<uint64_t, NUM_WORDS> words_;
+};
+
+} // namespace DrumMachine
+
+#endif // STEP_BITSET_H
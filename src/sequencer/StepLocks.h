@@ -0,0 +1,62 @@
+#ifndef STEP_LOCKS_H
+#define STEP_LOCKS_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace DrumMachine {
+
+/**
+ * StepLocks
+ *
+ * Parameter locks of one step: overrides of track parameters for that
+ * hit only, packed into 8 bytes. Only locked steps store one; the engine
+ * applies them once, when the hit's voice starts.
+ */
+struct StepLocks {
+    // Lock bits
+    static constexpr uint8_t VOLUME = 1 << 0;
+    static constexpr uint8_t PAN = 1 << 1;
+    static constexpr uint8_t PITCH = 1 << 2;
+    static constexpr uint8_t DECAY = 1 << 3;
+    static constexpr uint8_t SAMPLE_START = 1 << 4;
+    static constexpr uint8_t ALL = VOLUME | PAN | PITCH | DECAY | SAMPLE_START;
+
+    static constexpr int8_t MAX_PITCH = 24;  // Semitones either way
+
+    uint8_t mask = 0;         // Locked parameters (bits above)
+    uint8_t volume = 127;     // Level 0-127 (127 = unity)
+    int8_t pan = 0;           // -64 (left) to 63 (right)
+    int8_t pitch = 0;         // Semitones, -MAX_PITCH to MAX_PITCH
+    uint8_t decay = 127;      // Fade-out over this share of the sample, 0-127 (127 = none)
+    uint8_t sampleStart = 0;  // Share of the sample to skip, 0-127
+    uint16_t reserved = 0;
+
+    bool any() const { return mask != 0; }
+    bool has(uint8_t bit) const { return (mask & bit) != 0; }
+
+    // Pack into 64 bits for the parameter bus
+    uint64_t pack() const
+    {
+        return mask | (uint64_t(volume) << 8) | (uint64_t(static_cast<uint8_t>(pan)) << 16) |
+               (uint64_t(static_cast<uint8_t>(pitch)) << 24) | (uint64_t(decay) << 32) |
+               (uint64_t(sampleStart) << 40);
+    }
+    static StepLocks unpack(uint64_t packed)
+    {
+        StepLocks locks;
+        locks.mask = static_cast<uint8_t>(packed);
+        locks.volume = static_cast<uint8_t>(packed >> 8);
+        locks.pan = static_cast<int8_t>(packed >> 16);
+        locks.pitch = static_cast<int8_t>(packed >> 24);
+        locks.decay = static_cast<uint8_t>(packed >> 32);
+        locks.sampleStart = static_cast<uint8_t>(packed >> 40);
+        return locks;
+    }
+};
+static_assert(sizeof(StepLocks) == 8, "StepLocks should stay packed");
+static_assert(std::is_trivially_copyable<StepLocks>::value, "Locks travel in POD triggers");
+
+} // namespace DrumMachine
+
+#endif // STEP_LOCKS_H
@@ -0,0 +1,195 @@
+#include "TempoMap.h"
+#include "MusicalClock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DrumMachine {
+
+namespace {
+
+// Seconds per tick at a constant tempo
+double secondsPerTick(double bpm)
+{
+    return 60.0 / (MusicalClock::PPQN * bpm);
+}
+
+} // namespace
+
+bool TempoMap::addPoint(const TempoPoint& point)
+{
+    TempoPoint clamped = point;
+    clamped.bpm = std::clamp(point.bpm, MusicalClock::MIN_BPM, MusicalClock::MAX_BPM);
+
+    auto it = std::lower_bound(points_.begin(), points_.end(), clamped.tick,
+                               [](const TempoPoint& p, uint64_t tick) { return p.tick < tick; });
+    if (it != points_.end() && it->tick == clamped.tick) {
+        *it = clamped;
+    } else {
+        if (points_.size() >= MAX_POINTS) {
+            return false;
+        }
+        points_.insert(it, clamped);
+    }
+
+    rebuild();
+    return true;
+}
+
+void TempoMap::removePoint(uint32_t index)
+{
+    if (index >= points_.size()) {
+        return;
+    }
+    points_.erase(points_.begin() + index);
+    rebuild();
+}
+
+void TempoMap::setPoint(uint32_t index, const TempoPoint& point)
+{
+    if (index >= points_.size()) {
+        return;
+    }
+    // Re-insert so the list stays sorted if the tick moved
+    points_.erase(points_.begin() + index);
+    addPoint(point);
+}
+
+void TempoMap::clear()
+{
+    points_.clear();
+    rebuild();
+}
+
+bool TempoMap::takeModified()
+{
+    bool modified = modified_;
+    modified_ = false;
+    return modified;
+}
+
+double TempoMap::getBpmAt(double tick) const
+{
+    if (points_.empty()) {
+        return 120.0;
+    }
+    if (tick <= static_cast<double>(points_[0].tick)) {
+        return points_[0].bpm;
+    }
+
+    uint32_t index = findSegment(tick);
+    const TempoPoint& start = points_[index];
+    if (index + 1 >= points_.size() || start.shape == TempoPoint::Shape::Step) {
+        return start.bpm;
+    }
+
+    const TempoPoint& end = points_[index + 1];
+    double length = static_cast<double>(end.tick - start.tick);
+    double t = (tick - static_cast<double>(start.tick)) / length;
+    if (start.shape == TempoPoint::Shape::Linear) {
+        return start.bpm + (end.bpm - start.bpm) * t;
+    }
+    return start.bpm * std::pow(static_cast<double>(end.bpm) / start.bpm, t);
+}
+
+double TempoMap::secondsAtTick(double tick) const
+{
+    if (points_.empty()) {
+        return tick * secondsPerTick(120.0);
+    }
+
+    // Before the first point its tempo applies
+    const TempoPoint& first = points_[0];
+    if (tick < static_cast<double>(first.tick)) {
+        return pointSeconds_[0] + (tick - static_cast<double>(first.tick)) * secondsPerTick(first.bpm);
+    }
+
+    uint32_t index = findSegment(tick);
+    return pointSeconds_[index] + segmentSeconds(index, tick - static_cast<double>(points_[index].tick));
+}
+
+double TempoMap::tickAtSeconds(double seconds) const
+{
+    if (points_.empty()) {
+        return seconds / secondsPerTick(120.0);
+    }
+
+    const TempoPoint& first = points_[0];
+    if (seconds < pointSeconds_[0]) {
+        return static_cast<double>(first.tick) + (seconds - pointSeconds_[0]) / secondsPerTick(first.bpm);
+    }
+
+    // Last point reached at or before `seconds`
+    auto it = std::upper_bound(pointSeconds_.begin(), pointSeconds_.end(), seconds);
+    uint32_t index = static_cast<uint32_t>(it - pointSeconds_.begin()) - 1;
+    return static_cast<double>(points_[index].tick) + segmentTicks(index, seconds - pointSeconds_[index]);
+}
+
+uint32_t TempoMap::findSegment(double tick) const
+{
+    auto it = std::upper_bound(points_.begin(), points_.end(), tick,
+                               [](double value, const TempoPoint& p) { return value < static_cast<double>(p.tick); });
+    return it == points_.begin() ? 0 : static_cast<uint32_t>(it - points_.begin()) - 1;
+}
+
+double TempoMap::segmentSeconds(uint32_t index, double ticks) const
+{
+    const TempoPoint& start = points_[index];
+    const double b0 = start.bpm;
+    if (index + 1 >= points_.size() || start.shape == TempoPoint::Shape::Step ||
+        points_[index + 1].bpm == start.bpm) {
+        return ticks * secondsPerTick(b0);
+    }
+
+    const TempoPoint& end = points_[index + 1];
+    const double length = static_cast<double>(end.tick - start.tick);
+    const double b1 = end.bpm;
+
+    if (start.shape == TempoPoint::Shape::Linear) {
+        // bpm(x) = b0 + d x  =>  t(x) = 60 / (PPQN d) * ln(1 + d x / b0)
+        const double d = (b1 - b0) / length;
+        return 60.0 / (MusicalClock::PPQN * d) * std::log1p(d * ticks / b0);
+    }
+
+    // bpm(x) = b0 e^(k x)  =>  t(x) = 60 / (PPQN b0) * (1 - e^(-k x)) / k
+    const double k = std::log(b1 / b0) / length;
+    return secondsPerTick(b0) * -std::expm1(-k * ticks) / k;
+}
+
+double TempoMap::segmentTicks(uint32_t index, double seconds) const
+{
+    const TempoPoint& start = points_[index];
+    const double b0 = start.bpm;
+    if (index + 1 >= points_.size() || start.shape == TempoPoint::Shape::Step ||
+        points_[index + 1].bpm == start.bpm) {
+        return seconds / secondsPerTick(b0);
+    }
+
+    const TempoPoint& end = points_[index + 1];
+    const double length = static_cast<double>(end.tick - start.tick);
+    const double b1 = end.bpm;
+
+    if (start.shape == TempoPoint::Shape::Linear) {
+        const double d = (b1 - b0) / length;
+        return b0 / d * std::expm1(seconds * MusicalClock::PPQN * d / 60.0);
+    }
+
+    const double k = std::log(b1 / b0) / length;
+    return -std::log1p(-seconds * k / secondsPerTick(b0)) / k;
+}
+
+void TempoMap::rebuild()
+{
+    modified_ = true;
+    pointSeconds_.resize(points_.size());
+    if (points_.empty()) {
+        return;
+    }
+
+    pointSeconds_[0] = static_cast<double>(points_[0].tick) * secondsPerTick(points_[0].bpm);
+    for (uint32_t i = 0; i + 1 < points_.size(); ++i) {
+        double length = static_cast<double>(points_[i + 1].tick - points_[i].tick);
+        pointSeconds_[i + 1] = pointSeconds_[i] + segmentSeconds(i, length);
+    }
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,82 @@
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <cstdint>
+#include <vector>
+
+namespace DrumMachine {
+
+/**
+ * TempoPoint
+ *
+ * A tempo breakpoint. `shape` describes how the tempo moves from this
+ * point to the next one.
+ */
+struct TempoPoint {
+    enum class Shape : uint8_t {
+        Step,         // Hold this tempo, jump at the next point
+        Linear,       // Tempo changes linearly with musical position
+        Exponential   // Tempo changes by a constant ratio per tick (curved)
+    };
+
+    uint64_t tick = 0;        // Musical position (MusicalClock ticks)
+    float bpm = 120.0f;
+    Shape shape = Shape::Step;
+};
+
+/**
+ * TempoMap
+ *
+ * Tempo automation as a list of breakpoints with ramp shapes.
+ * Every segment has a closed-form position <-> time integral, so the
+ * transport, the UI, MIDI export and offline renders all derive the same
+ * times from a tick with no per-block accumulation. Before the first
+ * point its tempo applies; after the last point its tempo holds.
+ *
+ * Edited on the UI thread and published to the audio thread as an
+ * immutable copy.
+ */
+class TempoMap {
+public:
+    static constexpr uint32_t MAX_POINTS = 64;
+
+    TempoMap() : modified_(true) {}
+
+    // Insert a point (replacing one at the same tick). Returns false if full.
+    bool addPoint(const TempoPoint& point);
+    void removePoint(uint32_t index);
+    void setPoint(uint32_t index, const TempoPoint& point);
+    void clear();
+
+    const TempoPoint& getPoint(uint32_t index) const { return points_[index]; }
+    uint32_t getPointCount() const { return static_cast<uint32_t>(points_.size()); }
+    bool isEmpty() const { return points_.empty(); }
+
+    // Tempo at a (fractional) tick
+    double getBpmAt(double tick) const;
+
+    // Seconds from tick 0 to `tick`, and the inverse
+    double secondsAtTick(double tick) const;
+    double tickAtSeconds(double seconds) const;
+
+    // True once after each change (used to republish the map)
+    bool takeModified();
+
+private:
+    std::vector<TempoPoint> points_;     // Sorted by tick
+    std::vector<double> pointSeconds_;   // Time at each point (prefix integral)
+    bool modified_;
+
+    // Index of the segment containing `tick` (last point at or before it)
+    uint32_t findSegment(double tick) const;
+
+    // Seconds spent going `ticks` into segment `index`, and the inverse
+    double segmentSeconds(uint32_t index, double ticks) const;
+    double segmentTicks(uint32_t index, double seconds) const;
+
+    void rebuild();
+};
+
+} // namespace DrumMachine
+
+#endif // TEMPO_MAP_H
@@ -0,0 +1,53 @@
+#include "TimelineAnchor.h"
+
+namespace DrumMachine {
+
+TimelineAnchor::TimelineAnchor()
+    : sequence_(0), hostMicros_(0), transportTick_(0), laneTick_(0), ticksPerSecond_(0.0),
+      slot_(TimelinePoint::NO_SLOT)
+{
+}
+
+void TimelineAnchor::publish(const TimelinePoint& point)
+{
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    hostMicros_.store(point.hostMicros, std::memory_order_relaxed);
+    transportTick_.store(point.transportTick, std::memory_order_relaxed);
+    laneTick_.store(point.laneTick, std::memory_order_relaxed);
+    ticksPerSecond_.store(point.ticksPerSecond, std::memory_order_relaxed);
+    slot_.store(point.slot, std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void TimelineAnchor::invalidate()
+{
+    if (slot_.load(std::memory_order_relaxed) != TimelinePoint::NO_SLOT) {
+        publish({0, 0, 0, 0.0, TimelinePoint::NO_SLOT});
+    }
+}
+
+TimelinePoint TimelineAnchor::read() const
+{
+    TimelinePoint point;
+    for (;;) {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        point.hostMicros = hostMicros_.load(std::memory_order_relaxed);
+        point.transportTick = transportTick_.load(std::memory_order_relaxed);
+        point.laneTick = laneTick_.load(std::memory_order_relaxed);
+        point.ticksPerSecond = ticksPerSecond_.load(std::memory_order_relaxed);
+        point.slot = slot_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            return point;
+        }
+    }
+}
+
+} // namespace DrumMachine
@@ -0,0 +1,63 @@
+#ifndef TIMELINE_ANCHOR_H
+#define TIMELINE_ANCHOR_H
+
+#include <cstdint>
+#include <atomic>
+
+namespace DrumMachine {
+
+/**
+ * TimelinePoint
+ *
+ * Where playback was at one host time: the transport's tick since it was
+ * rewound and the main lane's tick since that lane started, plus how fast
+ * both were moving.
+ */
+struct TimelinePoint {
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    uint64_t hostMicros;
+    uint64_t transportTick;
+    int64_t laneTick;
+    double ticksPerSecond;
+    uint32_t slot;  // Main lane's bank slot, NO_SLOT when nothing plays
+
+    bool isValid() const { return slot != NO_SLOT && ticksPerSecond > 0.0; }
+};
+
+/**
+ * TimelineAnchor
+ *
+ * Maps host time onto the musical timeline. The audio thread publishes a
+ * fresh point once per step, at the first step boundary of a block (blocks
+ * without one publish nothing); other threads read it without locking
+ * through a sequence lock and extrapolate at most a step from it, at the
+ * point's tick rate, so conversions never drift.
+ *
+ * Threading: publish() from the audio thread, read() from any thread.
+ */
+class TimelineAnchor {
+public:
+    TimelineAnchor();
+
+    // Audio thread
+    void publish(const TimelinePoint& point);
+
+    // Audio thread: nothing is playing
+    void invalidate();
+
+    // Consistent copy of the latest point
+    TimelinePoint read() const;
+
+private:
+    std::atomic<uint32_t> sequence_;  // Odd while being written
+    std::atomic<uint64_t> hostMicros_;
+    std::atomic<uint64_t> transportTick_;
+    std::atomic<int64_t> laneTick_;
+    std::atomic<double> ticksPerSecond_;
+    std::atomic<uint32_t> slot_;
+};
+
+} // namespace DrumMachine
+
+#endif // TIMELINE_ANCHOR_H
@@ -1,4 +1,5 @@
 #include "Transport.h"
+#include "Pattern.h"
 #include <cmath>
 #include <algorithm>
 
@@ -6,93 +7,170 @@ namespace DrumMachine {
 
 Transport::Transport()
     : playState_(PlayState::Stopped), tempoInBPM_(120.0f), swing_(0.0f),
-      timeSignature_("4/4"), barCount_(1), currentStep_(0), currentBar_(0),
-      frameCounter_(0)
+      requestedMeter_(Meter().pack()), barCount_(1), currentStep_(0), currentBar_(0),
+      nextStepTick_(0), nextLoopStep_(0), tempoMapEnabled_(false), loopChange_{0, 0, 0}, loopChangeArmed_(false)
 {
 }
 
+void Transport::setSampleRate(uint32_t sampleRate)
+{
+    clock_.setSampleRate(sampleRate);
+}
+
 void Transport::play()
 {
-    playState_ = PlayState::Playing;
+    playState_.store(PlayState::Playing, std::memory_order_relaxed);
 }
 
 void Transport::stop()
 {
-    playState_ = PlayState::Stopped;
+    playState_.store(PlayState::Stopped, std::memory_order_relaxed);
 }
 
 void Transport::reset()
 {
     currentStep_ = 0;
     currentBar_ = 0;
-    frameCounter_ = 0;
+    clock_.reset();
+    nextStepTick_ = 0;
+    nextLoopStep_ = 0;
+    loopChangeArmed_ = false;
 }
 
 void Transport::setTempo(float bpm)
 {
-    tempoInBPM_ = std::clamp(bpm, 60.0f, 180.0f);
+    tempoInBPM_.store(std::clamp(bpm, MusicalClock::MIN_BPM, MusicalClock::MAX_BPM),
+                      std::memory_order_relaxed);
+}
+
+void Transport::publishTempoMap()
+{
+    if (tempoMap_.takeModified()) {
+        tempoMapSnapshot_.publish(std::make_unique<TempoMap>(tempoMap_));
+    } else {
+        tempoMapSnapshot_.reclaim();
+    }
 }
 
 void Transport::setSwing(float swing)
 {
-    swing_ = std::clamp(swing, 0.0f, 0.6f);
+    swing_.store(std::clamp(swing, 0.0f, 0.6f), std::memory_order_relaxed);
+}
+
+void Transport::setMeter(const Meter& meter)
+{
+    requestedMeter_.store(meter.pack(), std::memory_order_relaxed);
 }
 
 void Transport::setTimeSignature(const std::string& timeSig)
 {
-    timeSignature_ = timeSig;
+    Meter meter;
+    if (Meter::parse(timeSig, meter)) {
+        setMeter(meter);
+    }
 }
 
 void Transport::setBarCount(uint32_t bars)
 {
-    barCount_ = std::clamp(bars, 1u, 5u);
+    barCount_.store(std::clamp(bars, 1u, Pattern::MAX_BARS), std::memory_order_relaxed);
 }
 
-uint32_t Transport::getSamplesPerStep(uint32_t sampleRate) const
+void Transport::armLoopChange(const LoopChange& change)
 {
-    // 16 steps per bar, 4 beats per bar (4/4)
-    // BPM = beats per minute
-    // beats per second = BPM / 60
-    // seconds per beat = 60 / BPM
-    // seconds per step = (60 / BPM) / 4
-    // samples per step = (60 / BPM / 4) * sampleRate
-
-    float secondsPerStep = (60.0f / tempoInBPM_) / 4.0f;
-    return static_cast<uint32_t>(secondsPerStep * sampleRate);
+    loopChange_ = change;
+    loopChangeArmed_ = true;
 }
 
-uint32_t Transport::getActiveStepsPerBar() const
+void Transport::applyLoopChange()
 {
-    if (timeSignature_ == "3/4") {
-        return 12; // 3 beats * 4 steps per beat
-    } else if (timeSignature_ == "6/8") {
-        return 12; // 6 beats * 2 steps per beat (or 6 steps if thinking differently)
+    loopChangeArmed_ = false;
+
+    // Written back to the shared values so the UI shows what is playing
+    // and the next block does not undo the change
+    if (loopChange_.tempoMilliBpm != 0) {
+        setTempo(loopChange_.tempoMilliBpm / 1000.0f);
+        float bpm = tempoInBPM_.load(std::memory_order_relaxed);
+        clock_.setTempoMilliBpm(static_cast<uint32_t>(std::lround(bpm * 1000.0f)));
+    }
+    if (loopChange_.meter != 0) {
+        meter_ = Meter::unpack(loopChange_.meter);
+        requestedMeter_.store(meter_.pack(), std::memory_order_relaxed);
+    }
+    if (loopChange_.bars != 0) {
+        setBarCount(loopChange_.bars);
     }
-    return 16; // 4/4: 4 beats * 4 steps per beat
 }
 
-void Transport::advanceFrame(uint32_t sampleRate)
+uint32_t Transport::advance(uint32_t numFrames, StepBoundary* boundaries, uint32_t maxBoundaries)
 {
-    if (playState_ != PlayState::Playing) {
-        return;
+    if (playState_.load(std::memory_order_relaxed) != PlayState::Playing) {
+        return 0;
     }
 
-    uint32_t samplesPerStep = getSamplesPerStep(sampleRate);
-    frameCounter_++;
+    // Tempo automation takes over from the fixed tempo; a new map version
+    // re-anchors at the current position so playback stays continuous
+    const TempoMap* tempoMap = nullptr;
+    if (tempoMapEnabled_.load(std::memory_order_relaxed)) {
+        tempoMap = tempoMapSnapshot_.acquire();
+        if (tempoMap && tempoMap->isEmpty()) {
+            tempoMap = nullptr;
+        }
+    }
+    clock_.setTempoMap(tempoMap);
 
-    if (frameCounter_ >= samplesPerStep) {
-        frameCounter_ = 0;
-        currentStep_++;
+    // Apply tempo changes from the UI at block granularity
+    if (!tempoMap) {
+        float bpm = tempoInBPM_.load(std::memory_order_relaxed);
+        clock_.setTempoMilliBpm(static_cast<uint32_t>(std::lround(bpm * 1000.0f)));
+    }
 
-        if (currentStep_ >= 16) {
-            currentStep_ = 0;
-            currentBar_++;
+    // Meter changes only rebuild the precomputed layout (no string work)
+    uint16_t packedMeter = requestedMeter_.load(std::memory_order_relaxed);
+    if (packedMeter != meter_.pack()) {
+        meter_ = Meter::unpack(packedMeter);
+    }
+    uint32_t stepsPerBar = meter_.getStepsPerBar();
+    uint32_t loopSteps = stepsPerBar * barCount_.load(std::memory_order_relaxed);
+
+    // Step boundaries fall on exact tick multiples, so their frame
+    // positions come straight from the clock with no accumulated error
+    uint32_t crossed = 0;
+    uint32_t advanced = 0;  // Frames the clock has already been moved by
+    uint64_t offset = clock_.framesUntilTick(nextStepTick_);
+    while (offset < numFrames) {
+        // Wrap at the loop length of the current meter and bar count
+        uint32_t loopStep = nextLoopStep_ < loopSteps ? nextLoopStep_ : 0;
+
+        if (loopStep == 0 && loopChangeArmed_) {
+            // Move the clock to the loop start so the new tempo takes
+            // effect exactly there, then apply the change
+            clock_.advance(static_cast<uint32_t>(offset) - advanced);
+            advanced = static_cast<uint32_t>(offset);
+            applyLoopChange();
+            stepsPerBar = meter_.getStepsPerBar();
+            loopSteps = stepsPerBar * barCount_.load(std::memory_order_relaxed);
+        }
 
-            if (currentBar_ >= barCount_) {
-                currentBar_ = 0;
-            }
+        currentStep_ = loopStep % stepsPerBar;
+        currentBar_ = loopStep / stepsPerBar;
+        nextLoopStep_ = loopStep + 1;
+
+        if (boundaries && crossed < maxBoundaries) {
+            boundaries[crossed] = {static_cast<uint32_t>(offset), currentStep_, currentBar_, loopStep};
         }
+        crossed++;
+
+        nextStepTick_ += MusicalClock::TICKS_PER_STEP;
+        offset = advanced + clock_.framesUntilTick(nextStepTick_);
+    }
+
+    clock_.advance(numFrames - advanced);
+
+    // Show the automated tempo in the UI
+    if (tempoMap) {
+        tempoInBPM_.store(clock_.getTempoMilliBpm() / 1000.0f, std::memory_order_relaxed);
     }
+    return crossed;
 }
 
 } // namespace DrumMachine
@@ -1,8 +1,13 @@
 #ifndef TRANSPORT_H
 #define TRANSPORT_H
 
+#include "MusicalClock.h"
+#include "Meter.h"
+#include "TempoMap.h"
+#include "../core/RtSnapshot.h"
 #include <cstdint>
 #include <string>
+#include <atomic>
 
 namespace DrumMachine {
 
@@ -20,56 +25,108 @@ public:
         Playing
     };
 
+    // A step boundary crossed during advance()
+    struct StepBoundary {
+        uint32_t frameOffset;  // Frame within the block where the step starts
+        uint32_t step;         // Step within the bar
+        uint32_t bar;          // Bar within the loop
+        uint32_t loopStep;     // Step within the whole loop (bar * stepsPerBar + step)
+    };
+
+    // Tempo/meter/length change applied exactly where the loop next wraps
+    // (song mode and pattern switches). Zero fields keep the current value.
+    struct LoopChange {
+        uint32_t tempoMilliBpm;  // 0 = keep
+        uint16_t meter;          // Packed Meter, 0 = keep
+        uint32_t bars;           // 0 = keep
+    };
+
     Transport();
 
-    // Playback control
+    // Sample rate used by the musical clock
+    void setSampleRate(uint32_t sampleRate);
+
+    // Playback control (any thread)
     void play();
     void stop();
     void reset();
 
-    // Tempo (60-180 BPM)
+    // Tempo (MusicalClock::MIN_BPM to MAX_BPM). While tempo automation is
+    // on, this reports the automated tempo and setTempo() has no effect.
     void setTempo(float bpm);
-    float getTempo() const { return tempoInBPM_; }
+    float getTempo() const { return tempoInBPM_.load(std::memory_order_relaxed); }
 
     // Swing (0.0 to 0.6)
     void setSwing(float swing);
-    float getSwing() const { return swing_; }
+    float getSwing() const { return swing_.load(std::memory_order_relaxed); }
 
-    // Time signature
+    // Time signature (applied by the audio thread at the next block)
+    void setMeter(const Meter& meter);
+    Meter getMeter() const { return Meter::unpack(requestedMeter_.load(std::memory_order_relaxed)); }
+
+    // Time signature as text, e.g. "7/8" (UI convenience; ignored if invalid)
     void setTimeSignature(const std::string& timeSig);
-    std::string getTimeSignature() const { return timeSignature_; }
+    std::string getTimeSignature() const { return getMeter().toString(); }
+
+    // Tempo automation (edit on the UI thread, then publishTempoMap())
+    TempoMap& getTempoMap() { return tempoMap_; }
+    const TempoMap& getTempoMap() const { return tempoMap_; }
+    void publishTempoMap();
+
+    void setTempoMapEnabled(bool enabled) { tempoMapEnabled_.store(enabled, std::memory_order_relaxed); }
+    bool isTempoMapEnabled() const { return tempoMapEnabled_.load(std::memory_order_relaxed); }
 
-    // Bar count (1-5 bars per pattern)
+    // Bar count (1 to Pattern::MAX_BARS bars per pattern)
     void setBarCount(uint32_t bars);
-    uint32_t getBarCount() const { return barCount_; }
+    uint32_t getBarCount() const { return barCount_.load(std::memory_order_relaxed); }
 
     // Playback state
-    PlayState getPlayState() const { return playState_; }
+    PlayState getPlayState() const { return playState_.load(std::memory_order_relaxed); }
 
-    // Current step in grid (0-15 for single bar, extends for multi-bar)
+    // Current step within the bar (0 to stepsPerBar - 1)
     uint32_t getCurrentStep() const { return currentStep_; }
 
     // Current bar (0-based)
     uint32_t getCurrentBar() const { return currentBar_; }
 
-    // Samples per step (at current sample rate and tempo)
-    uint32_t getSamplesPerStep(uint32_t sampleRate) const;
+    // Exact samples per step (at current sample rate and tempo)
+    double getSamplesPerStep() const { return clock_.getSamplesPerStep(); }
+
+    // Drift-free musical position
+    const MusicalClock& getClock() const { return clock_; }
 
     // Get number of active steps for current time signature
-    uint32_t getActiveStepsPerBar() const;
+    uint32_t getActiveStepsPerBar() const { return getMeter().getStepsPerBar(); }
+
+    // Arm a change for the next loop start (audio thread only)
+    void armLoopChange(const LoopChange& change);
+    bool isLoopChangeArmed() const { return loopChangeArmed_; }
 
-    // Advance playback by one audio frame
-    void advanceFrame(uint32_t sampleRate);
+    // Advance playback by a block of frames.
+    // Step boundaries crossed inside the block are written to `boundaries`
+    // (up to maxBoundaries); returns the number of boundaries crossed.
+    uint32_t advance(uint32_t numFrames, StepBoundary* boundaries = nullptr,
+                     uint32_t maxBoundaries = 0);
 
 private:
-    PlayState playState_;
-    float tempoInBPM_;
-    float swing_;           // 0.0 to 0.6
-    std::string timeSignature_; // "4/4", "3/4", "6/8"
-    uint32_t barCount_;
-    uint32_t currentStep_;  // 0-15 within current bar
+    std::atomic<PlayState> playState_;  // Written by UI and MIDI clock sync
+    std::atomic<float> tempoInBPM_;  // Written by UI, applied by audio thread
+    std::atomic<float> swing_;  // 0.0 to 0.6
+    std::atomic<uint16_t> requestedMeter_;  // Packed Meter written by UI
+    std::atomic<uint32_t> barCount_;
+    Meter meter_;           // Meter in effect on the audio thread
+    uint32_t currentStep_;  // 0 to stepsPerBar - 1 within current bar
     uint32_t currentBar_;   // 0 to (barCount_ - 1)
-    uint64_t frameCounter_; // For sub-sample timing
+    MusicalClock clock_;    // Exact tick position
+    uint64_t nextStepTick_; // Tick at which the next step starts
+    uint32_t nextLoopStep_; // Loop position of the next step
+    TempoMap tempoMap_;                       // UI-side copy being edited
+    RtSnapshot<TempoMap> tempoMapSnapshot_;   // Published to the audio thread
+    std::atomic<bool> tempoMapEnabled_;
+    LoopChange loopChange_; // Armed change (audio thread only)
+    bool loopChangeArmed_;
+
+    void applyLoopChange();
 };
 
 } // namespace DrumMachine
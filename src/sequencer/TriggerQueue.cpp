@@ -0,0 +1,60 @@
+#include "TriggerQueue.h"
+
+namespace DrumMachine {
+
+bool TriggerBuffer::push(const TriggerEvent& event)
+{
+    if (count_ >= CAPACITY) {
+        return false;
+    }
+    events_[count_++] = event;
+    return true;
+}
+
+void TriggerBuffer::sortByOffset()
+{
+    // Triggers arrive almost sorted (pending first, then step order),
+    // so insertion sort is cheap and keeps equal offsets in order
+    for (uint32_t i = 1; i < count_; ++i) {
+        TriggerEvent event = events_[i];
+        uint32_t j = i;
+        while (j > 0 && events_[j - 1].frameOffset > event.frameOffset) {
+            events_[j] = events_[j - 1];
+            --j;
+        }
+        events_[j] = event;
+    }
+}
+
+bool PendingTriggerQueue::push(uint64_t dueFrame, uint32_t trackIndex, uint32_t velocity,
+                               const StepLocks& locks)
+{
+    if (count_ >= CAPACITY) {
+        dropped_++;
+        return false;
+    }
+    pending_[count_++] = {dueFrame, trackIndex, velocity, locks};
+    return true;
+}
+
+void PendingTriggerQueue::drainDue(uint64_t blockStart, uint32_t numFrames, TriggerBuffer& out)
+{
+    uint64_t blockEnd = blockStart + numFrames;
+    uint32_t kept = 0;
+
+    for (uint32_t i = 0; i < count_; ++i) {
+        const Pending& p = pending_[i];
+        if (p.dueFrame < blockEnd) {
+            // Late triggers (should not happen) fire at the block start
+            uint32_t offset = p.dueFrame > blockStart
+                ? static_cast<uint32_t>(p.dueFrame - blockStart) : 0;
+            out.push({offset, p.trackIndex, p.velocity, p.locks});
+        } else {
+            pending_[kept++] = p;
+        }
+    }
+
+    count_ = kept;
+}
+
+} // namespace DrumMachine
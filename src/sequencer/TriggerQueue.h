@@ -0,0 +1,89 @@
+#ifndef TRIGGER_QUEUE_H
+#define TRIGGER_QUEUE_H
+
+#include "StepLocks.h"
+#include <cstdint>
+#include <array>
+
+namespace DrumMachine {
+
+/**
+ * TriggerEvent
+ *
+ * A sample trigger scheduled inside the current audio block.
+ */
+struct TriggerEvent {
+    uint32_t frameOffset;  // Frame within the block at which the sample starts
+    uint32_t trackIndex;   // Track (sample player) to trigger
+    uint32_t velocity;     // 1-127
+    StepLocks locks;       // The step's parameter locks (empty mask if none)
+};
+
+/**
+ * TriggerBuffer
+ *
+ * Fixed-capacity list of triggers for one audio block.
+ * Preallocated so the audio thread never allocates.
+ */
+class TriggerBuffer {
+public:
+    static constexpr uint32_t CAPACITY = 256;
+
+    TriggerBuffer() : count_(0) {}
+
+    void clear() { count_ = 0; }
+    uint32_t size() const { return count_; }
+    const TriggerEvent& operator[](uint32_t index) const { return events_[index]; }
+
+    // Returns false if the buffer is full (trigger dropped)
+    bool push(const TriggerEvent& event);
+
+    // Sort by frame offset (stable, small N insertion sort)
+    void sortByOffset();
+
+private:
+    std::array<TriggerEvent, CAPACITY> events_;
+    uint32_t count_;
+};
+
+/**
+ * PendingTriggerQueue
+ *
+ * Small preallocated queue of triggers whose start frame lies beyond the
+ * block in which they were scheduled (e.g. swung 16ths that cross a
+ * buffer boundary). Drained at the start of every block.
+ */
+class PendingTriggerQueue {
+public:
+    static constexpr uint32_t CAPACITY = 128;
+
+    PendingTriggerQueue() : count_(0), dropped_(0) {}
+
+    // Queue a trigger due at an absolute frame. Returns false on overflow.
+    bool push(uint64_t dueFrame, uint32_t trackIndex, uint32_t velocity, const StepLocks& locks);
+
+    // Move every trigger due in [blockStart, blockStart + numFrames) into `out`
+    void drainDue(uint64_t blockStart, uint32_t numFrames, TriggerBuffer& out);
+
+    void clear() { count_ = 0; }
+    uint32_t size() const { return count_; }
+
+    // Triggers lost because the queue was full
+    uint32_t getDroppedCount() const { return dropped_; }
+
+private:
+    struct Pending {
+        uint64_t dueFrame;
+        uint32_t trackIndex;
+        uint32_t velocity;
+        StepLocks locks;
+    };
+
+    std::array<Pending, CAPACITY> pending_;
+    uint32_t count_;
+    uint32_t dropped_;
+};
+
+} // namespace DrumMachine
+
+#endif // TRIGGER_QUEUE_H
@@ -74,15 +74,15 @@ void MidiController::render(MidiManager* midiManager)
     ImGui::Text("MIDI Activity:");
     ImGui::Separator();
 
-    // Process messages
-    uint32_t messagesProcessed = midiManager->processMessages();
-    if (messagesProcessed > 0) {
+    // Messages arrive on the MIDI thread; count those since last frame
+    uint32_t messagesReceived = midiManager->takeReceivedCount();
+    if (messagesReceived > 0) {
         auto now = std::chrono::steady_clock::now();
         lastMidiMessageTime_ = std::chrono::duration_cast<std::chrono::milliseconds>(
             now.time_since_epoch()).count();
     }
 
-    ImGui::Text("Messages processed this frame: %u", messagesProcessed);
+    ImGui::Text("Messages received this frame: %u", messagesReceived);
 
     // Display CC values (real-time monitor)
     ImGui::Text("CC Monitor:");
@@ -79,7 +79,7 @@ std::vector<std::string> PatternManager::getAvailablePatterns() const
 }
 
 bool PatternManager::exportToMidi(const std::string& filename, const Pattern& pattern,
-                                  float tempo)
+                                  float tempo, const TempoMap* tempoMap)
 {
     std::string filePath = std::string(getMidiDirectory()) + filename;
     // Check if filename ends with .mid (C++17 compatible)
@@ -88,7 +88,7 @@ bool PatternManager::exportToMidi(const std::string& filename, const Pattern& pa
         filePath.substr(filePath.length() - midExt.length()) != midExt) {
         filePath += ".mid";
     }
-    return midiManager_.exportToMidi(filePath, pattern, tempo);
+    return midiManager_.exportToMidi(filePath, pattern, tempo, 480, tempoMap);
 }
 
 bool PatternManager::importFromMidi(const std::string& filename, Pattern& pattern)
@@ -9,6 +9,7 @@
 namespace DrumMachine {
 
 class Pattern;
+class TempoMap;
 
 /**
  * PatternManager
@@ -28,11 +29,14 @@ public:
 
     // Export pattern to MIDI file
     bool exportToMidi(const std::string& filename, const Pattern& pattern, 
-                      float tempo = 120.0f);
+                      float tempo = 120.0f, const TempoMap* tempoMap = nullptr);
 
     // Import MIDI file to pattern
     bool importFromMidi(const std::string& filename, Pattern& pattern);
 
+    // Note <-> track mapping for MIDI import/export
+    void setKitMap(const KitMap& kitMap) { midiManager_.setKitMap(kitMap); }
+
     // Get list of available JSON patterns
     std::vector<std::string> getAvailablePatterns() const;
 
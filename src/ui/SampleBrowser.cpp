@@ -70,9 +70,9 @@ bool SampleBrowser::loadSampleForTrack(const std::string& filePath, uint32_t tra
         // Publish parameter change
         ParameterChange change;
         change.type = ParameterType::TRACK_SAMPLE;
-        change.value = filePath;
+        change.value = Symbol::intern(filePath);
         change.trackIndex = trackIndex;
-        change.moduleId = "sample_browser";
+        change.moduleId = Symbol::intern("sample_browser");
         ParameterBus::getInstance().publish(change);
 
         std::cout << "Loaded sample for track " << trackIndex << ": " << filePath << std::endl;
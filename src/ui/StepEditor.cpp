@@ -1,14 +1,35 @@
 #include "StepEditor.h"
 #include "../sequencer/Sequencer.h"
 #include "../sequencer/Pattern.h"
+#include "../sequencer/Transport.h"
 #include "../audio/SamplePlayer.h"
+#include "../core/ParameterBus.h"
 #include <imgui.h>
 #include <iostream>
+#include <cstdio>
 
 namespace DrumMachine {
 
+namespace {
+
+// Announce an edit on the bus (journaled for replay)
+void publishEdit(ParameterType type, const ParameterValue& value, uint32_t track, uint32_t step = 0)
+{
+    static const Symbol moduleId = Symbol::intern("step_editor");
+    ParameterChange change;
+    change.type = type;
+    change.value = value;
+    change.trackIndex = track;
+    change.stepIndex = step;
+    change.moduleId = moduleId;
+    ParameterBus::getInstance().publish(change);
+}
+
+} // namespace
+
 StepEditor::StepEditor()
-    : selectedTrack_(0), samplePlayer_(nullptr)
+    : selectedTrack_(0), displayedBar_(0), editTrack_(0), editStep_(NO_STEP),
+      samplePlayer_(nullptr)
 {
     // Initialize all tracks as unmuted
     for (auto& muted : mutedTracks_) {
@@ -74,10 +95,33 @@ void StepEditor::renderStepGrid(Sequencer* sequencer, uint32_t currentStep)
     if (!sequencer) return;
 
     Pattern& pattern = sequencer->getPattern();
+    const Transport& transport = sequencer->getTransport();
+    const Meter meter = transport.getMeter();
+    const uint32_t numSteps = meter.getStepsPerBar();
+    const uint32_t barCount = transport.getBarCount();
+
+    ImGui::Text("Steps (%s)", meter.toString().c_str());
 
-    ImGui::Text("Steps");
+    // Bar pages for multi-bar patterns
+    if (displayedBar_ >= barCount) {
+        displayedBar_ = 0;
+    }
+    if (barCount > 1) {
+        for (uint32_t bar = 0; bar < barCount; ++bar) {
+            ImGui::SameLine();
+            char label[16];
+            std::snprintf(label, sizeof(label), "Bar %u", bar + 1);
+            if (ImGui::Selectable(label, bar == displayedBar_, 0, ImVec2(50, 0))) {
+                displayedBar_ = bar;
+            }
+        }
+    }
     ImGui::Separator();
 
+    // Steps shown on this page, and whether the playhead is on it
+    const uint32_t pageOffset = displayedBar_ * numSteps;
+    const bool playheadOnPage = (transport.getCurrentBar() == displayedBar_);
+
     // Step numbers header with proper alignment
     ImGui::Spacing();
     float buttonSize = 30.0f;
@@ -87,7 +131,7 @@ void StepEditor::renderStepGrid(Sequencer* sequencer, uint32_t currentStep)
     // Header row
     ImGui::Text("Track");
     ImGui::SameLine(labelWidth);
-    for (uint32_t step = 0; step < NUM_STEPS; ++step) {
+    for (uint32_t step = 0; step < numSteps; ++step) {
         ImGui::Text("%d", step);
         ImGui::SameLine(labelWidth + (step + 1) * (buttonSize + spacingX));
     }
@@ -101,19 +145,38 @@ void StepEditor::renderStepGrid(Sequencer* sequencer, uint32_t currentStep)
         ImGui::Text("%s", trackNames_[track]);
         ImGui::SameLine(labelWidth);
 
+        // Polymetric tracks run on their own cycle, so the transport
+        // playhead doesn't apply to them
+        const uint32_t trackLength = pattern.getTrackLength(track);
+        const bool followsPlayhead = pattern.followsPatternLength(track)
+            && pattern.getTrackStepTicks(track) == Pattern::DEFAULT_STEP_TICKS;
+
         // Step buttons for this track
         float xPos = labelWidth;
-        for (uint32_t step = 0; step < NUM_STEPS; ++step) {
-            ImGui::PushID(track * NUM_STEPS + step);
+        for (uint32_t step = 0; step < numSteps; ++step) {
+            ImGui::PushID(track * MAX_STEPS + step);
 
             // Check if this step is enabled
-            bool isEnabled = pattern.isStepActive(track, step);
+            const uint32_t patternStep = pageOffset + step;
+            bool isEnabled = pattern.isStepActive(track, patternStep);
+            const bool inCycle = patternStep < trackLength;
 
             // Visual feedback: different color for current step
-            bool isCurrent = (step == currentStep);
+            bool isCurrent = followsPlayhead && playheadOnPage && (step == currentStep);
             ImVec4 buttonColor = isEnabled ? ImVec4(0.2f, 0.8f, 0.2f, 1.0f)    // Green
                                            : ImVec4(0.3f, 0.3f, 0.3f, 1.0f);   // Dark grey
 
+            // Lighter grey marks the start of each beat group
+            if (!isEnabled && meter.isBeatStart(step)) {
+                buttonColor = ImVec4(0.42f, 0.42f, 0.42f, 1.0f);
+            }
+
+            // Steps past a shorter track cycle never play
+            if (!inCycle) {
+                buttonColor = isEnabled ? ImVec4(0.15f, 0.35f, 0.15f, 1.0f)
+                                        : ImVec4(0.16f, 0.16f, 0.16f, 1.0f);
+            }
+
             if (isCurrent) {
                 buttonColor = isEnabled ? ImVec4(1.0f, 1.0f, 0.0f, 1.0f)      // Yellow
                                         : ImVec4(0.6f, 0.6f, 0.0f, 1.0f);    // Dark yellow
@@ -128,8 +191,9 @@ void StepEditor::renderStepGrid(Sequencer* sequencer, uint32_t currentStep)
             if (ImGui::Button("##step", ImVec2(buttonSize, buttonSize))) {
                 // Toggle step in pattern
                 bool newState = !isEnabled;
-                pattern.setStepActive(track, step, newState);
-                
+                pattern.setStepActive(track, patternStep, newState);
+                publishEdit(ParameterType::STEP_ACTIVE, newState, track, patternStep);
+
                 // Trigger sample preview on pad click (always trigger on click, not just when turning ON)
                 if (samplePlayers_[track]) {
                     samplePlayers_[track]->trigger();
@@ -140,21 +204,157 @@ void StepEditor::renderStepGrid(Sequencer* sequencer, uint32_t currentStep)
 
             ImGui::PopStyleColor(3);
 
-            // Tooltip showing step number
+            // Right click picks the track, and an active step, for editing
+            if (ImGui::IsItemClicked(1)) {
+                editTrack_ = track;
+                editStep_ = isEnabled ? patternStep : NO_STEP;
+            }
+
+            // Tooltip showing step number and velocity
             if (ImGui::IsItemHovered()) {
-                ImGui::SetTooltip("Track %d, Step %d", track, step);
+                if (isEnabled) {
+                    ImGui::SetTooltip("Track %d, Step %d (vel %d)", track, step,
+                                      pattern.getStepData(track, patternStep).velocity);
+                } else {
+                    ImGui::SetTooltip("Track %d, Step %d", track, step);
+                }
             }
 
             ImGui::PopID();
             xPos += buttonSize + spacingX;
 
-            if (step < NUM_STEPS - 1) {
+            if (step < numSteps - 1) {
                 ImGui::SameLine();
             }
         }
+
+        // Track density (active steps / pattern length)
+        ImGui::SameLine();
+        ImGui::Text("%3.0f%%", pattern.getTrackDensity(track) * 100.0f);
     }
 
     ImGui::PopButtonRepeat();
+
+    renderStepProperties(sequencer);
+}
+
+void StepEditor::renderStepProperties(Sequencer* sequencer)
+{
+    Pattern& pattern = sequencer->getPattern();
+    renderTrackSettings(pattern);
+
+    if (editStep_ == NO_STEP || !pattern.isStepActive(editTrack_, editStep_)) {
+        editStep_ = NO_STEP;
+        ImGui::TextDisabled("Right-click an active step to edit velocity, probability and timing");
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%s, step %u", trackNames_[editTrack_], editStep_ + 1);
+
+    StepData data = pattern.getStepData(editTrack_, editStep_);
+    int velocity = data.velocity;
+    int probability = data.probability;
+    int microtiming = data.microtiming;
+    int ratchets = data.ratchetCount;
+    int ratchetRate = data.ratchetRate;
+
+    bool changed = false;
+    changed |= ImGui::SliderInt("Velocity", &velocity, 1, 127);
+    changed |= ImGui::SliderInt("Probability (%)", &probability, 0, 100);
+    changed |= ImGui::SliderInt("Microtiming (ticks)", &microtiming,
+                                -StepData::MAX_MICROTIMING, StepData::MAX_MICROTIMING);
+    changed |= ImGui::SliderInt("Ratchets", &ratchets, 1, StepData::MAX_RATCHETS);
+    changed |= ImGui::SliderInt("Ratchet Rate (per step)", &ratchetRate, 1, 8);
+
+    if (changed) {
+        data.velocity = static_cast<uint8_t>(velocity);
+        data.probability = static_cast<uint8_t>(probability);
+        data.microtiming = static_cast<int8_t>(microtiming);
+        data.ratchetCount = static_cast<uint8_t>(ratchets);
+        data.ratchetRate = static_cast<uint8_t>(ratchetRate);
+        pattern.setStepData(editTrack_, editStep_, data);
+        publishEdit(ParameterType::STEP_DATA, data.pack(), editTrack_, editStep_);
+    }
+
+    renderStepLocks(pattern);
+}
+
+void StepEditor::renderStepLocks(Pattern& pattern)
+{
+    ImGui::Separator();
+    ImGui::Text("Parameter locks");
+
+    StepLocks locks = pattern.getStepLocks(editTrack_, editStep_);
+    int volume = locks.volume;
+    int pan = locks.pan;
+    int pitch = locks.pitch;
+    int decay = locks.decay;
+    int sampleStart = locks.sampleStart;
+
+    // A checkbox locks the parameter; its slider sets the locked value
+    bool changed = false;
+    auto lockSlider = [&](const char* label, uint8_t bit, int* value, int min, int max) {
+        bool locked = locks.has(bit);
+        ImGui::PushID(label);
+        if (ImGui::Checkbox("##lock", &locked)) {
+            locks.mask = locked ? (locks.mask | bit) : (locks.mask & ~bit);
+            changed = true;
+        }
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!locked);
+        changed |= ImGui::SliderInt(label, value, min, max);
+        ImGui::EndDisabled();
+        ImGui::PopID();
+    };
+    lockSlider("Volume", StepLocks::VOLUME, &volume, 0, 127);
+    lockSlider("Pan", StepLocks::PAN, &pan, -64, 63);
+    lockSlider("Pitch (semitones)", StepLocks::PITCH, &pitch, -StepLocks::MAX_PITCH, StepLocks::MAX_PITCH);
+    lockSlider("Decay", StepLocks::DECAY, &decay, 0, 127);
+    lockSlider("Sample Start", StepLocks::SAMPLE_START, &sampleStart, 0, 127);
+
+    if (changed) {
+        locks.volume = static_cast<uint8_t>(volume);
+        locks.pan = static_cast<int8_t>(pan);
+        locks.pitch = static_cast<int8_t>(pitch);
+        locks.decay = static_cast<uint8_t>(decay);
+        locks.sampleStart = static_cast<uint8_t>(sampleStart);
+        pattern.setStepLocks(editTrack_, editStep_, locks);
+        publishEdit(ParameterType::STEP_LOCKS, locks.pack(), editTrack_, editStep_);
+    }
+}
+
+void StepEditor::renderTrackSettings(Pattern& pattern)
+{
+    // Track rates as clock ticks per step (960 PPQN)
+    static const uint32_t rateTicks[] = {480, 320, 240, 160, 120, 60};
+    static const char* rateNames[] = {"1/8", "1/8T", "1/16", "1/16T", "1/32", "1/64"};
+    static_assert(IM_ARRAYSIZE(rateTicks) == IM_ARRAYSIZE(rateNames), "One name per rate");
+
+    ImGui::Separator();
+    ImGui::Text("%s track", trackNames_[editTrack_]);
+
+    // 0 follows the pattern length; anything else loops polymetrically
+    int length = pattern.followsPatternLength(editTrack_) ? 0 : static_cast<int>(pattern.getTrackLength(editTrack_));
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::SliderInt("Length (0 = pattern)", &length, 0, static_cast<int>(pattern.getLength()))) {
+        pattern.setTrackLength(editTrack_, static_cast<uint32_t>(length));
+        publishEdit(ParameterType::TRACK_LENGTH, static_cast<uint32_t>(length), editTrack_);
+    }
+
+    int rateIndex = -1;  // Rates loaded from a file may not be listed
+    for (int i = 0; i < IM_ARRAYSIZE(rateTicks); ++i) {
+        if (rateTicks[i] == pattern.getTrackStepTicks(editTrack_)) {
+            rateIndex = i;
+        }
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::Combo("Rate", &rateIndex, rateNames, IM_ARRAYSIZE(rateNames)) && rateIndex >= 0) {
+        pattern.setTrackStepTicks(editTrack_, rateTicks[rateIndex]);
+        publishEdit(ParameterType::TRACK_STEP_TICKS, rateTicks[rateIndex], editTrack_);
+    }
 }
 
 bool StepEditor::loadSampleForTrack(uint32_t track, const std::string& filePath)
@@ -172,6 +372,7 @@ bool StepEditor::loadSampleForTrack(uint32_t track, const std::string& filePath)
     // Load the sample into the track's sample player
     if (samplePlayers_[track]->loadSample(filePath)) {
         trackSamplePaths_[track] = filePath;
+        publishEdit(ParameterType::TRACK_SAMPLE, Symbol::intern(filePath), track);
         std::cout << "[SAMPLE_LOAD] Track " << track << " loaded: " << filePath 
                   << " (" << samplePlayers_[track]->getDurationSeconds() << "s)" << std::endl;
         return true;
@@ -9,14 +9,16 @@ namespace DrumMachine {
 
 class Sequencer;
 class SamplePlayer;
+class Pattern;
 
 /**
  * StepEditor
  * 
- * Immediate-mode UI for 16-step drum pattern editor.
- * Displays 8 drum tracks with 16 steps each.
+ * Immediate-mode UI for the drum pattern step editor.
+ * Displays 8 drum tracks with one bar of steps each (16 in 4/4,
+ * following the transport's time signature).
  * - Left panel: track controls (mute, solo, labels)
- * - Center: 16-step grid (click to toggle)
+ * - Center: 16-step grid (click to toggle, right-click to edit step)
  * - Visual feedback: playhead position, active steps
  */
 class StepEditor {
@@ -49,9 +51,13 @@ public:
 
 private:
     static constexpr uint32_t NUM_TRACKS = 8;
-    static constexpr uint32_t NUM_STEPS = 16;
+    static constexpr uint32_t MAX_STEPS = 32;  // Longest bar (Meter::MAX_STEPS_PER_BAR)
+    static constexpr uint32_t NO_STEP = UINT32_MAX;
 
     uint32_t selectedTrack_;
+    uint32_t displayedBar_;  // Bar page shown in the grid (multi-bar patterns)
+    uint32_t editTrack_;     // Step whose parameters are being edited
+    uint32_t editStep_;      // (pattern step; NO_STEP when none)
     std::array<bool, NUM_TRACKS> mutedTracks_;
     std::array<std::string, NUM_TRACKS> trackSamplePaths_;  // Sample path for each track
     SamplePlayer* samplePlayer_;  // For triggering samples on pad clicks
@@ -74,6 +80,16 @@ private:
 
     // Render center grid
     void renderStepGrid(Sequencer* sequencer, uint32_t currentStep);
+
+    // Render velocity/probability/microtiming/ratchet controls for the
+    // step picked with a right click
+    void renderStepProperties(Sequencer* sequencer);
+
+    // Render the picked track's polymetric length and rate
+    void renderTrackSettings(Pattern& pattern);
+
+    // Render the picked step's parameter locks
+    void renderStepLocks(Pattern& pattern);
 };
 
 } // namespace DrumMachine
@@ -13,16 +13,12 @@ float SwingVisualizer::calculateStepOffset(Sequencer* sequencer, uint32_t stepIn
 {
     if (!sequencer) return 0.0f;
 
-    Transport& transport = sequencer->getTransport();
-    
-    // Swing applies to even-numbered steps (1, 3, 5, etc. in 0-based indexing)
-    if (stepIndex % 2 == 1) {
-        float swingAmount = transport.getSwing();
-        // swingAmount is 0.0 to 0.6, scale to percentage offset (0-60% of step)
-        return swingAmount * 100.0f;
-    }
+    // Use the exact delay the scheduler applies, as a percentage of one step
+    double samplesPerStep = sequencer->getTransport().getSamplesPerStep();
+    if (samplesPerStep <= 0.0) return 0.0f;
 
-    return 0.0f;
+    uint32_t delayFrames = sequencer->getSwingDelayFrames(stepIndex);
+    return static_cast<float>(delayFrames / samplesPerStep * 100.0);
 }
 
 void SwingVisualizer::render(Sequencer* sequencer)
@@ -39,7 +35,8 @@ void SwingVisualizer::render(Sequencer* sequencer)
         ImGui::Spacing();
         ImGui::Separator();
 
-        // Draw timeline of 16 steps with swing offsets
+        // Draw timeline of one bar of steps with swing offsets
+        const uint32_t numSteps = transport.getActiveStepsPerBar();
         ImGui::Text("Step Timing Offsets:");
         ImGui::Spacing();
 
@@ -52,7 +49,7 @@ void SwingVisualizer::render(Sequencer* sequencer)
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         
         // Draw step boxes and offsets
-        for (uint32_t i = 0; i < 16; ++i) {
+        for (uint32_t i = 0; i < numSteps; ++i) {
             float xPos = cursorPos.x + (i * stepWidth);
             float yPos = cursorPos.y;
 
@@ -73,7 +70,7 @@ void SwingVisualizer::render(Sequencer* sequencer)
         }
 
         // Add spacing for text below
-        ImGui::Dummy(ImVec2(stepWidth * 16.0f, stepHeight + 5.0f));
+        ImGui::Dummy(ImVec2(stepWidth * numSteps, stepHeight + 5.0f));
 
         ImGui::Spacing();
         ImGui::Separator();
@@ -85,7 +82,7 @@ void SwingVisualizer::render(Sequencer* sequencer)
         cursorPos = ImGui::GetCursorScreenPos();
 
         // Draw horizontal timeline with step offsets
-        for (uint32_t i = 0; i < 16; ++i) {
+        for (uint32_t i = 0; i < numSteps; ++i) {
             float offsetPercent = calculateStepOffset(sequencer, i);
             float xPos = cursorPos.x + (i * stepWidth);
             float yPos = cursorPos.y;
@@ -109,7 +106,7 @@ void SwingVisualizer::render(Sequencer* sequencer)
         }
 
         // Add spacing for labels below
-        ImGui::Dummy(ImVec2(stepWidth * 16.0f, barHeight + 30.0f));
+        ImGui::Dummy(ImVec2(stepWidth * numSteps, barHeight + 30.0f));
 
         ImGui::Spacing();
         ImGui::Separator();
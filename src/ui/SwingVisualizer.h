@@ -22,7 +22,8 @@ public:
     void render(Sequencer* sequencer);
 
 private:
-    // Helper to calculate swing delay for a given step
+    // Swing delay for a step as a percentage of the step length,
+    // read from the sequencer's scheduler
     float calculateStepOffset(Sequencer* sequencer, uint32_t stepIndex);
 };
 
@@ -3,14 +3,19 @@
 #include "PatternManager.h"
 #include "../audio/AudioEngine.h"
 #include "../audio/MidiManager.h"
+#include "../audio/MidiOutput.h"
 #include "../audio/SamplePlayer.h"
 #include "../sequencer/Sequencer.h"
+#include "../core/ParameterBus.h"
 #include <SDL2/SDL.h>
 #include <imgui.h>
 #include <backends/imgui_impl_sdl2.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <iostream>
 #include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
 
 // OpenGL functions
 #ifdef _WIN32
@@ -23,10 +28,32 @@ extern "C" {
 
 namespace DrumMachine {
 
+namespace {
+
+// Announce an edit on the bus (journaled for replay)
+void publishEdit(ParameterType type, const ParameterValue& value)
+{
+    static const Symbol moduleId = Symbol::intern("ui");
+    ParameterChange change;
+    change.type = type;
+    change.value = value;
+    change.moduleId = moduleId;
+    ParameterBus::getInstance().publish(change);
+}
+
+// Announce an edit the bus can't carry, so a replay knows it diverges
+void publishOpaqueEdit(const char* name)
+{
+    publishEdit(ParameterType::OPAQUE_EDIT, Symbol::intern(name));
+}
+
+} // namespace
+
 Window::Window(uint32_t width, uint32_t height)
     : width_(width), height_(height), isOpen_(true),
       sdlWindow_(nullptr), glContext_(nullptr),
-      audioEngine_(nullptr), sequencer_(nullptr), midiManager_(nullptr), samplePlayer_(nullptr),
+      audioEngine_(nullptr), sequencer_(nullptr), midiManager_(nullptr), midiOutput_(nullptr),
+      samplePlayer_(nullptr),
       currentStep_(0), showSampleBrowser_(false), selectedTrackForSample_(0)
 {
     stepEditor_ = std::make_unique<StepEditor>();
@@ -40,6 +67,11 @@ Window::~Window()
     shutdown();
 }
 
+void Window::setKitMap(const KitMap& kitMap)
+{
+    patternManager_->setKitMap(kitMap);
+}
+
 void Window::setSamplePlayer(SamplePlayer* samplePlayer)
 {
     samplePlayer_ = samplePlayer;
@@ -112,6 +144,9 @@ bool Window::initialize()
     ImGui_ImplSDL2_InitForOpenGL(reinterpret_cast<SDL_Window*>(sdlWindow_), glContext_);
     ImGui_ImplOpenGL3_Init("#version 150");
 
+    // The UI dispatches once a frame and only needs each knob's last value
+    ParameterBus::getInstance().setCoalescing(true);
+
     std::cout << "Window initialized successfully" << std::endl;
     return true;
 }
@@ -149,6 +184,16 @@ void Window::handleEvents()
             case SDL_KEYDOWN:
                 if (event.key.keysym.sym == SDLK_ESCAPE) {
                     isOpen_ = false;
+                } else if (sequencer_ && (event.key.keysym.mod & KMOD_CTRL)) {
+                    if (event.key.keysym.sym == SDLK_z) {
+                        if (sequencer_->undo()) {
+                            publishOpaqueEdit("undo");
+                        }
+                    } else if (event.key.keysym.sym == SDLK_y) {
+                        if (sequencer_->redo()) {
+                            publishOpaqueEdit("redo");
+                        }
+                    }
                 }
                 break;
             default:
@@ -186,12 +231,25 @@ void Window::renderUI()
             }
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("Edit")) {
+            if (ImGui::MenuItem("Undo", "Ctrl+Z", false, sequencer_ && sequencer_->canUndo())) {
+                if (sequencer_->undo()) {
+                    publishOpaqueEdit("undo");
+                }
+            }
+            if (ImGui::MenuItem("Redo", "Ctrl+Y", false, sequencer_ && sequencer_->canRedo())) {
+                if (sequencer_->redo()) {
+                    publishOpaqueEdit("redo");
+                }
+            }
+            ImGui::EndMenu();
+        }
         ImGui::EndMainMenuBar();
     }
 
     // Transport window - tempo and swing controls
     ImGui::SetNextWindowPos(ImVec2(10, 30), ImGuiCond_FirstUseEver);
-    ImGui::SetNextWindowSize(ImVec2(340, 140), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(340, 180), ImGuiCond_FirstUseEver);
     ImGui::SetNextWindowBgAlpha(0.95f);
     
     if (ImGui::Begin("Transport")) {
@@ -204,40 +262,210 @@ void Window::renderUI()
             if (sequencer_->getTransport().getPlayState() == Transport::PlayState::Playing) {
                 if (ImGui::Button("Stop##audio", ImVec2(60, 0))) {
                     sequencer_->getTransport().stop();
+                    publishEdit(ParameterType::PLAY_STATE, false);
                 }
             } else {
                 if (ImGui::Button("Play##audio", ImVec2(60, 0))) {
                     sequencer_->getTransport().play();
+                    publishEdit(ParameterType::PLAY_STATE, true);
                 }
             }
             ImGui::SameLine();
             ImGui::Text("%s", sequencer_->getTransport().getPlayState() == Transport::PlayState::Playing ? "Playing" : "Stopped");
+
+            // Live recording from MIDI input into the playing pattern
+            LiveRecorder& recorder = sequencer_->getRecorder();
+            bool armed = recorder.isArmed();
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Rec", &armed)) {
+                recorder.setArmed(armed);
+                if (armed) {
+                    publishOpaqueEdit("live recording");
+                }
+            }
+            bool quantize = recorder.isQuantize();
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Quantize", &quantize)) {
+                recorder.setQuantize(quantize);
+            }
+            int inputLatencyMs = static_cast<int>(recorder.getInputLatencyMicros() / 1000);
+            ImGui::SetNextItemWidth(120);
+            if (ImGui::SliderInt("MIDI Input Latency (ms)", &inputLatencyMs, 0, 50)) {
+                recorder.setInputLatencyMicros(static_cast<uint32_t>(inputLatencyMs) * 1000);
+            }
+
+            // MIDI clock: follow an external master, or send our own
+            MidiClockSync& clockSync = sequencer_->getClockSync();
+            bool followClock = clockSync.isEnabled();
+            if (ImGui::Checkbox("Sync to MIDI Clock", &followClock)) {
+                clockSync.setEnabled(followClock);
+                if (followClock) {
+                    publishOpaqueEdit("MIDI clock sync");
+                }
+            }
+            if (followClock) {
+                ImGui::SameLine();
+                if (clockSync.isLocked()) {
+                    ImGui::Text("Locked %.2f BPM", clockSync.getMasterTempo());
+                } else {
+                    ImGui::TextDisabled("Waiting for clock");
+                }
+            }
+
+            bool sendClock = sequencer_->isClockOutput();
+            if (ImGui::Checkbox("Send MIDI Clock", &sendClock)) {
+                sequencer_->setClockOutput(sendClock);
+            }
+            bool sendNotes = sequencer_->isNoteOutput();
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Send MIDI Notes", &sendNotes)) {
+                sequencer_->setNoteOutput(sendNotes);
+            }
+            if (midiOutput_) {
+                const std::string& openName = midiOutput_->getOpenPortName();
+                const int openPort = midiOutput_->getOpenPort();
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(200);
+                if (ImGui::BeginCombo("MIDI Out", openName.empty() ? "(none)" : openName.c_str())) {
+                    std::vector<std::string> ports = midiOutput_->getOutputPorts();
+                    for (size_t i = 0; i < ports.size(); ++i) {
+                        if (ImGui::Selectable(ports[i].c_str(), static_cast<int>(i) == openPort)) {
+                            midiOutput_->openPort(static_cast<uint32_t>(i));
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+            }
         }
 
         ImGui::Separator();
 
-        ImGui::SliderFloat("Tempo (BPM)", &tempo, 60.0f, 180.0f);
-        ImGui::SliderFloat("Swing (%)", &swing, 0.0f, 0.6f, "%.2f");
+        // Song mode and pattern switches change these from the audio
+        // thread, so show the transport's values rather than our own copy
+        static const char* meterNames[] = {"4/4", "3/4", "6/8", "5/4", "7/8"};
+        static int meterIndex = 0;
+        static int barCount = 1;
+        if (sequencer_) {
+            const Transport& transport = sequencer_->getTransport();
+            tempo = transport.getTempo();
+            swing = transport.getSwing();
+            barCount = static_cast<int>(transport.getBarCount());
+            std::string timeSig = transport.getTimeSignature();
+            for (int i = 0; i < IM_ARRAYSIZE(meterNames); ++i) {
+                if (timeSig == meterNames[i]) {
+                    meterIndex = i;
+                }
+            }
+        }
+
+        bool tempoChanged = ImGui::DragFloat("Tempo (BPM)", &tempo, 0.5f, MusicalClock::MIN_BPM,
+                                             MusicalClock::MAX_BPM, "%.1f");
+        bool swingChanged = ImGui::SliderFloat("Swing (%)", &swing, 0.0f, 0.6f, "%.2f");
         ImGui::SliderFloat("Master Volume", &masterVolume, 0.0f, 1.5f, "%.2f");
 
+        // Time signature: parsed here on the UI thread, handed to the
+        // audio thread as a packed Meter
+        bool meterChanged = ImGui::Combo("Time Signature", &meterIndex, meterNames, IM_ARRAYSIZE(meterNames));
+        bool barsChanged = ImGui::SliderInt("Bars", &barCount, 1, static_cast<int>(Pattern::MAX_BARS));
+
         if (sequencer_) {
-            sequencer_->getTransport().setTempo(tempo);
-            sequencer_->getTransport().setSwing(swing);
+            if (tempoChanged) {
+                sequencer_->getTransport().setTempo(tempo);
+                publishEdit(ParameterType::TEMPO, tempo);
+            }
+            if (swingChanged) {
+                sequencer_->getTransport().setSwing(swing);
+                publishEdit(ParameterType::SWING, swing);
+            }
+
+            // Meter and bar count also resize the pattern
+            if (meterChanged) {
+                Meter meter;
+                if (Meter::parse(meterNames[meterIndex], meter)) {
+                    sequencer_->setMeter(meter);
+                    publishEdit(ParameterType::TIME_SIGNATURE, static_cast<uint32_t>(meter.pack()));
+                }
+            }
+            if (barsChanged) {
+                sequencer_->setBarCount(static_cast<uint32_t>(barCount));
+                publishEdit(ParameterType::BAR_COUNT, static_cast<uint32_t>(barCount));
+            }
+        }
+
+        // Tempo automation: breakpoints placed by bar, with ramp shapes
+        if (sequencer_ && ImGui::CollapsingHeader("Tempo Automation")) {
+            Transport& transport = sequencer_->getTransport();
+            bool automationEnabled = transport.isTempoMapEnabled();
+            if (ImGui::Checkbox("Enabled##tempomap", &automationEnabled)) {
+                transport.setTempoMapEnabled(automationEnabled);
+                publishEdit(ParameterType::TEMPO_MAP_ENABLED, automationEnabled);
+            }
+
+            static const char* shapeNames[] = {"Step", "Linear", "Curve"};
+            TempoMap& tempoMap = transport.getTempoMap();
+            const double ticksPerBar = transport.getMeter().getTicksPerBar();
+
+            for (uint32_t i = 0; i < tempoMap.getPointCount(); ++i) {
+                TempoPoint point = tempoMap.getPoint(i);
+                bool changed = false;
+                ImGui::PushID(static_cast<int>(i));
+
+                float bar = static_cast<float>(point.tick / ticksPerBar) + 1.0f;
+                ImGui::SetNextItemWidth(60);
+                if (ImGui::InputFloat("Bar", &bar, 0.0f, 0.0f, "%.2f")) {
+                    point.tick = static_cast<uint64_t>(std::llround(std::max(bar - 1.0f, 0.0f) * ticksPerBar));
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(60);
+                changed |= ImGui::InputFloat("BPM", &point.bpm, 0.0f, 0.0f, "%.1f");
+
+                ImGui::SameLine();
+                int shape = static_cast<int>(point.shape);
+                ImGui::SetNextItemWidth(70);
+                if (ImGui::Combo("Ramp", &shape, shapeNames, IM_ARRAYSIZE(shapeNames))) {
+                    point.shape = static_cast<TempoPoint::Shape>(shape);
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                bool removed = ImGui::Button("X");
+                ImGui::PopID();
+
+                if (removed) {
+                    tempoMap.removePoint(i);
+                    publishOpaqueEdit("tempo map");
+                    break;
+                }
+                if (changed) {
+                    tempoMap.setPoint(i, point);
+                    publishOpaqueEdit("tempo map");
+                }
+            }
+
+            if (ImGui::Button("Add Tempo Point")) {
+                TempoPoint point;
+                point.bpm = transport.getTempo();
+                if (!tempoMap.isEmpty()) {
+                    const TempoPoint& last = tempoMap.getPoint(tempoMap.getPointCount() - 1);
+                    point.tick = last.tick + static_cast<uint64_t>(ticksPerBar);
+                    point.bpm = last.bpm;
+                }
+                tempoMap.addPoint(point);
+                publishOpaqueEdit("tempo map");
+            }
         }
 
         // Calculate and display current step
         if (audioEngine_ && sequencer_) {
             // Only advance step if transport is playing
             if (sequencer_->getTransport().getPlayState() == Transport::PlayState::Playing) {
-                uint64_t frameCount = audioEngine_->getTotalFramesProcessed();
-                uint32_t sampleRate = audioEngine_->getSampleRate();
-                float currentTempo = sequencer_->getTransport().getTempo();
-                uint64_t samplesPerBeat = (sampleRate * 60) / static_cast<uint32_t>(currentTempo);
-                uint64_t samplesPerStep = samplesPerBeat / 4;
-                if (samplesPerStep > 0) {
-                    currentStep_ = (frameCount / samplesPerStep) % 16;
-                }
-                ImGui::Text("Step: %u / 15", currentStep_);
+                // Read the playhead from the transport clock so the UI never
+                // drifts away from what the audio thread is playing
+                currentStep_ = sequencer_->getTransport().getCurrentStep();
+                ImGui::Text("Bar: %u  Step: %u / %u", sequencer_->getTransport().getCurrentBar() + 1,
+                            currentStep_, sequencer_->getTransport().getActiveStepsPerBar() - 1);
             } else {
                 ImGui::Text("Step: stopped");
             }
@@ -246,6 +474,132 @@ void Window::renderUI()
         ImGui::End();
     }
 
+    // Song window - pattern bank and song chain
+    ImGui::SetNextWindowPos(ImVec2(10, 670), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(620, 200), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.95f);
+
+    if (ImGui::Begin("Song")) {
+        if (sequencer_) {
+            // Pattern bank: selecting a slot edits it and, outside song
+            // mode, queues it to play from the next loop
+            ImGui::Text("Pattern:");
+            for (uint32_t slot = 0; slot < Sequencer::NUM_PATTERN_SLOTS; ++slot) {
+                ImGui::SameLine();
+                char label[16];
+                std::snprintf(label, sizeof(label), "%u##slot", slot + 1);
+                if (ImGui::Selectable(label, slot == sequencer_->getSelectedSlot(), 0, ImVec2(20, 0))) {
+                    sequencer_->selectPattern(slot);
+                    publishEdit(ParameterType::PATTERN_SLOT, slot);
+                }
+            }
+            ImGui::SameLine();
+            ImGui::Text("  Playing: %u", sequencer_->getPlayingSlot() + 1);
+
+            bool songMode = sequencer_->isSongMode();
+            if (ImGui::Checkbox("Song Mode", &songMode)) {
+                sequencer_->setSongMode(songMode);
+                publishOpaqueEdit("song mode");
+            }
+
+            // Extra lanes layer other slots over the main pattern
+            static const char* laneSlotNames[] = {"Off", "1", "2", "3", "4", "5", "6", "7", "8"};
+            static_assert(IM_ARRAYSIZE(laneSlotNames) == Sequencer::NUM_PATTERN_SLOTS + 1, "One name per slot");
+            for (uint32_t lane = 1; lane < Sequencer::NUM_LANES; ++lane) {
+                uint32_t laneSlot = sequencer_->getLanePattern(lane);
+                int laneIndex = laneSlot == Sequencer::NO_SLOT ? 0 : static_cast<int>(laneSlot) + 1;
+
+                char label[16];
+                std::snprintf(label, sizeof(label), "Lane %u", lane + 1);
+                if (lane > 1) {
+                    ImGui::SameLine();
+                }
+                ImGui::SetNextItemWidth(60);
+                if (ImGui::Combo(label, &laneIndex, laneSlotNames, IM_ARRAYSIZE(laneSlotNames))) {
+                    sequencer_->setLanePattern(lane, laneIndex == 0 ? Sequencer::NO_SLOT
+                                                                    : static_cast<uint32_t>(laneIndex - 1));
+                    publishOpaqueEdit("lanes");
+                }
+            }
+
+            ImGui::Separator();
+
+            // Chain entries: pattern, repeats, optional tempo and meter change
+            static const char* entryMeterNames[] = {"Keep", "4/4", "3/4", "6/8", "5/4", "7/8"};
+            Song& song = sequencer_->getSong();
+            for (uint32_t i = 0; i < song.getEntryCount(); ++i) {
+                SongEntry entry = song.getEntry(i);
+                bool changed = false;
+
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::Text("%s%2u", sequencer_->getSongPosition() == i ? ">" : " ", i + 1);
+
+                ImGui::SameLine();
+                int slot = static_cast<int>(entry.patternSlot) + 1;
+                ImGui::SetNextItemWidth(80);
+                if (ImGui::SliderInt("Pattern", &slot, 1, static_cast<int>(Sequencer::NUM_PATTERN_SLOTS))) {
+                    entry.patternSlot = static_cast<uint32_t>(slot - 1);
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                int repeats = static_cast<int>(entry.repeats);
+                ImGui::SetNextItemWidth(80);
+                if (ImGui::InputInt("x", &repeats)) {
+                    entry.repeats = static_cast<uint32_t>(std::clamp(repeats, 1, 64));
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(70);
+                if (ImGui::InputFloat("BPM", &entry.tempo, 0.0f, 0.0f, "%.1f")) {
+                    entry.tempo = entry.tempo > 0.0f
+                        ? std::clamp(entry.tempo, MusicalClock::MIN_BPM, MusicalClock::MAX_BPM) : 0.0f;
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                int entryMeter = 0;
+                if (entry.changesMeter) {
+                    std::string timeSig = entry.meter.toString();
+                    for (int m = 1; m < IM_ARRAYSIZE(entryMeterNames); ++m) {
+                        if (timeSig == entryMeterNames[m]) {
+                            entryMeter = m;
+                        }
+                    }
+                }
+                ImGui::SetNextItemWidth(70);
+                if (ImGui::Combo("Meter", &entryMeter, entryMeterNames, IM_ARRAYSIZE(entryMeterNames))) {
+                    entry.changesMeter = entryMeter > 0 && Meter::parse(entryMeterNames[entryMeter], entry.meter);
+                    changed = true;
+                }
+
+                ImGui::SameLine();
+                bool removed = ImGui::Button("X");
+                ImGui::PopID();
+
+                if (removed) {
+                    song.removeEntry(i);
+                    publishOpaqueEdit("song chain");
+                    break;
+                }
+                if (changed) {
+                    song.setEntry(i, entry);
+                    publishOpaqueEdit("song chain");
+                }
+            }
+
+            if (ImGui::Button("Add Pattern to Song")) {
+                SongEntry entry;
+                entry.patternSlot = sequencer_->getSelectedSlot();
+                song.addEntry(entry);
+                publishOpaqueEdit("song chain");
+            }
+        }
+
+        ImGui::End();
+    }
+
     // Step Editor window - main grid (moved 20% right to show track names)
     ImGui::SetNextWindowPos(ImVec2(256, 180), ImGuiCond_FirstUseEver);  // 1280 * 0.2 = 256
     ImGui::SetNextWindowSize(ImVec2(1000, 480), ImGuiCond_FirstUseEver);
@@ -364,6 +718,14 @@ bool Window::processFrame()
     renderUI();
     renderFrame();
 
+    // Deliver parameter changes published from any thread since last frame
+    ParameterBus::getInstance().dispatch();
+
+    // Hand this frame's pattern edits to the audio thread
+    if (sequencer_) {
+        sequencer_->publishPendingEdits();
+    }
+
     // Frame rate limiting
     static uint32_t lastFrameTime = SDL_GetTicks();
     uint32_t currentTime = SDL_GetTicks();
@@ -14,7 +14,9 @@ class Sequencer;
 class StepEditor;
 class PatternManager;
 class MidiManager;
+class MidiOutput;
 class SamplePlayer;
+class KitMap;
 
 /**
  * Window
@@ -43,6 +45,10 @@ public:
     void setAudioEngine(AudioEngine* audioEngine) { audioEngine_ = audioEngine; }
     void setSequencer(Sequencer* sequencer) { sequencer_ = sequencer; }
     void setMidiManager(MidiManager* midiManager) { midiManager_ = midiManager; }
+    void setMidiOutput(MidiOutput* midiOutput) { midiOutput_ = midiOutput; }
+
+    // Note <-> track mapping for MIDI file import/export
+    void setKitMap(const KitMap& kitMap);
     void setSamplePlayer(SamplePlayer* samplePlayer);
     
     // Set all 8 sample players for pad preview/triggering
@@ -63,6 +69,7 @@ private:
     AudioEngine* audioEngine_;
     Sequencer* sequencer_;
     MidiManager* midiManager_;
+    MidiOutput* midiOutput_;
     SamplePlayer* samplePlayer_;
 
     // UI components